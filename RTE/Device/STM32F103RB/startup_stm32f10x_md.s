@@ -27,7 +27,10 @@
 ;*******************************************************************************
 
 ; Amount of memory (in bytes) allocated for Stack
-; Tailor this value to your application needs
+; Left at the default 0x400 until tools/mem_report.py reports a measured worst
+; case for a real build (static call graph: main + one interrupt level + NMI);
+; the stack is painted with STACK_PAINT at reset and the high-water mark is
+; read by stack.c
 ; <h> Stack Configuration
 ;   <o> Stack Size (in Bytes) <0x0-0xFFFFFFFF:8>
 ; </h>
@@ -35,15 +38,19 @@
 Stack_Size      EQU     0x00000400
 
                 AREA    STACK, NOINIT, READWRITE, ALIGN=3
+                EXPORT  Stack_Mem
+                EXPORT  __initial_sp
 Stack_Mem       SPACE   Stack_Size
 __initial_sp
 
 
+; The application does not use the heap (no malloc, no stdio); the memory
+; is given to the console transmit buffers
 ; <h> Heap Configuration
 ;   <o>  Heap Size (in Bytes) <0x0-0xFFFFFFFF:8>
 ; </h>
 
-Heap_Size       EQU     0x00000200
+Heap_Size       EQU     0x00000000
 
                 AREA    HEAP, NOINIT, READWRITE, ALIGN=3
 __heap_base
@@ -132,6 +139,15 @@ Reset_Handler    PROC
                  EXPORT  Reset_Handler             [WEAK]
      IMPORT  __main
      IMPORT  SystemInit
+                 LDR     R0, =Stack_Mem            ; Paint the whole stack (nothing is pushed yet)
+                 LDR     R1, =__initial_sp
+                 LDR     R2, =0xDEADBEEF           ; STACK_PAINT in stack.h
+Stack_Paint
+                 CMP     R0, R1
+                 BHS     Stack_Painted
+                 STR     R2, [R0], #4
+                 B       Stack_Paint
+Stack_Painted
                  LDR     R0, =SystemInit
                  BLX     R0
                  LDR     R0, =__main
@@ -283,7 +299,6 @@ USBWakeUp_IRQHandler
 ;*******************************************************************************
                  IF      :DEF:__MICROLIB           
                 
-                 EXPORT  __initial_sp
                  EXPORT  __heap_base
                  EXPORT  __heap_limit
                 
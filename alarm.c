@@ -0,0 +1,162 @@
+#include "alarm.h"
+#include "metrics.h"
+
+/*
+*	Обработчик сигнала тревоги: откладывание, усиление и автоматическое завершение
+*	Все функции вызываются из обработчика прерывания таймера (раз в секунду и ALARM_PHASES раз в секунду),
+*	из основного цикла - только alarmStart, alarmSnooze, alarmDismiss (внутри критической секции)
+*/
+
+typedef struct alarm_stage_tag{	// Ступень усиления сигнала
+	uint8_t pattern;			// Рисунок сигнала за секунду (бит n - уровень выхода в фазе n)
+	uint16_t duration;			// Длительность ступени (секунды), 0 - до завершения сигнала
+} alarm_stage;
+
+static const alarm_stage alarmStages[] = {
+	{0x01, 30},		// Короткая вспышка раз в секунду
+	{0x0F, 30},		// Мигание 0.5 с / 0.5 с
+	{0x55, 60},		// Частое мигание 125 мс / 125 мс
+	{0xFF, 0}		// Непрерывный сигнал
+};
+
+#define ALARM_STAGES 	(sizeof(alarmStages) / sizeof(alarmStages[0]))
+
+alarm_stats alarmStats;
+
+static alarm_state state;		// Текущее состояние
+static uint8_t stage;			// Текущая ступень усиления
+static uint8_t phase;			// Фаза рисунка внутри секунды
+static uint16_t stageSeconds;	// Время с начала ступени
+static uint16_t ringSeconds;	// Время подачи сигнала с последнего начала (без учета откладывания)
+static uint16_t snoozeSeconds;	// Оставшееся время откладывания
+static uint16_t activeSeconds;	// Время с первого срабатывания (с учетом откладываний)
+
+/* Начало (или возобновление после откладывания) подачи сигнала с первой ступени */
+static void alarmRing(void)
+{
+	state = ALARM_RINGING;
+	stage = 0;
+	stageSeconds = 0;
+	ringSeconds = 0;
+}
+
+/* Начало подачи сигнала (срабатывание будильника) */
+void alarmStart(void)
+{
+	alarmStats.fires++;
+	METRIC_ADD(alarmFires, 1);
+	activeSeconds = 0;
+	alarmRing();
+}
+
+/* Откладывание сигнала на ALARM_SNOOZE_MINUTES минут */
+void alarmSnooze(void)
+{
+	if(state != ALARM_RINGING)
+	{
+		return;
+	}
+	alarmStats.snoozes++;
+	snoozeSeconds = ALARM_SNOOZE_MINUTES * 60;
+	state = ALARM_SNOOZED;
+}
+
+/* Отключение сигнала пользователем (во время подачи или откладывания) */
+void alarmDismiss(void)
+{
+	if(state == ALARM_IDLE)
+	{
+		return;
+	}
+	alarmStats.dismisses++;
+	alarmStats.lastDismissTime = activeSeconds;
+	alarmStats.totalDismissTime += activeSeconds;
+	if(activeSeconds > alarmStats.maxDismissTime)
+	{
+		alarmStats.maxDismissTime = activeSeconds;
+	}
+	state = ALARM_IDLE;
+}
+
+/*
+*	Обработка очередной секунды
+*	Переключает ступени усиления, возобновляет отложенный сигнал и завершает сигнал по истечении ALARM_TIMEOUT
+*	Возвращает 1, пока сигнал подается или отложен
+*/
+uint8_t alarmSecond(void)
+{
+	phase = 0;
+
+	switch(state)
+	{
+		case ALARM_RINGING:
+		{
+			activeSeconds++;
+			if(++ringSeconds >= ALARM_TIMEOUT)									// Нет реакции пользователя - завершение сигнала
+			{
+				alarmStats.timeouts++;
+				state = ALARM_IDLE;
+				break;
+			}
+			if(alarmStages[stage].duration && ++stageSeconds >= alarmStages[stage].duration)
+			{
+				stage++;														// Переход к следующей ступени усиления
+				stageSeconds = 0;
+			}
+		}
+			break;
+		case ALARM_SNOOZED:
+		{
+			activeSeconds++;
+			if(--snoozeSeconds == 0)											// Время откладывания истекло - возобновление сигнала
+			{
+				alarmRing();
+			}
+		}
+			break;
+		default:
+			break;
+	}
+	return state != ALARM_IDLE;
+}
+
+/* Уровень выхода сигнала в очередной фазе секунды (1 - включен, 0 - выключен) */
+uint8_t alarmPhase(void)
+{
+	uint8_t level;
+
+	if(state != ALARM_RINGING || phase >= ALARM_PHASES)
+	{
+		return 0;
+	}
+	level = (alarmStages[stage].pattern >> phase) & 1;
+	phase++;
+	return level;
+}
+
+/* Текущее состояние */
+alarm_state alarmGetState(void)
+{
+	return state;
+}
+
+/* Текущая ступень усиления сигнала */
+uint8_t alarmGetStage(void)
+{
+	return stage;
+}
+
+/*
+*	Проверка наступления момента за leadMinutes минут до времени будильника (в начале минуты)
+*	Используется для заблаговременного запуска действий, которые должны завершиться к срабатыванию будильника
+*/
+uint8_t alarmLeadMatch(const time *p_now, const time *p_alarm, uint8_t leadMinutes)
+{
+	int16_t start = (int16_t)(p_alarm->hours * 60 + p_alarm->minutes - leadMinutes);	// Минута суток начала действия
+
+	if(start < 0)
+	{
+		start += 24 * 60;																// Начало приходится на предыдущие сутки
+	}
+	return p_now->seconds == 0 && (p_now->hours * 60 + p_now->minutes) == start;
+}
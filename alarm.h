@@ -0,0 +1,38 @@
+#ifndef ALARM_H
+#define ALARM_H
+
+#include <stdint.h>
+#include "calendar.h"
+
+#define ALARM_SNOOZE_MINUTES 	5		// Время откладывания сигнала (минуты)
+#define ALARM_TIMEOUT 			600		// Автоматическое завершение сигнала без реакции пользователя (секунды)
+#define ALARM_PHASES 			8		// Количество фаз рисунка сигнала за секунду (шаг 125 мс)
+
+typedef enum alarm_state_tag{	// Состояние обработчика сигнала тревоги
+	ALARM_IDLE,					// Сигнал не подается
+	ALARM_RINGING,				// Сигнал подается
+	ALARM_SNOOZED				// Сигнал отложен
+} alarm_state;
+
+typedef struct alarm_stats_tag{	// Статистика будильника (хранится в ОЗУ)
+	uint16_t fires;				// Количество срабатываний
+	uint16_t snoozes;			// Количество откладываний сигнала
+	uint16_t dismisses;			// Количество отключений сигнала пользователем
+	uint16_t timeouts;			// Количество автоматических завершений сигнала
+	uint16_t lastDismissTime;	// Время от срабатывания до отключения (последнее), секунды
+	uint16_t maxDismissTime;	// Время от срабатывания до отключения (максимальное), секунды
+	uint32_t totalDismissTime;	// Суммарное время от срабатывания до отключения (для вычисления среднего), секунды
+} alarm_stats;
+
+extern alarm_stats alarmStats;
+
+void alarmStart(void);				// Начало подачи сигнала
+void alarmSnooze(void);				// Откладывание сигнала на ALARM_SNOOZE_MINUTES минут
+void alarmDismiss(void);			// Отключение сигнала пользователем
+uint8_t alarmSecond(void);			// Обработка очередной секунды (возвращает 1, пока сигнал подается или отложен)
+uint8_t alarmPhase(void);			// Уровень выхода сигнала в очередной фазе (вызывается ALARM_PHASES раз в секунду)
+alarm_state alarmGetState(void);	// Текущее состояние
+uint8_t alarmGetStage(void);		// Текущая ступень усиления сигнала
+uint8_t alarmLeadMatch(const time *p_now, const time *p_alarm, uint8_t leadMinutes);	// Наступление момента за leadMinutes минут до будильника
+
+#endif /* ALARM_H */
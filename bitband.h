@@ -0,0 +1,16 @@
+#ifndef BITBAND_H
+#define BITBAND_H
+
+#include "stm32f10x.h"
+
+/*
+*	Доступ к отдельным битам через область псевдонимов bit-band Cortex-M3: каждому биту SRAM и периферии
+*	соответствует слово, запись 0 или 1 в которое изменяет только этот бит за одну транзакцию шины
+*	(без чтения-изменения-записи, без запрета прерываний). Адрес должен быть известен на этапе компиляции
+*	или вычисляться константой - иначе выигрыш теряется на арифметике адреса
+*/
+
+#define BITBAND_SRAM(address, bit) 		(*(volatile uint32_t *)(SRAM_BB_BASE + (((uint32_t)(address) - SRAM_BASE) << 5) + ((uint32_t)(bit) << 2)))		// Бит слова в SRAM
+#define BITBAND_PERIPH(address, bit) 	(*(volatile uint32_t *)(PERIPH_BB_BASE + (((uint32_t)(address) - PERIPH_BASE) << 5) + ((uint32_t)(bit) << 2)))	// Бит регистра периферии
+
+#endif /* BITBAND_H */
@@ -0,0 +1,64 @@
+#include "stm32f10x.h"
+#include "board.h"
+#include "display.h"
+
+#define BOARD_UNIQUE(P) 	((0ul BOARD_PINS(BOARD_PIN_SUM, P)) == BOARD_PINS_OF(P))	// Каждый вывод порта назначен один раз
+#define BOARD_EXTI_NOT_INPUT(arg, port, pin, edge, irq) 	| ((((0ul BOARD_PINS(BOARD_INPUT_BIT, BOARD_PORT_##port)) >> (pin)) & 1ul) ? 0ul : (1ul << (pin)))
+
+#if !BOARD_UNIQUE(BOARD_PORT_A) || !BOARD_UNIQUE(BOARD_PORT_B) || !BOARD_UNIQUE(BOARD_PORT_C)
+#error "A pin is assigned twice in BOARD_PINS"
+#endif
+#if (0ul BOARD_EXTI(BOARD_EXTI_SUM, 0)) != BOARD_EXTI_LINES
+#error "An EXTI line is used twice in BOARD_EXTI"
+#endif
+#if (0ul BOARD_EXTI(BOARD_EXTI_NOT_INPUT, 0)) != 0
+#error "An EXTI line is routed from a pin that is not configured as input on the same port"
+#endif
+#if BOARD_LEVEL_TIME == 0 || BOARD_LEVEL_COMMS >= (1u << BOARD_PREEMPT_BITS)
+#error "Critical section levels must be 1...3 (BASEPRI = 0 does not mask)"
+#endif
+#if DISPLAY_DIGITS != 4
+#error "BOARD_PINS lists four digit select pins"
+#endif
+
+#define BOARD_IRQ_PRIORITY(irq, level, sub) 	NVIC_SetPriority(irq, NVIC_EncodePriority(BOARD_PRIORITY_GROUPING, level, sub));
+#define BOARD_EXTI_IRQ(arg, port, pin, edge, irq) 	NVIC_EnableIRQ(irq);
+
+/* 
+*	Настройка выводов по описанию платы (board.h)
+*	Вызывается первой: модули только включают тактирование своей периферии. ODR пишется до CRL/CRH,
+*	чтобы вход с подтяжкой сразу получил нужное направление подтяжки
+*/
+void Board_Init(void)
+{
+	RCC->APB2ENR |= RCC_APB2ENR_IOPAEN | RCC_APB2ENR_IOPBEN | RCC_APB2ENR_IOPCEN | RCC_APB2ENR_AFIOEN;	// Включение тактирования портов и альтернативных функций
+
+	GPIOA->ODR = BOARD_ODR(BOARD_PORT_A);
+	GPIOA->CRL = BOARD_CRL(BOARD_PORT_A);
+	GPIOA->CRH = BOARD_CRH(BOARD_PORT_A);
+	GPIOB->ODR = BOARD_ODR(BOARD_PORT_B);
+	GPIOB->CRL = BOARD_CRL(BOARD_PORT_B);
+	GPIOB->CRH = BOARD_CRH(BOARD_PORT_B);
+	GPIOC->ODR = BOARD_ODR(BOARD_PORT_C);
+	GPIOC->CRL = BOARD_CRL(BOARD_PORT_C);
+	GPIOC->CRH = BOARD_CRH(BOARD_PORT_C);
+
+	AFIO->MAPR = BOARD_MAPR;
+	AFIO->EXTICR[0] = BOARD_EXTICR(0);														// Выбор портов линий EXTI
+	AFIO->EXTICR[1] = BOARD_EXTICR(1);
+	AFIO->EXTICR[2] = BOARD_EXTICR(2);
+	AFIO->EXTICR[3] = BOARD_EXTICR(3);
+	EXTI->RTSR = BOARD_EXTI_RISING;
+	EXTI->FTSR = BOARD_EXTI_FALLING;
+
+	NVIC_SetPriorityGrouping(BOARD_PRIORITY_GROUPING);
+	BOARD_IRQS(BOARD_IRQ_PRIORITY)
+}
+
+/* Разрешение внешних прерываний; фронты, пришедшие до разрешения, не обрабатываются */
+void boardExtiEnable(void)
+{
+	EXTI->PR = BOARD_EXTI_LINES;
+	EXTI->IMR = BOARD_EXTI_LINES;
+	BOARD_EXTI(BOARD_EXTI_IRQ, 0)
+}
@@ -0,0 +1,149 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include "stm32f10x.h"
+
+/*
+*	Описание платы: назначение выводов, режимы, внешние прерывания и приоритеты прерываний
+*	Из списков ниже на этапе компиляции вычисляются образы регистров CRL/CRH/ODR портов, AFIO->EXTICR и EXTI,
+*	Board_Init записывает их по одной записи на регистр. Модули выводы не настраивают: вывод, которого нет в списке,
+*	остается входом без подтяжки (состояние после сброса). Противоречия списков (вывод назначен дважды,
+*	линия EXTI от вывода, который не настроен входом) обнаруживаются при компиляции board.c
+*/
+
+/* Выводы */
+#define GPS_PPS_PIN 			0		// PA0 - TIM2_CH1 (1PPS приемника)
+#define SUNRISE_PIN 			1		// PA1 - TIM2_CH2 (светодиод рассвета)
+#define CONSOLE_TX_PIN 			2		// PA2 - USART2_TX
+#define CONSOLE_RX_PIN 			3		// PA3 - USART2_RX
+#define INC_BTN 				4		// PA4 - кнопка увеличения изменяемого параметра (минуты или секунды) на 1, также используется для отключения сигнала сработавшего будильника
+#define LED2 					5		// PA5 - светодиод для подачи сигнала (светодиод загорается при срабатывании будильника)
+#define CLOCKTIME_BTN 			6		// PA6 - кнопка перехода в режим настройки часов (текущего времени) ИЛИ кнопка подтверждения установленных минут или часов в этом режиме
+#define ALARMTIME_BTN 			7		// PA7 - кнопка перехода в режим настройки будильника ИЛИ кнопка подтверждения установленных минут или часов в этом режиме
+#define BUZZER_PIN 				8		// PA8 - TIM1_CH1 (зуммер)
+#define GPS_RX_PIN 				10		// PA10 - USART1_RX
+#define OLED_SCL_PIN 			6		// PB6 - I2C1_SCL
+#define OLED_SDA_PIN 			7		// PB7 - I2C1_SDA
+#define CANSYNC_RX_PIN 			8		// PB8 - CAN_RX (полное переназначение CAN)
+#define CANSYNC_TX_PIN 			9		// PB9 - CAN_TX
+#define MODBUS_TX_PIN 			10		// PB10 - USART3_TX
+#define MODBUS_RX_PIN 			11		// PB11 - USART3_RX
+#define DISPLAY_SEGMENT_FIRST 	0		// PC0...PC6 - сегменты a...g индикатора (активный уровень - высокий)
+#define DISPLAY_POINT_PIN 		8		// PC8 - двоеточие (точка второго разряда)
+#define DISPLAY_DIGIT_FIRST 	9		// PC9...PC12 - выбор разрядов (активный уровень - высокий, слева направо)
+
+#define BOARD_PORT_A 	0u		// Номера портов (значение поля AFIO->EXTICR)
+#define BOARD_PORT_B 	1u
+#define BOARD_PORT_C 	2u
+
+/* Режимы выводов: биты 0...3 - поле CNF:MODE регистра CRL/CRH, бит 4 - уровень ODR (подтяжка входа к питанию) */
+#define BOARD_IN_FLOATING 		0x04u	// Вход без подтяжки
+#define BOARD_IN_PULL_DOWN 		0x08u	// Вход с подтяжкой к земле
+#define BOARD_IN_PULL_UP 		0x18u	// Вход с подтяжкой к питанию
+#define BOARD_OUT_2MHZ 			0x02u	// Двухтактный выход
+#define BOARD_OUT_10MHZ 		0x01u
+#define BOARD_AF_2MHZ 			0x0Au	// Альтернативная функция, двухтактный выход
+#define BOARD_AF_10MHZ 			0x09u
+#define BOARD_AF_50MHZ 			0x0Bu
+#define BOARD_AF_OD_10MHZ 		0x0Du	// Альтернативная функция, открытый сток
+
+/* Выводы: X(аргумент, порт, вывод, режим) */
+#define BOARD_PINS(X, arg) \
+	X(arg, A, GPS_PPS_PIN, 				BOARD_IN_PULL_DOWN) \
+	X(arg, A, SUNRISE_PIN, 				BOARD_AF_2MHZ) \
+	X(arg, A, CONSOLE_TX_PIN, 			BOARD_AF_50MHZ) \
+	X(arg, A, CONSOLE_RX_PIN, 			BOARD_IN_FLOATING) \
+	X(arg, A, INC_BTN, 					BOARD_IN_PULL_DOWN) \
+	X(arg, A, LED2, 					BOARD_OUT_10MHZ) \
+	X(arg, A, CLOCKTIME_BTN, 			BOARD_IN_PULL_DOWN) \
+	X(arg, A, ALARMTIME_BTN, 			BOARD_IN_PULL_DOWN) \
+	X(arg, A, BUZZER_PIN, 				BOARD_AF_10MHZ) \
+	X(arg, A, GPS_RX_PIN, 				BOARD_IN_FLOATING) \
+	X(arg, B, OLED_SCL_PIN, 			BOARD_AF_OD_10MHZ) 	/* Подтягивающие резисторы - на модуле индикатора */ \
+	X(arg, B, OLED_SDA_PIN, 			BOARD_AF_OD_10MHZ) \
+	X(arg, B, CANSYNC_RX_PIN, 			BOARD_IN_PULL_UP) \
+	X(arg, B, CANSYNC_TX_PIN, 			BOARD_AF_50MHZ) \
+	X(arg, B, MODBUS_TX_PIN, 			BOARD_AF_50MHZ) \
+	X(arg, B, MODBUS_RX_PIN, 			BOARD_IN_FLOATING) \
+	X(arg, C, DISPLAY_SEGMENT_FIRST + 0, BOARD_OUT_2MHZ) \
+	X(arg, C, DISPLAY_SEGMENT_FIRST + 1, BOARD_OUT_2MHZ) \
+	X(arg, C, DISPLAY_SEGMENT_FIRST + 2, BOARD_OUT_2MHZ) \
+	X(arg, C, DISPLAY_SEGMENT_FIRST + 3, BOARD_OUT_2MHZ) \
+	X(arg, C, DISPLAY_SEGMENT_FIRST + 4, BOARD_OUT_2MHZ) \
+	X(arg, C, DISPLAY_SEGMENT_FIRST + 5, BOARD_OUT_2MHZ) \
+	X(arg, C, DISPLAY_SEGMENT_FIRST + 6, BOARD_OUT_2MHZ) \
+	X(arg, C, DISPLAY_POINT_PIN, 		BOARD_OUT_2MHZ) \
+	X(arg, C, DISPLAY_DIGIT_FIRST + 0, 	BOARD_OUT_2MHZ) \
+	X(arg, C, DISPLAY_DIGIT_FIRST + 1, 	BOARD_OUT_2MHZ) \
+	X(arg, C, DISPLAY_DIGIT_FIRST + 2, 	BOARD_OUT_2MHZ) \
+	X(arg, C, DISPLAY_DIGIT_FIRST + 3, 	BOARD_OUT_2MHZ)
+
+#define BOARD_MAPR 	AFIO_MAPR_CAN_REMAP_REMAP2		// Переназначение: CAN на PB8/PB9 (PA11/PA12 заняты USB)
+
+/* Внешние прерывания: X(аргумент, порт, вывод, фронт, прерывание NVIC) */
+#define BOARD_EDGE_RISING 		0x01u
+#define BOARD_EDGE_FALLING 		0x02u
+
+#define BOARD_EXTI(X, arg) \
+	X(arg, A, INC_BTN, 			BOARD_EDGE_RISING, EXTI4_IRQn) \
+	X(arg, A, CLOCKTIME_BTN, 	BOARD_EDGE_RISING, EXTI9_5_IRQn) \
+	X(arg, A, ALARMTIME_BTN, 	BOARD_EDGE_RISING, EXTI9_5_IRQn)
+
+/*
+*	Приоритеты прерываний: 2 бита уровня вытеснения, 2 бита подприоритета (порядок обслуживания внутри уровня)
+*	Уровень 0 не используется и критическими секциями не маскируется (BASEPRI = 0 маску снимает)
+*/
+#define BOARD_PREEMPT_BITS 		2u
+#define BOARD_PRIORITY_GROUPING (7u - BOARD_PREEMPT_BITS)		// Поле PRIGROUP регистра SCB->AIRCR
+#define BOARD_BASEPRI(level) 	((uint32_t)(level) << (8u - BOARD_PREEMPT_BITS))	// Значение BASEPRI, маскирующее уровень level и ниже
+
+#define BOARD_LEVEL_TIME 		1u		// Счет времени: секунда TIM3 и выходы сигнала, состояние которых меняет TIM3
+#define BOARD_LEVEL_INPUT 		2u		// Кнопки
+#define BOARD_LEVEL_COMMS 		3u		// Обмен: последовательные порты, CAN, I2C, захват 1PPS и таймаут Modbus (TIM2)
+
+/* X(прерывание, уровень, подприоритет) */
+#define BOARD_IRQS(X) \
+	X(TIM3_IRQn, 				BOARD_LEVEL_TIME, 	0) 	/* Секунды и фазы сигнала */ \
+	X(DMA1_Channel5_IRQn, 		BOARD_LEVEL_TIME, 	1) 	/* Конец мелодии (мелодию запускает и останавливает TIM3) */ \
+	X(DMA1_Channel4_IRQn, 		BOARD_LEVEL_TIME, 	1) 	/* Конец рассвета (рассвет запускает и останавливает TIM3) */ \
+	X(EXTI4_IRQn, 				BOARD_LEVEL_INPUT, 	0) \
+	X(EXTI9_5_IRQn, 			BOARD_LEVEL_INPUT, 	0) \
+	X(TIM2_IRQn, 				BOARD_LEVEL_COMMS, 	0) 	/* Момент 1PPS фиксирует захват, задержка обработчика на него не влияет */ \
+	X(USB_HP_CAN1_TX_IRQn, 		BOARD_LEVEL_COMMS, 	0) 	/* Метки времени SYNC/FOLLOW_UP */ \
+	X(USB_LP_CAN1_RX0_IRQn, 	BOARD_LEVEL_COMMS, 	0) \
+	X(USART1_IRQn, 				BOARD_LEVEL_COMMS, 	1) 	/* NMEA */ \
+	X(USART2_IRQn, 				BOARD_LEVEL_COMMS, 	1) 	/* Консоль */ \
+	X(DMA1_Channel6_IRQn, 		BOARD_LEVEL_COMMS, 	1) 	/* Прием консоли: половина или конец буфера */ \
+	X(DMA1_Channel7_IRQn, 		BOARD_LEVEL_COMMS, 	1) \
+	X(USART3_IRQn, 				BOARD_LEVEL_COMMS, 	1) 	/* Modbus */ \
+	X(I2C1_EV_IRQn, 			BOARD_LEVEL_COMMS, 	2) 	/* OLED, прерывание на каждый байт */ \
+	X(I2C1_ER_IRQn, 			BOARD_LEVEL_COMMS, 	2)
+
+/* Образы регистров (константы компиляции) */
+#define BOARD_PIN_BIT(P, port, pin, mode) 		| ((BOARD_PORT_##port == (P)) ? (1ul << (pin)) : 0ul)
+#define BOARD_PIN_SUM(P, port, pin, mode) 		+ ((BOARD_PORT_##port == (P)) ? (1ul << (pin)) : 0ul)
+#define BOARD_INPUT_BIT(P, port, pin, mode) 	| ((BOARD_PORT_##port == (P) && ((mode) & 0x03u) == 0u) ? (1ul << (pin)) : 0ul)
+#define BOARD_ODR_BIT(P, port, pin, mode) 		| ((BOARD_PORT_##port == (P)) ? ((((mode) >> 4) & 1ul) << (pin)) : 0ul)
+#define BOARD_CR_MASK(P, port, pin, mode) 		| ((BOARD_PORT_##port == (P)) ? (0xFull << ((pin) * 4u)) : 0ull)
+#define BOARD_CR_BITS(P, port, pin, mode) 		| ((BOARD_PORT_##port == (P)) ? ((uint64_t)((mode) & 0x0Fu) << ((pin) * 4u)) : 0ull)
+
+#define BOARD_PINS_OF(P) 	(0ul BOARD_PINS(BOARD_PIN_BIT, P))										// Выводы порта
+#define BOARD_CR(P) 		((0x4444444444444444ull & ~(0ull BOARD_PINS(BOARD_CR_MASK, P))) | (0ull BOARD_PINS(BOARD_CR_BITS, P)))	// CRH:CRL
+#define BOARD_CRL(P) 		((uint32_t)BOARD_CR(P))
+#define BOARD_CRH(P) 		((uint32_t)(BOARD_CR(P) >> 32))
+#define BOARD_ODR(P) 		((uint32_t)(0ul BOARD_PINS(BOARD_ODR_BIT, P)))
+
+#define BOARD_EXTI_LINE(arg, port, pin, edge, irq) 		| (1ul << (pin))
+#define BOARD_EXTI_SUM(arg, port, pin, edge, irq) 		+ (1ul << (pin))
+#define BOARD_EXTI_EDGE(E, port, pin, edge, irq) 		| (((edge) & (E)) ? (1ul << (pin)) : 0ul)
+#define BOARD_EXTICR_FIELD(N, port, pin, edge, irq) 	| (((pin) >> 2) == (N) ? (BOARD_PORT_##port << (((pin) & 3u) * 4u)) : 0ul)
+
+#define BOARD_EXTI_LINES 		(0ul BOARD_EXTI(BOARD_EXTI_LINE, 0))
+#define BOARD_EXTI_RISING 		(0ul BOARD_EXTI(BOARD_EXTI_EDGE, BOARD_EDGE_RISING))
+#define BOARD_EXTI_FALLING 		(0ul BOARD_EXTI(BOARD_EXTI_EDGE, BOARD_EDGE_FALLING))
+#define BOARD_EXTICR(N) 		(0ul BOARD_EXTI(BOARD_EXTICR_FIELD, N))
+
+void Board_Init(void);			// Тактирование портов, запись образов регистров портов, AFIO и EXTI, группировка и приоритеты прерываний
+void boardExtiEnable(void);		// Разрешение внешних прерываний (после настройки модулей, которые их обрабатывают)
+
+#endif /* BOARD_H */
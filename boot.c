@@ -0,0 +1,468 @@
+#include "stm32f10x.h"
+#include "boot.h"
+#include "board.h"
+
+#define BOOT_CLOCK 			32000000ul		// HSI / 2 * 8 (загрузчик не зависит от внешнего сигнала HSE)
+#define BOOT_RX_SIZE 		4096u			// Циклический буфер приема (вдвое больше окна ПК)
+#define BOOT_TIMEOUT_MS 	1000u			// Наибольшая пауза в потоке и период BOOT_READY
+#define BOOT_ERASED 		0xFFFFu			// Стертое полуслово
+
+#if BOOT_RX_SIZE < 2u * BOOT_WINDOW
+#error "BOOT_RX_SIZE must hold the host window while a page is erased and programmed"
+#endif
+
+static uint8_t rx[BOOT_RX_SIZE];				// Прием (DMA1_Channel6, циклический режим)
+static uint16_t rxTail;							// Позиция чтения
+static uint16_t consumed;						// Байт потока с последнего подтверждения
+static uint16_t page[BOOT_PAGE_SIZE / 2];		// Собираемая страница образа
+static uint32_t output;							// Выдано байт образа
+static uint32_t length;							// Длина нового образа
+static uint32_t baseLength;						// Длина установленного образа (разностный образ), 0 - копии запрещены
+static uint8_t result;							// Код ошибки (boot_result), BOOT_OK - ошибок нет
+static uint16_t programmed;						// Записано страниц
+static uint16_t skipped;						// Пропущено страниц, совпавших с flash
+
+/* Тактирование от HSI через PLL: 32 МГц, все шины без деления, 1 такт ожидания flash */
+static void bootClock(void)
+{
+	RCC->CR |= RCC_CR_HSION;
+	while(!(RCC->CR & RCC_CR_HSIRDY));
+	RCC->CFGR = RCC_CFGR_SW_HSI;
+	while((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_HSI);
+	RCC->CR &= ~RCC_CR_PLLON;
+	while(RCC->CR & RCC_CR_PLLRDY);
+
+	FLASH->ACR = FLASH_ACR_PRFTBE | 1u;										// 24...48 МГц - 1 такт ожидания
+	RCC->CFGR = RCC_CFGR_PLLSRC_HSI_Div2 | RCC_CFGR_PLLMULL8;
+	RCC->CR |= RCC_CR_PLLON;
+	while(!(RCC->CR & RCC_CR_PLLRDY));
+	RCC->CFGR |= RCC_CFGR_SW_PLL;
+	while((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL);
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;							// Счетчик тактов DWT - таймауты и время обновления
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/* CRC-32 образа во flash (аппаратный блок CRC, словами) */
+static uint32_t bootCrc(uint32_t size)
+{
+	const uint32_t *p_word = (const uint32_t *)BOOT_APP_BASE;
+
+	CRC->CR = CRC_CR_RESET;
+	for(; size >= 4; size -= 4)
+	{
+		CRC->DR = *p_word++;
+	}
+	return CRC->DR;
+}
+
+/* Запись об образе: 1 - запись цела (образ еще не проверен) */
+static uint8_t bootInfoValid(const boot_info *p_info)
+{
+	return p_info->magic == BOOT_MAGIC && p_info->check == ~p_info->crc && p_info->length <= BOOT_APP_SIZE && !(p_info->length & 3u);
+}
+
+/*
+*	1 - приложение можно запускать (начальный указатель стека - в ОЗУ):
+*	запись цела и CRC совпадает (образ записан загрузчиком) или обновление не прервано, а записи нет или она
+*	от прежнего образа (приложение записано отладчиком) - тогда проверяется вектор сброса (Thumb, внутри приложения)
+*/
+static uint8_t bootAppValid(void)
+{
+	const boot_info *p_info = (const boot_info *)BOOT_INFO;
+	const uint32_t *p_vectors = (const uint32_t *)BOOT_APP_BASE;
+
+	if((p_vectors[0] & 0xFFFE0000ul) != SRAM_BASE)
+	{
+		return 0;
+	}
+	if(bootInfoValid(p_info) && bootCrc(p_info->length) == p_info->crc)
+	{
+		return 1;
+	}
+	if(*(const uint16_t *)BOOT_PENDING == 0u && p_info->magic == 0xFFFFFFFFul)	// Обновление начато и не завершено
+	{
+		return 0;
+	}
+	return (p_vectors[1] & 1u) && p_vectors[1] - BOOT_APP_BASE < BOOT_APP_SIZE;
+}
+
+/* Передача управления приложению: используемая периферия возвращается в состояние после сброса */
+static void bootStart(void)
+{
+	const uint32_t *p_vectors = (const uint32_t *)BOOT_APP_BASE;
+
+	USART2->CR1 = 0;
+	DMA1_Channel6->CCR = 0;
+	RCC->APB1RSTR = RCC_APB1RSTR_USART2RST;
+	RCC->APB1RSTR = 0;
+	SCB->VTOR = BOOT_APP_BASE;
+	__set_MSP(p_vectors[0]);
+	((void (*)(void))p_vectors[1])();										// SystemInit приложения заново настраивает тактирование
+}
+
+/* Снятие защиты от записи flash */
+static void bootUnlock(void)
+{
+	if(FLASH->CR & FLASH_CR_LOCK)
+	{
+		FLASH->KEYR = 0x45670123ul;
+		FLASH->KEYR = 0xCDEF89ABul;
+	}
+}
+
+/* Стирание страницы (1 - успешно); процессор ожидает окончания стирания (около 20 мс), прием продолжает DMA */
+static uint8_t bootErase(uint32_t address)
+{
+	FLASH->CR |= FLASH_CR_PER;
+	FLASH->AR = address;
+	FLASH->CR |= FLASH_CR_STRT;
+	while(FLASH->SR & FLASH_SR_BSY);
+	FLASH->CR &= ~FLASH_CR_PER;
+	FLASH->SR = FLASH_SR_EOP;
+	return *(const volatile uint16_t *)address == BOOT_ERASED;
+}
+
+/* Программирование полуслова (1 - успешно) */
+static uint8_t bootProgram(uint32_t address, uint16_t value)
+{
+	FLASH->CR |= FLASH_CR_PG;
+	*(volatile uint16_t *)address = value;
+	while(FLASH->SR & FLASH_SR_BSY);
+	FLASH->CR &= ~FLASH_CR_PG;
+	if(FLASH->SR & (FLASH_SR_PGERR | FLASH_SR_WRPRTERR))
+	{
+		FLASH->SR = FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+		return 0;
+	}
+	return *(const volatile uint16_t *)address == value;
+}
+
+/* Передача байта */
+static void bootSend(uint8_t value)
+{
+	while(!(USART2->SR & USART_SR_TXE));
+	USART2->DR = value;
+}
+
+/* Передача слова (младший байт первым) */
+static void bootSendWord(uint32_t value, uint8_t size)
+{
+	while(size--)
+	{
+		bootSend((uint8_t)value);
+		value >>= 8;
+	}
+}
+
+/* Настройка USART2 (BOOT_BAUDRATE, 8N1) и приема через DMA1_Channel6 в циклический буфер */
+static void bootSerialInit(void)
+{
+	RCC->APB1ENR |= RCC_APB1ENR_USART2EN;
+	RCC->AHBENR |= RCC_AHBENR_DMA1EN | RCC_AHBENR_CRCEN;
+	GPIOA->CRL = (GPIOA->CRL & ~(0xFFul << (CONSOLE_TX_PIN * 4))) | ((uint32_t)BOARD_AF_50MHZ << (CONSOLE_TX_PIN * 4)) | ((uint32_t)BOARD_IN_FLOATING << (CONSOLE_RX_PIN * 4));
+
+	USART2->BRR = (uint16_t)((BOOT_CLOCK + BOOT_BAUDRATE / 2) / BOOT_BAUDRATE);
+	USART2->CR3 = USART_CR3_DMAR;
+	DMA1_Channel6->CPAR = (uint32_t)&USART2->DR;
+	DMA1_Channel6->CMAR = (uint32_t)rx;
+	DMA1_Channel6->CNDTR = BOOT_RX_SIZE;
+	DMA1_Channel6->CCR = DMA_CCR1_MINC | DMA_CCR1_CIRC | DMA_CCR1_EN;		// USART -> память, по кругу
+	USART2->CR1 = USART_CR1_UE | USART_CR1_TE | USART_CR1_RE;
+}
+
+/*
+*	Очередной байт потока; при паузе дольше BOOT_TIMEOUT_MS - ошибка BOOT_ERROR_TIMEOUT и 0
+*	Каждые BOOT_BLOCK прочитанных байт ПК получает подтверждение и может передать следующий блок
+*/
+static uint8_t bootByte(void)
+{
+	uint32_t start = DWT->CYCCNT;
+	uint8_t value;
+
+	while(rxTail == (BOOT_RX_SIZE - DMA1_Channel6->CNDTR) % BOOT_RX_SIZE)
+	{
+		if(result != BOOT_OK || DWT->CYCCNT - start > BOOT_TIMEOUT_MS * (BOOT_CLOCK / 1000u))
+		{
+			result = result != BOOT_OK ? result : BOOT_ERROR_TIMEOUT;
+			return 0;
+		}
+	}
+	value = rx[rxTail];
+	rxTail = (uint16_t)((rxTail + 1u) % BOOT_RX_SIZE);
+	if(++consumed == BOOT_BLOCK)
+	{
+		consumed = 0;
+		bootSend(BOOT_ACK);
+	}
+	return value;
+}
+
+/* Продолжение длины: байты складываются, пока байт равен 255 */
+static uint32_t bootLength(void)
+{
+	uint32_t sum = 0;
+	uint8_t value;
+
+	do
+	{
+		value = bootByte();
+		sum += value;
+	} while(value == 255 && result == BOOT_OK);
+	return sum;
+}
+
+/* Запись собранной страницы; страница, совпавшая с содержимым flash, не стирается */
+static void bootFlush(uint32_t offset)
+{
+	const uint16_t *p_flash = (const uint16_t *)(BOOT_APP_BASE + offset);
+	uint16_t i;
+
+	for(i = 0; i < BOOT_PAGE_SIZE / 2 && p_flash[i] == page[i]; i++);
+	if(i == BOOT_PAGE_SIZE / 2)
+	{
+		skipped++;
+		return;
+	}
+	if(!bootErase(BOOT_APP_BASE + offset))
+	{
+		result = BOOT_ERROR_FLASH;
+		return;
+	}
+	for(i = 0; i < BOOT_PAGE_SIZE / 2; i++)
+	{
+		if(page[i] != BOOT_ERASED && !bootProgram(BOOT_APP_BASE + offset + i * 2u, page[i]))
+		{
+			result = BOOT_ERROR_FLASH;
+			return;
+		}
+	}
+	programmed++;
+}
+
+/* Выдача байта образа; заполненная страница сразу записывается */
+static void bootOutput(uint8_t value)
+{
+	if(output >= length)
+	{
+		result = BOOT_ERROR_STREAM;
+		return;
+	}
+	((uint8_t *)page)[output % BOOT_PAGE_SIZE] = value;
+	if(++output % BOOT_PAGE_SIZE == 0)
+	{
+		bootFlush(output - BOOT_PAGE_SIZE);
+	}
+}
+
+/* Байт уже выданной части нового образа: текущая страница - в буфере, предыдущие уже записаны */
+static uint8_t bootOutputByte(uint32_t position)
+{
+	if(position >= output - output % BOOT_PAGE_SIZE)
+	{
+		return ((const uint8_t *)page)[position % BOOT_PAGE_SIZE];
+	}
+	return *(const uint8_t *)(BOOT_APP_BASE + position);
+}
+
+/* Байт установленного образа: только из страниц, которые еще не перезаписаны */
+static uint8_t bootBaseByte(uint32_t position)
+{
+	if(position < output - output % BOOT_PAGE_SIZE || position >= baseLength)
+	{
+		result = BOOT_ERROR_STREAM;
+		return 0;
+	}
+	return *(const uint8_t *)(BOOT_APP_BASE + position);
+}
+
+/* Распаковка потока до выдачи length байт (формат - в boot.h) */
+static void bootDecode(void)
+{
+	uint32_t count, offset, source;
+	uint8_t token;
+
+	while(output < length && result == BOOT_OK)
+	{
+		token = bootByte();
+		count = token >> 4;
+		if(count == 15)
+		{
+			count += bootLength();
+		}
+		while(count-- && result == BOOT_OK)
+		{
+			bootOutput(bootByte());
+		}
+		if(output >= length || result != BOOT_OK)
+		{
+			break;
+		}
+
+		offset = bootByte();
+		offset |= (uint32_t)bootByte() << 8;
+		count = (token & 15u) + BOOT_MATCH_MIN;
+		if((token & 15u) == 15)
+		{
+			count += bootLength();
+		}
+		if(offset)															// Копия из нового образа (может перекрываться с собой)
+		{
+			if(offset > output)
+			{
+				result = BOOT_ERROR_STREAM;
+			}
+			for(source = output - offset; count-- && result == BOOT_OK; source++)
+			{
+				bootOutput(bootOutputByte(source));
+			}
+		}
+		else																// Копия из установленного образа
+		{
+			source = bootByte();
+			source |= (uint32_t)bootByte() << 8;
+			source |= (uint32_t)bootByte() << 16;
+			for(; count-- && result == BOOT_OK; source++)
+			{
+				bootOutput(bootBaseByte(source));
+			}
+		}
+	}
+}
+
+/*
+*	Прием заголовка и образа, запись и проверка (возвращает boot_result)
+*	До записи первой страницы запись об образе стирается и ставится метка BOOT_PENDING: прерванное или
+*	неудачное обновление (метка без записи) оставляет загрузчик активным
+*/
+static uint8_t bootUpdate(void)
+{
+	const boot_info *p_info = (const boot_info *)BOOT_INFO;
+	boot_header header;
+	uint32_t start;
+	uint8_t i;
+
+	result = BOOT_OK;
+	header.magic = 0;
+	while(header.magic != BOOT_MAGIC)										// Поиск признака заголовка
+	{
+		header.magic = (header.magic >> 8) | ((uint32_t)bootByte() << 24);
+		if(result != BOOT_OK)
+		{
+			return BOOT_IDLE;
+		}
+	}
+	for(i = 4; i < sizeof(header); i++)
+	{
+		((uint8_t *)&header)[i] = bootByte();
+	}
+	if(result != BOOT_OK)
+	{
+		return result;
+	}
+	if(header.format > BOOT_FORMAT_DELTA || !header.length || header.length > BOOT_APP_SIZE || (header.length & 3u))
+	{
+		return BOOT_ERROR_HEADER;
+	}
+	baseLength = 0;
+	if(header.format == BOOT_FORMAT_DELTA)
+	{
+		if(!bootInfoValid(p_info) || p_info->crc != header.baseCrc || bootCrc(p_info->length) != p_info->crc)	// Образ мог быть заменен отладчиком
+		{
+			return BOOT_ERROR_BASE;
+		}
+		baseLength = p_info->length;
+	}
+
+	start = DWT->CYCCNT;
+	bootSend(BOOT_ACCEPT);
+	consumed = 0;
+	output = 0;
+	length = header.length;
+	programmed = 0;
+	skipped = 0;
+	bootUnlock();
+	if(!bootErase(BOOT_INFO) || !bootProgram(BOOT_PENDING, 0))				// Запись стерта, метка начатого обновления
+	{
+		FLASH->CR |= FLASH_CR_LOCK;
+		return BOOT_ERROR_FLASH;
+	}
+
+	bootDecode();
+	if(result == BOOT_OK && output % BOOT_PAGE_SIZE)						// Последняя неполная страница дополняется стертыми байтами
+	{
+		while(output % BOOT_PAGE_SIZE)
+		{
+			((uint8_t *)page)[output++ % BOOT_PAGE_SIZE] = 0xFF;
+		}
+		bootFlush(output - BOOT_PAGE_SIZE);
+	}
+	if(result == BOOT_OK && bootCrc(header.length) != header.crc)
+	{
+		result = BOOT_ERROR_CRC;
+	}
+	if(result == BOOT_OK)													// Запись об образе - последней
+	{
+		if(!bootProgram(BOOT_INFO + 0, (uint16_t)BOOT_MAGIC) || !bootProgram(BOOT_INFO + 2, (uint16_t)(BOOT_MAGIC >> 16)) ||
+		   !bootProgram(BOOT_INFO + 4, (uint16_t)header.length) || !bootProgram(BOOT_INFO + 6, (uint16_t)(header.length >> 16)) ||
+		   !bootProgram(BOOT_INFO + 8, (uint16_t)header.crc) || !bootProgram(BOOT_INFO + 10, (uint16_t)(header.crc >> 16)) ||
+		   !bootProgram(BOOT_INFO + 12, (uint16_t)~header.crc) || !bootProgram(BOOT_INFO + 14, (uint16_t)(~header.crc >> 16)))
+		{
+			result = BOOT_ERROR_FLASH;
+		}
+	}
+	FLASH->CR |= FLASH_CR_LOCK;
+	if(result != BOOT_OK)
+	{
+		return result;
+	}
+
+	bootSend(BOOT_DONE);
+	bootSendWord((DWT->CYCCNT - start) / (BOOT_CLOCK / 1000u), 4);
+	bootSendWord(programmed, 2);
+	bootSendWord(skipped, 2);
+	return BOOT_OK;
+}
+
+int main(void)
+{
+	uint8_t request, status;
+
+	bootClock();
+	RCC->APB1ENR |= RCC_APB1ENR_PWREN | RCC_APB1ENR_BKPEN;
+	RCC->APB2ENR |= RCC_APB2ENR_IOPAEN;
+	RCC->AHBENR |= RCC_AHBENR_CRCEN;
+	PWR->CR |= PWR_CR_DBP;
+	request = BKP->DR6 == BOOT_REQUEST;
+	BKP->DR6 = 0;
+
+	GPIOA->CRL = (GPIOA->CRL & ~(0xFul << (INC_BTN * 4))) | ((uint32_t)BOARD_IN_PULL_DOWN << (INC_BTN * 4));
+	GPIOA->BRR = 1u << INC_BTN;													// Подтяжка к земле; нажатая кнопка - 1
+	for(status = 0; status < 100; status++)
+	{
+		__NOP();
+	}
+	request |= (GPIOA->IDR >> INC_BTN) & 1u;
+
+	if(!request && bootAppValid())
+	{
+		bootStart();
+	}
+
+	bootSerialInit();
+	while(1)
+	{
+		bootSend(BOOT_READY);
+		status = bootUpdate();
+		if(status == BOOT_OK)
+		{
+			while(!(USART2->SR & USART_SR_TC));							// Ответ передан полностью
+			bootStart();
+		}
+		if(status != BOOT_IDLE)
+		{
+			bootSend(BOOT_FAIL);
+			bootSend(status);
+		}
+	}
+}
@@ -0,0 +1,91 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stdint.h>
+#include "store.h"
+
+/*
+*	Загрузчик (цель Bootloader): первые BOOT_SIZE байт flash, последняя страница загрузчика - запись об образе.
+*	Приложение - с BOOT_APP_BASE до хранилища (store.h). После сброса загрузчик проверяет запись и CRC образа
+*	(аппаратный блок CRC) и передает управление приложению, если обновление не запрошено (BKP->DR6, команда
+*	консоли update) и при сбросе не нажата кнопка INC_BTN.
+*
+*	Отладка: цель Bootloader записывается отладчиком один раз, затем цель Target 1 (приложение с BOOT_APP_BASE)
+*	записывается как обычно, стиранием только своих страниц. Записи об образе для такого приложения нет (или она
+*	осталась от образа, записанного загрузчиком), поэтому, если обновление не было прервано, загрузчик запускает
+*	приложение по правдоподобной таблице векторов: стек в ОЗУ, вектор сброса с битом Thumb внутри приложения.
+*	Прерванное обновление отмечено BOOT_PENDING при стертой записи - тогда загрузчик остается активным.
+*
+*	Обмен по USART2 (выводы консоли), BOOT_BAUDRATE, 8N1. Загрузчик раз в секунду передает BOOT_READY;
+*	ПК передает заголовок boot_header и поток образа. Прием - DMA в циклический буфер, поэтому поток не
+*	останавливается на время стирания и записи страниц; ПК держит не более BOOT_WINDOW неподтвержденных байт,
+*	загрузчик подтверждает каждые BOOT_BLOCK байт потока (BOOT_ACK).
+*	Ответ: BOOT_DONE и время обновления (мс, uint32), записано страниц (uint16), пропущено совпавших страниц (uint16)
+*	или BOOT_FAIL и код boot_result.
+*
+*	Поток - последовательности LZ (tools/boot_image.py): байт признака (старшая тетрада - число литералов,
+*	младшая - длина копии минус BOOT_MATCH_MIN; 15 - продолжение байтами до байта меньше 255), литералы,
+*	затем смещение копии (uint16): 1...65535 - назад от конца уже выданной части нового образа,
+*	0 - далее 3 байта позиции в установленном образе (только разностный образ). Последняя последовательность -
+*	только литералы. Страницы записываются по порядку на место старых, поэтому копия из установленного образа
+*	допустима только из еще не записанных страниц (позиция не меньше начала текущей страницы)
+*/
+
+#define BOOT_BASE 			0x08000000ul						// Начало загрузчика
+#define BOOT_SIZE 			0x2000ul							// Размер загрузчика (8 КБ)
+#define BOOT_PAGE_SIZE 		STORE_PAGE_SIZE						// Размер страницы flash
+#define BOOT_INFO 			(BOOT_BASE + BOOT_SIZE - BOOT_PAGE_SIZE)	// Запись об установленном образе
+#define BOOT_PENDING 		(BOOT_INFO + 16u)					// Метка начатого обновления (0 - записана, после boot_info)
+#define BOOT_APP_BASE 		(BOOT_BASE + BOOT_SIZE)				// Начало приложения (таблица векторов)
+#define BOOT_APP_SIZE 		(STORE_BASE - BOOT_APP_BASE)		// Наибольший размер приложения
+#define BOOT_BAUDRATE 		1000000ul							// Скорость обмена (BRR = 32 МГц / скорость)
+#define BOOT_REQUEST 		0xB007u								// BKP->DR6: приложение запросило обновление
+#define BOOT_MAGIC 			0x544F4F42ul						// "BOOT": признак заголовка и записи об образе
+#define BOOT_BLOCK 			256u								// Подтверждаемая часть потока
+#define BOOT_WINDOW 		2048u								// Наибольший объем неподтвержденных данных ПК
+#define BOOT_MATCH_MIN 		4u									// Наименьшая длина копии
+
+/* Ответы загрузчика */
+#define BOOT_READY 			'R'									// Ожидание заголовка
+#define BOOT_ACCEPT 		'A'									// Заголовок принят
+#define BOOT_ACK 			'.'									// Принято BOOT_BLOCK байт потока
+#define BOOT_DONE 			'K'									// Образ записан и проверен
+#define BOOT_FAIL 			'E'									// Ошибка (далее код boot_result)
+
+#if BOOT_APP_SIZE % BOOT_PAGE_SIZE
+#error "BOOT_APP_SIZE must be a whole number of flash pages"
+#endif
+
+typedef enum boot_format_tag{	// Формат потока
+	BOOT_FORMAT_FULL,			// Полный образ (LZ)
+	BOOT_FORMAT_DELTA,			// Разностный образ: LZ с копиями из установленного образа
+} boot_format;
+
+typedef enum boot_result_tag{	// Результат обновления
+	BOOT_OK,
+	BOOT_IDLE,					// Заголовок не получен
+	BOOT_ERROR_HEADER,			// Неверный заголовок (формат, длина)
+	BOOT_ERROR_BASE,			// Разностный образ построен не для установленного образа
+	BOOT_ERROR_TIMEOUT,			// Пауза в потоке
+	BOOT_ERROR_STREAM,			// Неверная последовательность (копия вне образа)
+	BOOT_ERROR_FLASH,			// Ошибка стирания или записи
+	BOOT_ERROR_CRC,				// CRC записанного образа не совпала
+} boot_result;
+
+typedef struct boot_header_tag{	// Заголовок образа (20 байт)
+	uint32_t magic;				// BOOT_MAGIC
+	uint8_t format;				// boot_format
+	uint8_t reserved[3];
+	uint32_t length;			// Длина образа (кратна 4)
+	uint32_t crc;				// CRC-32 образа (аппаратный блок CRC, словами)
+	uint32_t baseCrc;			// Разностный образ: CRC установленного образа
+} boot_header;
+
+typedef struct boot_info_tag{	// Запись об установленном образе
+	uint32_t magic;				// BOOT_MAGIC
+	uint32_t length;			// Длина образа
+	uint32_t crc;				// CRC-32 образа
+	uint32_t check;				// ~crc
+} boot_info;
+
+#endif /* BOOT_H */
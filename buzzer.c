@@ -0,0 +1,160 @@
+#include "stm32f10x.h"
+#include "buzzer.h"
+
+#define BUZZER_BURST_BASE 	11		// Адрес первого регистра пакета DMA (TIM1->ARR) в 32-битных словах от начала таймера
+#define BUZZER_BURST_LENGTH 	3		// Длина пакета: ARR, RCR, CCR1
+#define BUZZER_REST_PERIOD 	1000	// Период таймера во время паузы (мкс)
+
+typedef struct buzzer_step_tag{	// Шаг воспроизведения (порядок полей совпадает с порядком регистров TIM1)
+	uint16_t arr;				// Период ШИМ - 1
+	uint16_t rcr;				// Количество периодов - 1
+	uint16_t ccr;				// Длительность импульса (громкость)
+} buzzer_step;
+
+static const buzzer_note tuneBeep[] = {
+	{NOTE_A5, 100}, {NOTE_REST, 100}, {NOTE_A5, 100}, {NOTE_REST, 100},
+	{NOTE_A5, 100}, {NOTE_REST, 100}, {NOTE_A5, 100}, {NOTE_REST, 300}
+};
+
+static const buzzer_note tuneScale[] = {
+	{NOTE_C4, 200}, {NOTE_D4, 200}, {NOTE_E4, 200}, {NOTE_F4, 200},
+	{NOTE_G4, 200}, {NOTE_A4, 200}, {NOTE_B4, 200}, {NOTE_C5, 400}, {NOTE_REST, 400}
+};
+
+static const buzzer_note tuneChime[] = {
+	{NOTE_GS4, 500}, {NOTE_FS4, 500}, {NOTE_E4, 500}, {NOTE_B3, 1000}, {NOTE_REST, 250},
+	{NOTE_E4, 500}, {NOTE_GS4, 500}, {NOTE_FS4, 500}, {NOTE_B3, 1000}, {NOTE_REST, 750}
+};
+
+static const struct {			// Таблица мелодий
+	const buzzer_note *notes;
+	uint8_t count;
+} tunes[BUZZER_TUNES] = {
+	{tuneBeep, sizeof(tuneBeep) / sizeof(tuneBeep[0])},
+	{tuneScale, sizeof(tuneScale) / sizeof(tuneScale[0])},
+	{tuneChime, sizeof(tuneChime) / sizeof(tuneChime[0])}
+};
+
+static buzzer_step steps[BUZZER_MAX_STEPS + 2];	// Шаги текущей мелодии с учетом громкости (источник DMA) и две завершающие паузы
+static volatile uint8_t playing;			// Флаг воспроизведения
+
+/*
+*	Преобразование мелодии в шаги воспроизведения
+*	Длительность ноты переводится в количество периодов, ноты длиннее 256 периодов разбиваются на несколько шагов
+*	Возвращает количество шагов
+*/
+static uint16_t buzzerPrepare(uint8_t tune, uint8_t volume)
+{
+	uint16_t count = 0;
+	uint8_t i;
+
+	for(i = 0; i < tunes[tune].count; i++)
+	{
+		uint32_t period = tunes[tune].notes[i].period ? tunes[tune].notes[i].period : BUZZER_REST_PERIOD;
+		uint32_t pulse = tunes[tune].notes[i].period ? period * volume / (2 * BUZZER_VOLUME_MAX) : 0;
+		uint32_t periods = tunes[tune].notes[i].duration * 1000ul / period;
+
+		while(periods && count < BUZZER_MAX_STEPS)
+		{
+			uint32_t chunk = periods > 256 ? 256 : periods;
+			steps[count].arr = (uint16_t)(period - 1);
+			steps[count].rcr = (uint16_t)(chunk - 1);
+			steps[count].ccr = (uint16_t)pulse;
+			periods -= chunk;
+			count++;
+		}
+	}
+	return count;
+}
+
+/* Настройка TIM1 (ШИМ на канале 1) и DMA1_Channel5 (пакетная запись регистров по событию обновления) */
+void Buzzer_Init(void)
+{
+	RCC->APB2ENR |= RCC_APB2ENR_TIM1EN;											// Включение тактирования таймера
+	RCC->AHBENR |= RCC_AHBENR_DMA1EN;											// Включение тактирования DMA
+
+	TIM1->PSC = (uint16_t)(SystemCoreClock / 2 / BUZZER_TIMER_CLOCK - 1);		// APB2 = HCLK / 4, таймеры APB2 тактируются удвоенной частотой шины
+	TIM1->CCMR1 = TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1M_1 | TIM_CCMR1_OC1PE;		// Режим ШИМ 1 с предзагрузкой CCR1
+	TIM1->CCER = TIM_CCER_CC1E;													// Включение выхода канала 1
+	TIM1->BDTR = TIM_BDTR_MOE;													// Разрешение выходов (TIM1 - таймер с расширенными функциями)
+	TIM1->CR1 = TIM_CR1_ARPE;													// Предзагрузка ARR
+	TIM1->DCR = ((BUZZER_BURST_LENGTH - 1) << 8) | BUZZER_BURST_BASE;			// Пакет DMA: 3 регистра начиная с ARR
+
+	DMA1_Channel5->CPAR = (uint32_t)&TIM1->DMAR;								// Приемник - регистр пакетной передачи таймера
+	NVIC_EnableIRQ(DMA1_Channel5_IRQn);
+}
+
+/*
+*	Запуск мелодии с заданной громкостью (0...BUZZER_VOLUME_MAX)
+*	Первый шаг записывается в регистры таймера напрямую, остальные передаются DMA по событиям обновления.
+*	В режиме повтора DMA работает циклически и прерываний не вызывает (напрямую записывается последний шаг,
+*	чтобы круг DMA начинался с первого), иначе вызывается одно прерывание в конце мелодии.
+*	DMA записывает шаг в предзагрузку по событию обновления, с которого звучит предыдущий шаг, поэтому
+*	однократная мелодия дополняется двумя паузами: передача второй (конец DMA) совпадает с началом первой,
+*	то есть с окончанием последней ноты
+*/
+void buzzerPlay(uint8_t tune, uint8_t volume, uint8_t loop)
+{
+	uint16_t count;
+	uint8_t rests;
+
+	buzzerStop();
+	if(tune >= BUZZER_TUNES)
+	{
+		return;
+	}
+	count = buzzerPrepare(tune, volume > BUZZER_VOLUME_MAX ? BUZZER_VOLUME_MAX : volume);
+	if(count < 2)
+	{
+		return;
+	}
+	for(rests = loop ? 0 : 2; rests; rests--)				// Завершающие паузы (место в steps есть всегда)
+	{
+		steps[count].arr = BUZZER_REST_PERIOD - 1;
+		steps[count].rcr = 0;
+		steps[count].ccr = 0;
+		count++;
+	}
+
+	TIM1->ARR = steps[loop ? count - 1 : 0].arr;
+	TIM1->RCR = steps[loop ? count - 1 : 0].rcr;
+	TIM1->CCR1 = steps[loop ? count - 1 : 0].ccr;
+
+	DMA1_Channel5->CMAR = (uint32_t)&steps[loop ? 0 : 1];
+	DMA1_Channel5->CNDTR = (uint32_t)(loop ? count : count - 1) * BUZZER_BURST_LENGTH;
+	DMA1_Channel5->CCR = DMA_CCR1_DIR | DMA_CCR1_MINC | DMA_CCR1_PSIZE_0 | DMA_CCR1_MSIZE_0 | DMA_CCR1_PL_1 |
+						 (loop ? DMA_CCR1_CIRC : DMA_CCR1_TCIE) | DMA_CCR1_EN;	// Память -> таймер, 16 бит
+
+	playing = 1;
+	TIM1->DIER = TIM_DIER_UDE;							// Запрос DMA по событию обновления
+	TIM1->EGR = TIM_EGR_UG;								// Загрузка первого шага в теневые регистры (запрос DMA загружает следующий шаг)
+	TIM1->CR1 |= TIM_CR1_CEN;
+}
+
+/* Остановка воспроизведения */
+void buzzerStop(void)
+{
+	TIM1->CR1 &= ~TIM_CR1_CEN;
+	TIM1->DIER = 0;										// Запрет запросов DMA до следующего запуска
+	DMA1_Channel5->CCR = 0;
+	DMA1->IFCR = DMA_IFCR_CGIF5;
+	TIM1->CCR1 = 0;
+	TIM1->EGR = TIM_EGR_UG;								// Выход переходит в неактивное состояние
+	playing = 0;
+}
+
+/* 1 - мелодия воспроизводится */
+uint8_t buzzerIsPlaying(void)
+{
+	return playing;
+}
+
+/* Окончание мелодии: передана вторая завершающая пауза, последняя нота отзвучала (звучит первая пауза) */
+void DMA1_Channel5_IRQHandler(void)
+{
+	DMA1->IFCR = DMA_IFCR_CGIF5;
+	TIM1->CR1 &= ~TIM_CR1_CEN;
+	TIM1->DIER = 0;
+	DMA1_Channel5->CCR = 0;
+	playing = 0;
+}
@@ -0,0 +1,49 @@
+#ifndef BUZZER_H
+#define BUZZER_H
+
+#include <stdint.h>
+
+/*
+*	Зуммер на ШИМ-выходе TIM1_CH1 (порт PA8)
+*	Ноты мелодии загружаются в ARR, RCR и CCR1 пакетной передачей DMA1_Channel5 (запрос TIM1_UP),
+*	длительность ноты отсчитывается счетчиком повторений RCR, поэтому прерывания на каждую ноту не нужны
+*/
+
+#define BUZZER_TIMER_CLOCK 	1000000ul	// Частота счета таймера (1 тик = 1 мкс)
+#define BUZZER_MAX_STEPS 	96		// Максимальное количество шагов мелодии после разбиения длинных нот
+#define BUZZER_VOLUME_MAX 	8		// Максимальная громкость (коэффициент заполнения 50 %)
+
+/* Периоды нот (мкс) */
+#define NOTE_REST 	0
+#define NOTE_B3 	4050
+#define NOTE_C4 	3822
+#define NOTE_D4 	3405
+#define NOTE_E4 	3034
+#define NOTE_F4 	2863
+#define NOTE_FS4 	2703
+#define NOTE_G4 	2551
+#define NOTE_GS4 	2408
+#define NOTE_A4 	2273
+#define NOTE_B4 	2025
+#define NOTE_C5 	1911
+#define NOTE_E5 	1517
+#define NOTE_A5 	1136
+
+typedef struct buzzer_note_tag{	// Нота мелодии (хранится во flash)
+	uint16_t period;			// Период (мкс), NOTE_REST - пауза
+	uint16_t duration;			// Длительность (мс)
+} buzzer_note;
+
+typedef enum buzzer_tune_tag{	// Мелодии
+	BUZZER_TUNE_BEEP,			// Короткие сигналы
+	BUZZER_TUNE_SCALE,			// Гамма
+	BUZZER_TUNE_CHIME,			// Вестминстерский перезвон
+	BUZZER_TUNES
+} buzzer_tune;
+
+void Buzzer_Init(void);									// Настройка TIM1 и DMA
+void buzzerPlay(uint8_t tune, uint8_t volume, uint8_t loop);	// Запуск мелодии (loop = 1 - повторять до остановки)
+void buzzerStop(void);									// Остановка воспроизведения
+uint8_t buzzerIsPlaying(void);							// 1 - мелодия воспроизводится
+
+#endif /* BUZZER_H */
@@ -0,0 +1,145 @@
+#include "calendar.h"
+
+/*
+*	Календарь (григорианский) для часов
+*	Текущая дата обновляется инкрементно (без деления) раз в сутки по таблицам длин месяцев,
+*	преобразования дни <-> дата выполняются только при установке времени и используют
+*	исключительно 32-битную арифметику: деления на константы компилятор заменяет умножением (UMULL),
+*	64-битное деление (__aeabi_uldivmod) не используется
+*/
+
+#define DAYS_0001_TO_EPOCH 	719162ul	// Количество дней от 01.01.0001 до 01.01.1970
+#define DAYS_0000_03_TO_EPOCH 	719468ul	// Количество дней от 01.03.0000 до 01.01.1970
+#define DAYS_PER_ERA 		146097ul	// Количество дней в 400-летнем цикле
+
+static const uint8_t monthDays[2][12] = {						// Длины месяцев (обычный и високосный год)
+	{31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31},
+	{31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31}
+};
+
+static const uint16_t daysBeforeMonth[2][12] = {				// Количество дней от начала года до начала месяца
+	{0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334},
+	{0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335}
+};
+
+/*
+*	Проверка високосного года
+*	Для кратных 100 лет условие "кратен 400" равносильно "кратен 16", поэтому деление остается только одно (на константу 100)
+*/
+uint8_t isLeapYear(uint16_t year)
+{
+	if(year & 3)
+	{
+		return 0;
+	}
+	if(year % 100)
+	{
+		return 1;
+	}
+	return (year & 15) == 0;
+}
+
+/* Количество дней в месяце (месяц: 1...12) */
+uint8_t daysInMonth(uint16_t year, uint8_t month)
+{
+	return monthDays[isLeapYear(year)][month - 1];
+}
+
+/*
+*	Увеличение времени на 1 секунду
+*	Возвращает 1 при переходе через полночь (необходимо перейти к следующему дню)
+*/
+uint8_t timeTick(time *p_time)
+{
+	if(++p_time->seconds < 60)
+	{
+		return 0;
+	}
+	p_time->seconds = 0;
+
+	if(++p_time->minutes < 60)
+	{
+		return 0;
+	}
+	p_time->minutes = 0;
+
+	if(++p_time->hours < 24)
+	{
+		return 0;
+	}
+	p_time->hours = 0;
+	return 1;
+}
+
+/* Переход к следующему дню (смена дня недели, месяца и года по таблице длин месяцев) */
+void dateNextDay(date *p_date)
+{
+	if(++p_date->weekday > 6)
+	{
+		p_date->weekday = 0;
+	}
+
+	if(++p_date->day <= daysInMonth(p_date->year, p_date->month))
+	{
+		return;
+	}
+	p_date->day = 1;
+
+	if(++p_date->month <= 12)
+	{
+		return;
+	}
+	p_date->month = 1;
+	p_date->year++;
+}
+
+/* Преобразование даты в количество дней от 01.01.1970 */
+uint32_t dateToDays(const date *p_date)
+{
+	uint32_t years = p_date->year - 1u;										// Количество полных лет до начала года
+	uint32_t days = years * 365u + years / 4u - years / 100u + years / 400u;	// Дни от 01.01.0001 до начала года
+
+	days += daysBeforeMonth[isLeapYear(p_date->year)][p_date->month - 1u] + p_date->day - 1u;
+	return days - DAYS_0001_TO_EPOCH;
+}
+
+/*
+*	Преобразование количества дней от 01.01.1970 в дату
+*	Год отсчитывается от 1 марта, чтобы 29 февраля оказалось последним днем года,
+*	тогда длины "месяцев" (март...февраль) описываются формулой (153 * m + 2) / 5
+*/
+void daysToDate(uint32_t days, date *p_date)
+{
+	uint32_t dayNumber = days + DAYS_0000_03_TO_EPOCH;					// Дни от 01.03.0000
+	uint32_t era = dayNumber / DAYS_PER_ERA;							// Номер 400-летнего цикла
+	uint32_t dayOfEra = dayNumber - era * DAYS_PER_ERA;					// День внутри цикла (0...146096)
+	uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460u + dayOfEra / 36524u - dayOfEra / 146096u) / 365u;
+	uint32_t dayOfYear = dayOfEra - (365u * yearOfEra + yearOfEra / 4u - yearOfEra / 100u);	// День от 1 марта (0...365)
+	uint32_t monthIndex = (5u * dayOfYear + 2u) / 153u;					// Месяц от марта (0...11)
+
+	p_date->day = (uint8_t)(dayOfYear - (153u * monthIndex + 2u) / 5u + 1u);
+	p_date->month = (uint8_t)(monthIndex < 10u ? monthIndex + 3u : monthIndex - 9u);
+	p_date->year = (uint16_t)(yearOfEra + era * 400u + (p_date->month <= 2u));
+	p_date->weekday = (uint8_t)((days + CALENDAR_EPOCH_WEEKDAY) % 7u);
+}
+
+/* Преобразование даты и времени в количество секунд от 01.01.1970 00:00:00 */
+uint32_t dateTimeToSeconds(const date *p_date, const time *p_time)
+{
+	return dateToDays(p_date) * SECONDS_PER_DAY + p_time->hours * 3600ul + p_time->minutes * 60ul + p_time->seconds;
+}
+
+/* Преобразование количества секунд от 01.01.1970 00:00:00 в дату и время */
+void secondsToDateTime(uint32_t seconds, date *p_date, time *p_time)
+{
+	uint32_t days = seconds / SECONDS_PER_DAY;							// 32-битное деление на константу
+	uint32_t secondOfDay = seconds - days * SECONDS_PER_DAY;
+	uint32_t hours = secondOfDay / 3600u;
+	uint32_t secondOfHour = secondOfDay - hours * 3600u;
+	uint32_t minutes = secondOfHour / 60u;
+
+	p_time->hours = (uint8_t)hours;
+	p_time->minutes = (uint8_t)minutes;
+	p_time->seconds = (uint8_t)(secondOfHour - minutes * 60u);
+	daysToDate(days, p_date);
+}
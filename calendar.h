@@ -0,0 +1,32 @@
+#ifndef CALENDAR_H
+#define CALENDAR_H
+
+#include <stdint.h>
+
+#define CALENDAR_EPOCH_YEAR 	1970		// Год начала отсчета (01.01.1970 - четверг)
+#define CALENDAR_EPOCH_WEEKDAY 	3			// День недели начала отсчета (0 - понедельник ... 6 - воскресенье)
+#define SECONDS_PER_DAY 		86400ul		// Количество секунд в сутках
+
+typedef struct time_tag{	// Структура для хранения времени часов и будильника
+	uint8_t seconds;
+	uint8_t minutes;
+	uint8_t hours;
+} time;
+
+typedef struct date_tag{	// Структура для хранения даты
+	uint16_t year;			// Год (1970...2105 при 32-битном счетчике секунд)
+	uint8_t month;			// Месяц (1...12)
+	uint8_t day;			// День месяца (1...31)
+	uint8_t weekday;		// День недели (0 - понедельник ... 6 - воскресенье)
+} date;
+
+uint8_t isLeapYear(uint16_t year);									// Проверка високосного года
+uint8_t daysInMonth(uint16_t year, uint8_t month);					// Количество дней в месяце
+uint8_t timeTick(time *p_time);										// Увеличение времени на 1 секунду (возвращает 1 при переходе через полночь)
+void dateNextDay(date *p_date);										// Переход к следующему дню
+uint32_t dateToDays(const date *p_date);							// Дата -> дни от начала отсчета
+void daysToDate(uint32_t days, date *p_date);						// Дни от начала отсчета -> дата
+uint32_t dateTimeToSeconds(const date *p_date, const time *p_time);	// Дата и время -> секунды от начала отсчета
+void secondsToDateTime(uint32_t seconds, date *p_date, time *p_time);	// Секунды от начала отсчета -> дата и время
+
+#endif /* CALENDAR_H */
@@ -0,0 +1,135 @@
+#include "stm32f10x.h"
+#include "calibration.h"
+#include "timebase.h"
+#include "temperature.h"
+#include "critical.h"
+
+#define CALIBRATION_TIMEOUT 	2000000ul	// Ограничение ожидания запуска LSE (около 1 с) и готовности RTC
+
+calibration_stats calibrationStats;
+
+static int32_t windowDeviation;		// Сумма отклонений за окно (такты TIM2)
+
+/* Ожидание завершения записи в регистры RTC (с ограничением времени) */
+static void calibrationWaitRtc(void)
+{
+	uint32_t timeout = CALIBRATION_TIMEOUT;
+
+	while(!(RTC->CRL & RTC_CRL_RTOFF) && --timeout);
+}
+
+/* Сохранение поправки и температуры калибровки в резервных регистрах */
+static void calibrationStore(int32_t trim, int16_t celsius)
+{
+	BKP->DR2 = (uint16_t)trim;
+	BKP->DR3 = (uint16_t)((uint32_t)trim >> 16);
+	BKP->DR4 = (uint16_t)celsius;
+	BKP->DR1 = trim ? CALIBRATION_SIGNATURE : 0;
+}
+
+/*
+*	Запуск LSE и RTC (делитель 32768 - секундный импульс), вывод секундного импульса на PC13,
+*	загрузка сохраненной поправки хода. Резервная область не сбрасывается при сбросе процессора,
+*	поэтому RTC настраивается только при первом включении
+*/
+void Calibration_Init(void)
+{
+	uint32_t timeout = CALIBRATION_TIMEOUT;
+
+	RCC->APB1ENR |= RCC_APB1ENR_PWREN | RCC_APB1ENR_BKPEN;						// Включение тактирования PWR и BKP
+	PWR->CR |= PWR_CR_DBP;														// Разрешение записи в резервную область
+
+	if(!(RCC->BDCR & RCC_BDCR_RTCEN))
+	{
+		RCC->BDCR |= RCC_BDCR_LSEON;
+		while(!(RCC->BDCR & RCC_BDCR_LSERDY) && --timeout);						// Без LSE калибровка возможна только по GPS
+		if(RCC->BDCR & RCC_BDCR_LSERDY)
+		{
+			RCC->BDCR |= RCC_BDCR_RTCSEL_LSE | RCC_BDCR_RTCEN;
+			calibrationWaitRtc();
+			RTC->CRL |= RTC_CRL_CNF;											// Режим настройки RTC
+			RTC->PRLH = 0;
+			RTC->PRLL = 32768 - 1;
+			RTC->CRL &= ~RTC_CRL_CNF;
+			calibrationWaitRtc();
+		}
+	}
+	BKP->RTCCR = BKP_RTCCR_ASOE | BKP_RTCCR_ASOS;								// Секундный импульс RTC на выходе PC13
+
+	if(BKP->DR1 == CALIBRATION_SIGNATURE)
+	{
+		calibrationStats.trim = (int32_t)((uint32_t)BKP->DR2 | ((uint32_t)BKP->DR3 << 16));
+		calibrationStats.temperature = (int16_t)BKP->DR4;
+		timebaseSetRate(TIMEBASE_CALIBRATION, calibrationStats.trim);
+		temperatureSetReference(calibrationStats.temperature);				// Термокомпенсация отсчитывается от температуры калибровки
+	}
+}
+
+/* Начало калибровки: новая поправка вычисляется по окончании окна */
+void calibrationStart(void)
+{
+	uint32_t basepri;
+
+	basepri = criticalEnter(BOARD_LEVEL_TIME);
+	windowDeviation = 0;
+	calibrationStats.seconds = 0;
+	calibrationStats.state = CALIBRATION_RUNNING;
+	criticalExit(basepri);
+}
+
+/* Удаление сохраненной поправки */
+void calibrationClear(void)
+{
+	uint32_t basepri;
+
+	basepri = criticalEnter(BOARD_LEVEL_TIME);
+	calibrationStore(0, TEMPERATURE_TURNOVER);
+	calibrationStats.trim = 0;
+	calibrationStats.temperature = TEMPERATURE_TURNOVER;
+	temperatureSetReference(TEMPERATURE_TURNOVER);
+	calibrationStats.residual = calibrationStats.error;
+	calibrationStats.state = CALIBRATION_IDLE;
+	timebaseSetRate(TIMEBASE_CALIBRATION, 0);
+	criticalExit(basepri);
+}
+
+/*
+*	Интервал между опорными импульсами: seconds секунд плюс deviation тактов TIM2
+*	По окончании окна ошибка HSE = сумма отклонений / длительность окна (1 такт за секунду = 31.25 ppb)
+*/
+void calibrationInterval(uint8_t seconds, int32_t deviation)
+{
+	int32_t error;
+
+	if(calibrationStats.state == CALIBRATION_IDLE)
+	{
+		return;
+	}
+	windowDeviation += deviation;
+	calibrationStats.seconds += seconds;
+	if(calibrationStats.seconds < CALIBRATION_WINDOW)
+	{
+		return;
+	}
+
+	error = windowDeviation * 25l / (int32_t)calibrationStats.seconds * 5l / 4l;	// Без переполнения при ошибке до 1000 ppm
+	windowDeviation = 0;
+	calibrationStats.seconds = 0;
+	if(error > CALIBRATION_MAX_ERROR || error < -CALIBRATION_MAX_ERROR)
+	{
+		return;
+	}
+	calibrationStats.error = error;
+	calibrationStats.windows++;
+
+	if(calibrationStats.state == CALIBRATION_RUNNING)							// Первое окно - новая поправка
+	{
+		calibrationStats.trim = -error;
+		calibrationStats.temperature = temperatureGet();
+		calibrationStore(calibrationStats.trim, calibrationStats.temperature);
+		timebaseSetRate(TIMEBASE_CALIBRATION, calibrationStats.trim);
+		temperatureSetReference(calibrationStats.temperature);
+		calibrationStats.state = CALIBRATION_DONE;
+	}
+	calibrationStats.residual = error + calibrationStats.trim;					// TIM2 считает без поправки, поэтому остаток - сумма ошибки и поправки
+}
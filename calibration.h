@@ -0,0 +1,41 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <stdint.h>
+
+/*
+*	Калибровка кварца HSE по опорному секундному импульсу на входе захвата PA0 (TIM2_CH1):
+*	1PPS приемника GPS или секундный импульс RTC от кварца LSE 32768 Гц (выход PC13, соединяется с PA0 перемычкой).
+*	Отклонения числа тактов TIM2 между импульсами суммируются за окно CALIBRATION_WINDOW секунд,
+*	результат сохраняется в резервных регистрах BKP (питание VBAT) и применяется как поправка хода при запуске.
+*	Точность калибровки по LSE ограничена точностью самого LSE (обычно +-20 ppm при 25 C)
+*/
+
+#define CALIBRATION_WINDOW 		1024		// Окно измерения (секунды)
+#define CALIBRATION_MAX_ERROR 	1000000l	// Допустимая ошибка HSE (ppb), большие значения отбрасываются
+#define CALIBRATION_SIGNATURE 	0xCA1Bu		// Признак сохраненной калибровки в BKP->DR1
+
+typedef enum calibration_state_tag{	// Состояние калибровки
+	CALIBRATION_IDLE,
+	CALIBRATION_RUNNING,				// Идет первое окно измерения
+	CALIBRATION_DONE					// Поправка вычислена и сохранена, измерение остатка продолжается
+} calibration_state;
+
+typedef struct calibration_stats_tag{	// Результаты калибровки
+	uint8_t state;
+	uint16_t seconds;					// Секунд в текущем окне
+	int32_t trim;						// Сохраненная поправка хода (ppb)
+	int16_t temperature;				// Температура при калибровке (0.01 C)
+	int32_t error;						// Ошибка HSE за последнее окно (ppb, > 0 - кварц спешит)
+	int32_t residual;					// Остаточная ошибка хода часов с поправкой (ppb)
+	uint16_t windows;					// Завершенных окон
+} calibration_stats;
+
+extern calibration_stats calibrationStats;
+
+void Calibration_Init(void);						// Запуск LSE и RTC, загрузка сохраненной поправки
+void calibrationStart(void);						// Начало калибровки (новая поправка по окончании окна)
+void calibrationClear(void);						// Удаление сохраненной поправки
+void calibrationInterval(uint8_t seconds, int32_t deviation);	// Интервал между опорными импульсами (вызывается из прерывания TIM2)
+
+#endif /* CALIBRATION_H */
@@ -0,0 +1,271 @@
+#include "stm32f10x.h"
+#include "cansync.h"
+#include "timebase.h"
+#include "critical.h"
+
+
+#define CANSYNC_CLOCK 		32000000ul		// Частота APB1
+#define CANSYNC_TQ 			16ul			// Квантов в бите: 1 (синхронизация) + 13 (BS1) + 2 (BS2), выборка в 87.5% бита
+#define CANSYNC_PRESCALER 	(CANSYNC_CLOCK / (CANSYNC_BITRATE * CANSYNC_TQ))
+#define CANSYNC_TIMEOUT 	100000ul		// Ограничение ожидания перехода в режим инициализации и обратно
+
+#if CANSYNC_PRESCALER * CANSYNC_BITRATE * CANSYNC_TQ != CANSYNC_CLOCK
+#error "CANSYNC_BITRATE is not reachable from the APB1 clock"
+#endif
+
+cansync_stats cansyncStats;
+
+static uint8_t nodeRole;			// Роль узла
+static uint8_t seconds;				// Отсчет периода синхронизации
+static uint8_t sequence;			// Номер последнего SYNC
+static uint8_t followUpDue;			// Ведущий: SYNC передан в почтовый ящик, ждет отметки времени
+static uint8_t syncValid;			// Ведомый: принят SYNC, ожидается FOLLOW_UP
+static uint8_t locked;				// Ведомый: время установлено, дальше только плавная подстройка
+static uint8_t syncSequence;		// Номер принятого SYNC
+static uint32_t syncSeconds;		// Момент приема SYNC по местным часам
+static uint16_t syncMilliseconds;
+static int32_t rate;				// Интегральная составляющая подстройки частоты (ppb)
+
+/* Передача кадра через почтовый ящик 0 (данные в порядке младший байт первым) */
+static void canSyncTransmit(uint16_t id, const uint8_t *p_data, uint8_t length)
+{
+	uint32_t low = 0, high = 0;
+	uint8_t i;
+
+	for(i = 0; i < length; i++)
+	{
+		if(i < 4)
+		{
+			low |= (uint32_t)p_data[i] << (8 * i);
+		}
+		else
+		{
+			high |= (uint32_t)p_data[i] << (8 * (i - 4));
+		}
+	}
+	CAN1->sTxMailBox[0].TDTR = length;
+	CAN1->sTxMailBox[0].TDLR = low;
+	CAN1->sTxMailBox[0].TDHR = high;
+	CAN1->sTxMailBox[0].TIR = ((uint32_t)id << 21) | CAN_TI0R_TXRQ;
+}
+
+/* Настройка bxCAN (500 кбит/с), фильтра приема SYNC/FOLLOW_UP в FIFO0 и прерываний */
+void CanSync_Init(void)
+{
+	uint32_t timeout = CANSYNC_TIMEOUT;
+
+	RCC->APB1ENR |= RCC_APB1ENR_CAN1EN;											// Включение тактирования CAN
+
+	CAN1->MCR = CAN_MCR_INRQ;													// Режим инициализации
+	while(!(CAN1->MSR & CAN_MSR_INAK) && --timeout);
+
+	CAN1->BTR = (1ul << 20) | (12ul << 16) | (CANSYNC_PRESCALER - 1)			// BS2 = 2, BS1 = 13, SJW = 1
+#if CANSYNC_TEST_MODE
+		| CAN_BTR_LBKM | CAN_BTR_SILM
+#endif
+		;
+
+	CAN1->FMR |= CAN_FMR_FINIT;													// Фильтр 0: список из двух 11-битных идентификаторов
+	CAN1->FA1R &= ~CAN_FA1R_FACT0;
+	CAN1->FM1R |= CAN_FM1R_FBM0;
+	CAN1->FS1R &= ~CAN_FS1R_FSC0;
+	CAN1->FFA1R &= ~CAN_FFA1R_FFA0;
+	CAN1->sFilterRegister[0].FR1 = ((uint32_t)CANSYNC_ID_FOLLOW_UP << 21) | ((uint32_t)CANSYNC_ID_SYNC << 5);
+	CAN1->sFilterRegister[0].FR2 = CAN1->sFilterRegister[0].FR1;
+	CAN1->FA1R |= CAN_FA1R_FACT0;
+	CAN1->FMR &= ~CAN_FMR_FINIT;
+
+	CAN1->MCR = CAN_MCR_ABOM;													// Выход из инициализации, автоматическое восстановление после Bus-Off
+	timeout = CANSYNC_TIMEOUT;
+	while((CAN1->MSR & CAN_MSR_INAK) && --timeout);
+
+	CAN1->IER = CAN_IER_TMEIE | CAN_IER_FMPIE0;
+	NVIC_EnableIRQ(USB_HP_CAN1_TX_IRQn);
+	NVIC_EnableIRQ(USB_LP_CAN1_RX0_IRQn);
+}
+
+/* Выбор роли узла (подстройка частоты при смене роли сбрасывается) */
+void canSyncSetRole(uint8_t role)
+{
+	uint32_t basepri;
+
+	basepri = criticalEnter(BOARD_LEVEL_TIME);
+	nodeRole = role;
+	seconds = 0;
+	followUpDue = 0;
+	syncValid = 0;
+	locked = 0;
+	rate = 0;
+	cansyncStats.rate = 0;
+	timebaseSetRate(TIMEBASE_DISCIPLINE, 0);
+	timebaseSetOffset(0);
+	criticalExit(basepri);
+}
+
+/* Текущая роль узла */
+uint8_t canSyncGetRole(void)
+{
+	return nodeRole;
+}
+
+/* Отсчет периода синхронизации: ведущий передает SYNC (вызывается из прерывания TIM3) */
+void canSyncSecond(void)
+{
+	uint8_t data;
+
+	if(nodeRole != CANSYNC_MASTER || ++seconds < CANSYNC_PERIOD)
+	{
+		return;
+	}
+	seconds = 0;
+	if(!(CAN1->TSR & CAN_TSR_TME0))
+	{
+		cansyncStats.lost++;													// Предыдущий кадр еще не передан (нет ведомых или шина занята)
+		return;
+	}
+	data = ++sequence;
+	followUpDue = 1;
+	canSyncTransmit(CANSYNC_ID_SYNC, &data, 1);
+	cansyncStats.syncs++;
+}
+
+/*
+*	Завершение передачи: момент отправки SYNC фиксируется по местным часам и передается в FOLLOW_UP
+*	Задержки от конца кадра до входа в прерывание на ведущем и ведомом одного порядка и взаимно компенсируются
+*/
+void USB_HP_CAN1_TX_IRQHandler(void)
+{
+	uint32_t status = CAN1->TSR;
+	uint32_t now;
+	uint16_t milliseconds;
+	uint8_t data[7];
+	uint8_t due;
+	uint32_t basepri;
+
+	CAN1->TSR = CAN_TSR_RQCP0;													// Снятие флагов завершения запроса (запись 1)
+	basepri = criticalEnter(BOARD_LEVEL_TIME);									// SYNC передается из прерывания TIM3, которое вытесняет обмен
+	due = (status & CAN_TSR_RQCP0) && followUpDue;
+	if(due)
+	{
+		followUpDue = 0;
+	}
+	data[0] = sequence;
+	criticalExit(basepri);
+	if(!due)
+	{
+		return;
+	}
+	if(!(status & CAN_TSR_TXOK0))
+	{
+		cansyncStats.lost++;
+		return;
+	}
+
+	ClockNow(&now, &milliseconds);
+	data[1] = (uint8_t)now;
+	data[2] = (uint8_t)(now >> 8);
+	data[3] = (uint8_t)(now >> 16);
+	data[4] = (uint8_t)(now >> 24);
+	data[5] = (uint8_t)milliseconds;
+	data[6] = (uint8_t)(milliseconds >> 8);
+	canSyncTransmit(CANSYNC_ID_FOLLOW_UP, data, 7);
+	cansyncStats.followUps++;
+}
+
+/*
+*	Подстройка по паре SYNC/FOLLOW_UP
+*	Большое рассогласование устраняется установкой времени, малое - плавной поправкой фазы,
+*	интеграл рассогласования (в пересчете на ppb за период) дает поправку частоты
+*/
+static void canSyncDiscipline(uint32_t masterSeconds, uint16_t masterMilliseconds)
+{
+	uint32_t now;
+	uint16_t milliseconds;
+	int32_t elapsed;
+	int32_t difference = (int32_t)(masterSeconds - syncSeconds);
+
+	if(difference > -1000 && difference < 1000)
+	{
+		cansyncStats.offset = difference * 1000 + (int32_t)masterMilliseconds - (int32_t)syncMilliseconds;
+	}
+	else
+	{
+		cansyncStats.offset = difference < 0 ? -1000000l : 1000000l;		// Вне диапазона - только признак направления
+	}
+
+	if(nodeRole == CANSYNC_MASTER)
+	{
+		return;																// Режим петли: ведущий только измеряет собственное рассогласование
+	}
+
+	if(!locked || cansyncStats.offset > CANSYNC_STEP_LIMIT || cansyncStats.offset < -CANSYNC_STEP_LIMIT)
+	{
+		ClockNow(&now, &milliseconds);										// Время с момента приема SYNC добавляется к времени ведущего
+		elapsed = (int32_t)(now - syncSeconds) * 1000 + (int32_t)milliseconds - (int32_t)syncMilliseconds;
+		elapsed += masterMilliseconds;
+		if(!ClockSetUtc(masterSeconds + (uint32_t)(elapsed / 1000), (uint16_t)(elapsed % 1000)))
+		{
+			return;															// Идет настройка часов - установка при следующем SYNC
+		}
+		timebaseSetOffset(0);
+		locked = 1;
+		cansyncStats.steps++;
+		return;
+	}
+
+	rate += cansyncStats.offset * (1000000l / CANSYNC_PERIOD) / (1l << CANSYNC_RATE_SHIFT);
+	if(rate > TIMEBASE_MAX_RATE)
+	{
+		rate = TIMEBASE_MAX_RATE;
+	}
+	if(rate < -TIMEBASE_MAX_RATE)
+	{
+		rate = -TIMEBASE_MAX_RATE;
+	}
+	cansyncStats.rate = rate;
+	timebaseSetRate(TIMEBASE_DISCIPLINE, rate);
+	timebaseSetOffset(cansyncStats.offset);
+}
+
+/* Прием кадров SYNC/FOLLOW_UP из FIFO0 */
+void USB_LP_CAN1_RX0_IRQHandler(void)
+{
+	uint32_t id, low, high;
+
+	while(CAN1->RF0R & CAN_RF0R_FMP0)
+	{
+		id = CAN1->sFIFOMailBox[0].RIR >> 21;
+		low = CAN1->sFIFOMailBox[0].RDLR;
+		high = CAN1->sFIFOMailBox[0].RDHR;
+		CAN1->RF0R = CAN_RF0R_RFOM0;											// Освобождение почтового ящика FIFO
+
+		if(nodeRole == CANSYNC_OFF || (nodeRole == CANSYNC_MASTER && !CANSYNC_TEST_MODE))
+		{
+			continue;
+		}
+		if(id == CANSYNC_ID_SYNC)
+		{
+			ClockNow(&syncSeconds, &syncMilliseconds);						// Момент приема фиксируется первым делом
+			syncSequence = (uint8_t)low;
+			syncValid = 1;
+			if(nodeRole == CANSYNC_SLAVE)
+			{
+				cansyncStats.syncs++;
+			}
+		}
+		else if(id == CANSYNC_ID_FOLLOW_UP)
+		{
+			if(!syncValid || (uint8_t)low != syncSequence)
+			{
+				cansyncStats.lost++;
+				continue;
+			}
+			syncValid = 0;
+			if(nodeRole == CANSYNC_SLAVE)
+			{
+				cansyncStats.followUps++;
+			}
+			canSyncDiscipline((low >> 8) | (high << 24), (uint16_t)(high >> 8));
+		}
+	}
+}
@@ -0,0 +1,43 @@
+#ifndef CANSYNC_H
+#define CANSYNC_H
+
+#include <stdint.h>
+
+/*
+*	Синхронизация времени по CAN (bxCAN, PB8 - RX, PB9 - TX), двухшаговая схема:
+*	ведущий раз в CANSYNC_PERIOD секунд передает SYNC, по прерыванию завершения передачи фиксирует
+*	момент отправки и передает его в FOLLOW_UP; ведомые фиксируют момент приема SYNC и по разности
+*	подстраивают фазу и частоту хода часов (timebase). Нагрузка на шину - 2 кадра за период при любом числе узлов
+*/
+
+#define CANSYNC_BITRATE 		500000ul	// Скорость шины (бит/с)
+#define CANSYNC_ID_SYNC 		0x080		// Идентификатор кадра SYNC (высокий приоритет)
+#define CANSYNC_ID_FOLLOW_UP 	0x081		// Идентификатор кадра FOLLOW_UP
+#define CANSYNC_PERIOD 			4			// Период синхронизации (секунды)
+#define CANSYNC_STEP_LIMIT 		100			// Рассогласование, при котором время устанавливается скачком (мс)
+#define CANSYNC_RATE_SHIFT 		4			// Коэффициент интегральной составляющей подстройки частоты (1 / 2^n)
+#define CANSYNC_TEST_MODE 		0			// 1 - режим петли и молчания (кадры не выходят на шину и принимаются самим узлом)
+
+typedef enum cansync_role_tag{	// Роль узла
+	CANSYNC_OFF,
+	CANSYNC_MASTER,				// Ведущий - источник времени
+	CANSYNC_SLAVE				// Ведомый - подстраивает часы
+} cansync_role;
+
+typedef struct cansync_stats_tag{	// Статистика синхронизации
+	uint16_t syncs;				// Переданные (ведущий) или принятые (ведомый) SYNC
+	uint16_t followUps;			// Переданные или принятые FOLLOW_UP
+	uint16_t lost;				// Ошибки передачи и FOLLOW_UP без парного SYNC
+	uint16_t steps;				// Установки времени скачком
+	int32_t offset;				// Последнее рассогласование с ведущим (мс, > 0 - ведомый отстает)
+	int32_t rate;				// Поправка частоты (ppb)
+} cansync_stats;
+
+extern cansync_stats cansyncStats;
+
+void CanSync_Init(void);				// Настройка bxCAN и фильтра приема
+void canSyncSetRole(uint8_t role);		// Выбор роли узла
+uint8_t canSyncGetRole(void);			// Текущая роль узла
+void canSyncSecond(void);				// Отсчет периода синхронизации (вызывается из прерывания TIM3)
+
+#endif /* CANSYNC_H */
@@ -0,0 +1,210 @@
+#include "stm32f10x.h"
+#include "clocksource.h"
+#include "timebase.h"
+#include "trace.h"
+#include "critical.h"
+
+#define CLOCK_PLL_HSE 	(RCC_CFGR_PLLSRC_HSE | RCC_CFGR_PLLMULL4)			// 8 МГц * 4 = 32 МГц
+#define CLOCK_PLL_HSI 	(RCC_CFGR_PLLSRC_HSI_Div2 | RCC_CFGR_PLLMULL8)		// 8 МГц / 2 * 8 = 32 МГц
+#define CLOCK_LSE_HZ 	32768ul												// Частота LSE (тактирование RTC)
+
+clock_stats clockStats;
+
+static uint8_t stableSeconds;		// Секунд подряд с готовым HSE (при работе от HSI)
+static uint8_t windowSeconds;		// Секунд в окне измерения HSI
+static uint32_t windowStart;		// Отсчет LSE в начале окна
+
+/* Ожидание состояния бита с ограничением числа итераций (1 - дождались) */
+static uint8_t clockWait(volatile uint32_t *p_register, uint32_t mask, uint32_t value)
+{
+	uint32_t timeout = CLOCK_TIMEOUT;
+
+	while((*p_register & mask) != value)
+	{
+		if(!--timeout)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/*
+*	Перезапуск PLL от нового источника
+*	На время перенастройки SYSCLK переводится на HSI; если PLL не запустился, работа продолжается от HSI
+*/
+static uint8_t clockSwitchPll(uint32_t pllConfig)
+{
+	RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_HSI;
+	clockWait(&RCC->CFGR, RCC_CFGR_SWS, RCC_CFGR_SWS_HSI);
+	RCC->CR &= ~RCC_CR_PLLON;
+
+	RCC->CFGR = (RCC->CFGR & ~(RCC_CFGR_PLLSRC | RCC_CFGR_PLLXTPRE | RCC_CFGR_PLLMULL)) | pllConfig;
+	RCC->CR |= RCC_CR_PLLON;
+	if(!clockWait(&RCC->CR, RCC_CR_PLLRDY, RCC_CR_PLLRDY))
+	{
+		RCC->CR &= ~RCC_CR_PLLON;
+		return 0;
+	}
+	RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_PLL;
+	return clockWait(&RCC->CFGR, RCC_CFGR_SWS, RCC_CFGR_SWS_PLL);
+}
+
+/* Переход на HSI: PLL от HSI / 2, при неудаче - HSI напрямую; отказ учитывается в BKP->DR5 */
+static void clockFallback(void)
+{
+	uint32_t now;
+	uint16_t milliseconds;
+
+	clockStats.source = clockSwitchPll(CLOCK_PLL_HSI) ? CLOCK_HSI_PLL : CLOCK_HSI;
+	traceEvent(TRACE_CLOCK, clockStats.source);
+	SystemCoreClockUpdate();
+	TIM3_Retune();
+
+	RCC->CR |= RCC_CR_HSEON;													// CSS выключает HSE - повторный запуск для проверки восстановления
+	timebaseSetRate(TIMEBASE_OSCILLATOR, clockStats.hsiRate);					// Начальная оценка - поправка с прошлой работы от HSI
+	stableSeconds = 0;
+	windowSeconds = 0;
+	ClockNow(&now, &milliseconds);
+	clockStats.lastFailure = now;
+	BKP->DR5 = (uint16_t)(BKP->DR5 + 1);
+	clockStats.failures = (uint16_t)BKP->DR5;
+}
+
+/*
+*	Запуск тактирования: HSE (bypass) * 4 = 32 МГц, HCLK = SYSCLK, APB1 = HCLK, APB2 = HCLK / 4
+*	Без сигнала HSE ожидание ограничено по времени и часы запускаются от HSI
+*/
+void clockStart(void)
+{
+	RCC->APB1ENR |= RCC_APB1ENR_PWREN | RCC_APB1ENR_BKPEN;						// Счетчик отказов хранится в резервной области
+	PWR->CR |= PWR_CR_DBP;
+	clockStats.failures = (uint16_t)BKP->DR5;
+
+	RCC->CFGR = RCC_CFGR_HPRE_DIV1 | RCC_CFGR_PPRE1_DIV1 | RCC_CFGR_PPRE2_DIV4;
+	RCC->CR |= RCC_CR_HSEBYP;													// Внешний сигнал без кварцевого генератора
+	RCC->CR |= RCC_CR_HSEON;
+	if(clockWait(&RCC->CR, RCC_CR_HSERDY, RCC_CR_HSERDY) && clockSwitchPll(CLOCK_PLL_HSE))
+	{
+		clockStats.source = CLOCK_HSE;
+		RCC->CR |= RCC_CR_CSSON;												// Контроль HSE: при отказе - NMI
+		SystemCoreClockUpdate();
+		return;
+	}
+	clockFallback();
+}
+
+/* Отказ HSE (CSS): SYSCLK уже переключен аппаратурой на HSI, PLL выключен */
+void NMI_Handler(void)
+{
+	if(!(RCC->CIR & RCC_CIR_CSSF))
+	{
+		return;
+	}
+	RCC->CIR |= RCC_CIR_CSSC;													// Снятие флага CSS
+	clockFallback();
+}
+
+/* Отсчет LSE: секунды RTC * 32768 плюс прошедшая часть секунды (делитель считает вниз) */
+static uint32_t clockLseTicks(void)
+{
+	uint16_t high, low, divider;
+
+	do
+	{
+		high = RTC->CNTH;
+		low = RTC->CNTL;
+		divider = RTC->DIVL;
+	} while(low != RTC->CNTL);													// Секунда RTC сменилась во время чтения
+	return ((((uint32_t)high << 16) | low) << 15) + (CLOCK_LSE_HZ - 1u - divider);
+}
+
+/*
+*	Компенсация HSI и проверка восстановления HSE (раз в секунду TIM3)
+*	За CLOCK_WINDOW секунд TIM3 должно пройти CLOCK_WINDOW * 32768 тактов LSE; избыток означает, что часы отстают.
+*	Измеряются уже скорректированные секунды, поэтому поправка накапливается (интегратор).
+*	Возвращает 1, когда HSE устойчив и можно возвращаться (clockRecover вызывается задачей, не прерыванием)
+*/
+uint8_t clockSourceSecond(void)
+{
+	uint32_t ticks;
+	int32_t difference;
+
+	if(clockStats.source == CLOCK_HSE)
+	{
+		return 0;
+	}
+
+	if(RCC->BDCR & RCC_BDCR_LSERDY)
+	{
+		ticks = clockLseTicks();
+		if(windowSeconds && windowSeconds >= CLOCK_WINDOW)
+		{
+			difference = (int32_t)(ticks - windowStart - CLOCK_WINDOW * CLOCK_LSE_HZ);	// 1 такт за окно = 1e9 / 2^19 ppb
+			clockStats.hsiRate += difference * 15625l / 1024l * 125l;
+			if(clockStats.hsiRate > TIMEBASE_MAX_RATE)
+			{
+				clockStats.hsiRate = TIMEBASE_MAX_RATE;
+			}
+			if(clockStats.hsiRate < -TIMEBASE_MAX_RATE)
+			{
+				clockStats.hsiRate = -TIMEBASE_MAX_RATE;
+			}
+			timebaseSetRate(TIMEBASE_OSCILLATOR, clockStats.hsiRate);
+			windowSeconds = 0;
+		}
+		if(!windowSeconds)
+		{
+			windowStart = ticks;
+		}
+		windowSeconds++;
+	}
+
+	if(!(RCC->CR & RCC_CR_HSERDY))
+	{
+		stableSeconds = 0;
+		return 0;
+	}
+	if(stableSeconds < CLOCK_RECOVERY_SECONDS)
+	{
+		stableSeconds++;
+	}
+	return stableSeconds >= CLOCK_RECOVERY_SECONDS;
+}
+
+/*
+*	Возврат на HSE после CLOCK_RECOVERY_SECONDS секунд устойчивой работы (задача планировщика)
+*	Ожидание готовности PLL идет без маскирования прерываний; источник, предделитель TIM3 и поправка хода
+*	изменяются в критической секции уровня TIME, чтобы секунда TIM3 не видела их частично обновленными
+*/
+void clockRecover(void)
+{
+	uint32_t basepri, now;
+	uint16_t milliseconds;
+
+	if(clockStats.source == CLOCK_HSE || stableSeconds < CLOCK_RECOVERY_SECONDS)	// Повторный запуск или HSE пропал после запроса
+	{
+		return;
+	}
+
+	if(clockSwitchPll(CLOCK_PLL_HSE))
+	{
+		basepri = criticalEnter(BOARD_LEVEL_TIME);
+		clockStats.source = CLOCK_HSE;
+		RCC->CR |= RCC_CR_CSSON;
+		SystemCoreClockUpdate();
+		TIM3_Retune();
+		timebaseSetRate(TIMEBASE_OSCILLATOR, 0);
+		ClockNow(&now, &milliseconds);
+		clockStats.lastRecovery = now;
+		clockStats.recoveries++;
+		criticalExit(basepri);
+		traceEvent(TRACE_CLOCK, CLOCK_HSE);
+	}
+	else
+	{
+		basepri = criticalEnter(BOARD_LEVEL_TIME);
+		clockFallback();														// HSE снова пропал при переключении
+		criticalExit(basepri);
+	}
+}
@@ -0,0 +1,43 @@
+#ifndef CLOCKSOURCE_H
+#define CLOCKSOURCE_H
+
+#include <stdint.h>
+
+/*
+*	Источник тактирования с защитой от отказа HSE
+*	Штатно: HSE (внешний сигнал 8 МГц, bypass) * 4 = 32 МГц с включенной системой контроля (CSS).
+*	При отказе HSE аппаратура CSS переключает SYSCLK на HSI и вызывает NMI, обработчик запускает PLL
+*	от HSI / 2 * 8 = 32 МГц (частоты периферии сохраняются). Уход HSI (до 1%) измеряется по LSE (RTC)
+*	и компенсируется поправкой хода. HSE проверяется каждую секунду, после CLOCK_RECOVERY_SECONDS секунд
+*	устойчивой работы тактирование возвращается на HSE задачей (ожидание PLL не выполняется в прерывании TIM3)
+*/
+
+#define CLOCK_TIMEOUT 				20000ul		// Ограничение ожидания готовности HSE и PLL (итераций)
+#define CLOCK_RECOVERY_SECONDS 		8			// Время устойчивой работы HSE перед возвратом (секунды)
+#define CLOCK_WINDOW 				16			// Окно измерения частоты HSI по LSE (секунды)
+
+typedef enum clock_source_tag{	// Источник тактирования
+	CLOCK_HSE,					// HSE * 4 через PLL
+	CLOCK_HSI_PLL,				// HSI / 2 * 8 через PLL (после отказа HSE)
+	CLOCK_HSI					// HSI 8 МГц напрямую (PLL не запустился)
+} clock_source;
+
+typedef struct clock_stats_tag{	// События тактирования
+	uint8_t source;				// Текущий источник
+	uint16_t failures;			// Отказы HSE (включая отказ при запуске), счетчик сохраняется в BKP->DR5
+	uint16_t recoveries;		// Возвраты на HSE
+	uint32_t lastFailure;		// Время последнего отказа (UTC)
+	uint32_t lastRecovery;		// Время последнего возврата (UTC)
+	int32_t hsiRate;			// Поправка хода при работе от HSI (ppb)
+} clock_stats;
+
+extern clock_stats clockStats;
+
+void clockStart(void);			// Запуск тактирования при старте (с ограничением ожидания HSE)
+uint8_t clockSourceSecond(void);	// Компенсация HSI и проверка восстановления HSE (вызывается из прерывания TIM3), 1 - пора возвращаться на HSE
+void clockRecover(void);		// Возврат на HSE (задача приложения, запускается по результату clockSourceSecond)
+
+/* Реализуется приложением */
+void TIM3_Retune(void);			// Пересчет предделителя TIM3 после смены частоты SYSCLK
+
+#endif /* CLOCKSOURCE_H */
@@ -0,0 +1,293 @@
+#include "stm32f10x.h"
+#include "console.h"
+#include "critical.h"
+#include "metrics.h"
+
+console_stats consoleStats;
+
+static uint8_t rxBuffer[CONSOLE_RX_SIZE];			// Циклический буфер приема (заполняется DMA)
+static volatile uint16_t rxHead;					// Позиция записи DMA на момент последнего события
+static volatile uint16_t rxTail;					// Позиция чтения
+
+static char line[CONSOLE_LINE_SIZE];				// Собираемая команда
+static uint8_t lineLength;
+static uint8_t lineOverflow;						// Строка длиннее CONSOLE_LINE_SIZE - отбрасывается целиком
+
+static char txBuffer[2][CONSOLE_TX_SIZE];			// Буферы передачи
+static uint16_t txLength[2];						// Заполнение буферов
+static volatile uint8_t txFill;					// Номер заполняемого буфера
+static volatile uint8_t txBusy;					// Флаг передачи DMA
+static volatile uint8_t txReserved;				// Флаг записи в буфер через consoleReserve (буфер нельзя отправлять)
+
+/* Запуск передачи заполненного буфера, дальнейшее заполнение продолжается во втором буфере */
+static void consoleStartTx(void)
+{
+	uint8_t buffer = txFill;
+
+	txBusy = 1;
+	consoleStats.txBytes += txLength[buffer];
+	DMA1_Channel7->CCR = 0;
+	DMA1_Channel7->CMAR = (uint32_t)txBuffer[buffer];
+	DMA1_Channel7->CNDTR = txLength[buffer];
+	DMA1_Channel7->CCR = DMA_CCR1_DIR | DMA_CCR1_MINC | DMA_CCR1_TCIE | DMA_CCR1_EN;	// Память -> USART, 8 бит
+
+	txFill = buffer ^ 1;
+	txLength[txFill] = 0;
+}
+
+/* Настройка USART2, DMA1_Channel6 (прием, циклический режим) и DMA1_Channel7 (передача) */
+void Console_Init(void)
+{
+	RCC->APB1ENR |= RCC_APB1ENR_USART2EN;										// Включение тактирования USART2
+	RCC->AHBENR |= RCC_AHBENR_DMA1EN;											// Включение тактирования DMA
+
+	USART2->BRR = (uint16_t)((SystemCoreClock + CONSOLE_BAUDRATE / 2) / CONSOLE_BAUDRATE);	// APB1 = HCLK
+	USART2->CR3 = USART_CR3_DMAR | USART_CR3_DMAT;								// Прием и передача через DMA
+
+	DMA1_Channel6->CPAR = (uint32_t)&USART2->DR;
+	DMA1_Channel6->CMAR = (uint32_t)rxBuffer;
+	DMA1_Channel6->CNDTR = CONSOLE_RX_SIZE;
+	DMA1_Channel6->CCR = DMA_CCR1_MINC | DMA_CCR1_CIRC | DMA_CCR1_HTIE | DMA_CCR1_TCIE | DMA_CCR1_EN;	// USART -> память, по кругу
+
+	DMA1_Channel7->CPAR = (uint32_t)&USART2->DR;
+
+	USART2->CR1 = USART_CR1_UE | USART_CR1_TE | USART_CR1_RE | USART_CR1_IDLEIE;	// Прерывание только по концу посылки
+	NVIC_EnableIRQ(USART2_IRQn);
+	NVIC_EnableIRQ(DMA1_Channel6_IRQn);
+	NVIC_EnableIRQ(DMA1_Channel7_IRQn);
+}
+
+/*
+*	Фиксация позиции записи DMA (конец посылки, половина или конец буфера)
+*	Принятое сверх свободного места затирает еще не разобранные данные - считается переполнением
+*/
+static void consoleRxEvent(void)
+{
+	uint16_t head = (uint16_t)(CONSOLE_RX_SIZE - DMA1_Channel6->CNDTR);
+	uint16_t received, pending;
+
+	if(head == CONSOLE_RX_SIZE)
+	{
+		head = 0;
+	}
+	received = (uint16_t)((head - rxHead + CONSOLE_RX_SIZE) % CONSOLE_RX_SIZE);
+	pending = (uint16_t)((rxHead - rxTail + CONSOLE_RX_SIZE) % CONSOLE_RX_SIZE);
+	if(pending + received >= CONSOLE_RX_SIZE)
+	{
+		consoleStats.rxOverflows++;
+		METRIC_ADD(queueOverflows, 1);
+	}
+	consoleStats.rxBytes += received;
+	rxHead = head;
+}
+
+/* Линия свободна - посылка принята (ошибка переполнения USART снимается тем же чтением) */
+void USART2_IRQHandler(void)
+{
+	uint16_t flags = USART2->SR;
+
+	if(flags & (USART_SR_IDLE | USART_SR_ORE))
+	{
+		(void)USART2->DR;								// Чтение SR, затем DR снимает IDLE и ORE
+		if(flags & USART_SR_ORE)
+		{
+			consoleStats.rxOverflows++;
+			METRIC_ADD(queueOverflows, 1);
+		}
+		if(flags & USART_SR_IDLE)
+		{
+			consoleStats.frames++;
+		}
+		consoleRxEvent();
+	}
+}
+
+/* Заполнена половина или весь буфер приема (длинная посылка без паузы) */
+void DMA1_Channel6_IRQHandler(void)
+{
+	DMA1->IFCR = DMA_IFCR_CGIF6;
+	consoleRxEvent();
+}
+
+/* Передача буфера завершена - отправка накопленного за это время ответа */
+void DMA1_Channel7_IRQHandler(void)
+{
+	DMA1->IFCR = DMA_IFCR_CGIF7;
+	txBusy = 0;
+	if(txLength[txFill] && !txReserved)
+	{
+		consoleStartTx();
+	}
+}
+
+/*
+*	Разбор принятых строк
+*	Команды заканчиваются символом '\r' или '\n', пустые строки пропускаются
+*/
+void consolePoll(console_handler handler)
+{
+	uint16_t head = rxHead;
+
+	while(rxTail != head)
+	{
+		char symbol = (char)rxBuffer[rxTail];
+		rxTail = (uint16_t)((rxTail + 1) % CONSOLE_RX_SIZE);
+
+		if(symbol == '\r' || symbol == '\n')
+		{
+			if(lineLength && !lineOverflow)
+			{
+				line[lineLength] = 0;
+				consoleStats.lines++;
+				handler(line);
+			}
+			lineLength = 0;
+			lineOverflow = 0;
+		}
+		else if(lineLength < CONSOLE_LINE_SIZE - 1)
+		{
+			line[lineLength++] = symbol;
+		}
+		else if(!lineOverflow)
+		{
+			lineOverflow = 1;
+			consoleStats.rxOverflows++;
+			METRIC_ADD(queueOverflows, 1);
+		}
+	}
+	consoleFlush();
+}
+
+/* Добавление строки в заполняемый буфер передачи */
+void consolePrint(const char *text)
+{
+	uint32_t basepri;
+
+	basepri = criticalEnter(BOARD_LEVEL_COMMS);			// Номер заполняемого буфера изменяется в прерывании DMA
+	while(*text)
+	{
+		if(txLength[txFill] >= CONSOLE_TX_SIZE)
+		{
+			consoleStats.txOverflows++;
+			METRIC_ADD(queueOverflows, 1);
+			break;
+		}
+		txBuffer[txFill][txLength[txFill]++] = *text++;
+	}
+	criticalExit(basepri);
+}
+
+/* Добавление десятичного числа (с ведущими нулями до digits цифр) */
+void consolePrintNumber(uint32_t value, uint8_t digits)
+{
+	char text[11];
+	uint8_t i = sizeof(text) - 1;
+
+	text[i] = 0;
+	do
+	{
+		text[--i] = (char)('0' + value % 10);
+		value /= 10;
+	} while((value || (sizeof(text) - 1 - i) < digits) && i);
+	consolePrint(&text[i]);
+}
+
+/* Отправка сформированного ответа (если передача уже идет, ответ будет отправлен по ее завершении) */
+void consoleFlush(void)
+{
+	uint32_t basepri;
+
+	basepri = criticalEnter(BOARD_LEVEL_COMMS);
+	if(!txBusy && !txReserved && txLength[txFill])
+	{
+		consoleStartTx();
+	}
+	criticalExit(basepri);
+}
+
+/*
+*	Резервирование size байт в заполняемом буфере передачи для записи без промежуточного копирования
+*	Возвращает указатель на свободное место или 0, если места недостаточно. До вызова consoleCommit буфер не отправляется
+*/
+uint8_t *consoleReserve(uint16_t size)
+{
+	uint8_t *space = 0;
+	uint32_t basepri;
+
+	basepri = criticalEnter(BOARD_LEVEL_COMMS);
+	if(CONSOLE_TX_SIZE - txLength[txFill] >= size)
+	{
+		txReserved = 1;
+		space = (uint8_t *)&txBuffer[txFill][txLength[txFill]];
+	}
+	else
+	{
+		consoleStats.txOverflows++;
+		METRIC_ADD(queueOverflows, 1);
+	}
+	criticalExit(basepri);
+	return space;
+}
+
+/* Завершение записи в зарезервированное место (length - фактически записано байт) */
+void consoleCommit(uint16_t length)
+{
+	uint32_t basepri;
+
+	basepri = criticalEnter(BOARD_LEVEL_COMMS);
+	txLength[txFill] += length;
+	txReserved = 0;
+	criticalExit(basepri);
+	consoleFlush();
+}
+
+/* Проверка ключевого слова в начале строки (с пропуском пробелов до и после него) */
+uint8_t consoleMatch(char **p_text, const char *word)
+{
+	char *text = *p_text;
+
+	while(*text == ' ')
+	{
+		text++;
+	}
+	while(*word)
+	{
+		if(*text++ != *word++)
+		{
+			return 0;
+		}
+	}
+	if(*text != 0 && *text != ' ')
+	{
+		return 0;
+	}
+	while(*text == ' ')
+	{
+		text++;
+	}
+	*p_text = text;
+	return 1;
+}
+
+/* Чтение десятичного числа, за которым может следовать разделитель (пробел, ':', '-', '.') */
+uint8_t consoleNumber(char **p_text, uint32_t *p_value)
+{
+	char *text = *p_text;
+	uint32_t value = 0;
+
+	if(*text < '0' || *text > '9')
+	{
+		return 0;
+	}
+	while(*text >= '0' && *text <= '9')
+	{
+		value = value * 10 + (uint32_t)(*text++ - '0');
+	}
+	while(*text == ' ' || *text == ':' || *text == '-' || *text == '.')
+	{
+		text++;
+	}
+	*p_value = value;
+	*p_text = text;
+	return 1;
+}
@@ -0,0 +1,43 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <stdint.h>
+
+/*
+*	Консоль на USART2 (PA2 - TX, PA3 - RX)
+*	Прием: циклический буфер DMA1_Channel6, конец посылки определяется прерыванием IDLE (линия свободна),
+*	поэтому прием не теряет байты, пока процессор остановлен стиранием страницы flash;
+*	строки разбираются пакетом в основном цикле. Передача: ответ формируется сразу в буфере передачи,
+*	который отправляется DMA1_Channel7 (два буфера: пока один передается, второй заполняется)
+*/
+
+#define CONSOLE_BAUDRATE 	115200ul	// Скорость обмена (до 1000000: BRR = 32 МГц / скорость)
+#define CONSOLE_RX_SIZE 	128			// Размер циклического буфера приема
+#define CONSOLE_TX_SIZE 	512			// Размер каждого из двух буферов передачи (телеметрия и журнал трассировки)
+#define CONSOLE_LINE_SIZE 	64			// Максимальная длина команды
+
+typedef struct console_stats_tag{	// Статистика консоли
+	uint32_t rxBytes;				// Принято байт
+	uint32_t txBytes;				// Передано байт
+	uint16_t frames;				// Принято посылок (по прерыванию IDLE)
+	uint16_t lines;					// Обработано команд
+	uint16_t rxOverflows;			// Потеряно данных при переполнении буфера приема, ошибке переполнения USART или длинной строке
+	uint16_t txOverflows;			// Не поместилось в буфер передачи
+} console_stats;
+
+typedef void (*console_handler)(char *line);	// Обработчик команды (строка без символов конца строки)
+
+extern console_stats consoleStats;
+
+void Console_Init(void);									// Настройка USART2 и DMA
+void consolePoll(console_handler handler);					// Разбор принятых строк (вызывается из основного цикла)
+void consolePrint(const char *text);						// Добавление строки в ответ
+void consolePrintNumber(uint32_t value, uint8_t digits);	// Добавление числа (digits - минимальное количество цифр)
+void consoleFlush(void);									// Отправка сформированного ответа
+uint8_t *consoleReserve(uint16_t size);						// Резервирование места в буфере передачи (запись без копирования)
+void consoleCommit(uint16_t length);						// Завершение записи в зарезервированное место
+
+uint8_t consoleMatch(char **p_text, const char *word);		// Проверка и пропуск ключевого слова
+uint8_t consoleNumber(char **p_text, uint32_t *p_value);	// Чтение десятичного числа
+
+#endif /* CONSOLE_H */
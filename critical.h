@@ -0,0 +1,29 @@
+#ifndef CRITICAL_H
+#define CRITICAL_H
+
+#include "stm32f10x.h"
+#include "board.h"
+
+/*
+*	Критические секции по уровню приоритета (уровни - board.h)
+*	BASEPRI маскирует прерывания заданного уровня и ниже, прерывания более высоких уровней продолжают обслуживаться,
+*	поэтому секция, общая только с обменом, не задерживает секунду TIM3. Секции вкладываются: __set_BASEPRI_MAX
+*	только повышает маску, выход восстанавливает сохраненное значение (можно вызывать и из обработчиков прерываний)
+*/
+
+/* Вход в секцию: возвращает прежнее значение маски */
+__STATIC_INLINE uint32_t criticalEnter(uint32_t level)
+{
+	uint32_t basepri = __get_BASEPRI();
+
+	__set_BASEPRI_MAX(BOARD_BASEPRI(level));
+	return basepri;
+}
+
+/* Выход из секции */
+__STATIC_INLINE void criticalExit(uint32_t basepri)
+{
+	__set_BASEPRI(basepri);
+}
+
+#endif /* CRITICAL_H */
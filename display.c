@@ -0,0 +1,72 @@
+#include "stm32f10x.h"
+#include "board.h"
+#include "display.h"
+
+#define DISPLAY_SEGMENTS_MASK 	(0x7Ful << DISPLAY_SEGMENT_FIRST)							// Все сегменты a...g
+#define DISPLAY_DIGITS_MASK 	(((1ul << DISPLAY_DIGITS) - 1ul) << DISPLAY_DIGIT_FIRST)	// Все выводы выбора разрядов
+#define DISPLAY_PINS_MASK 		(DISPLAY_SEGMENTS_MASK | (1ul << DISPLAY_POINT_PIN) | DISPLAY_DIGITS_MASK)
+
+/* Сегменты цифр 0...9 (бит 0 - сегмент a, бит 6 - сегмент g) */
+static const uint8_t displayDigits[10] = {0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F};
+
+static uint32_t frame[DISPLAY_DIGITS];	// Слова BSRR разрядов (читаются DMA)
+static uint8_t shownHours = 0xFF;		// Отображаемые значения (0xFF - кадр еще не построен)
+static uint8_t shownMinutes;
+static uint8_t shownFlags;
+
+/* Настройка канала сравнения 3 TIM2 (запрос DMA в начале каждого периода) и DMA1_Channel1 */
+void Display_Init(void)
+{
+	RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;
+	RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+
+	GPIOC->BRR = DISPLAY_PINS_MASK;												// Индикатор погашен до первого кадра
+	displayShow(0, 0, 0);
+
+	DMA1_Channel1->CPAR = (uint32_t)&GPIOC->BSRR;
+	DMA1_Channel1->CMAR = (uint32_t)frame;
+	DMA1_Channel1->CNDTR = DISPLAY_DIGITS;
+	DMA1_Channel1->CCR = DMA_CCR1_DIR | DMA_CCR1_MINC | DMA_CCR1_CIRC | DMA_CCR1_PSIZE_1 | DMA_CCR1_MSIZE_1 | DMA_CCR1_EN;	// Память -> порт, 32 бита, без прерываний
+
+	TIM2->CCR3 = 0;																// Сравнение при переполнении счетчика (TIM2 считает непрерывно, см. sunrise.c)
+	TIM2->DIER |= TIM_DIER_CC3DE;
+}
+
+/*
+*	Вывод времени
+*	Слово разряда зажигает его сегменты и вывод выбора, а остальные сегменты и разряды гасит (старшая половина BSRR),
+*	поэтому переключение разряда - одна запись DMA. Слово заменяется целиком, и DMA не может прочитать его наполовину
+*/
+void displayShow(uint8_t hours, uint8_t minutes, uint8_t flags)
+{
+	uint8_t values[DISPLAY_DIGITS];
+	uint32_t on;
+	uint8_t i;
+
+	if(hours == shownHours && minutes == shownMinutes && flags == shownFlags)
+	{
+		return;																	// Кадр не изменился
+	}
+	shownHours = hours;
+	shownMinutes = minutes;
+	shownFlags = flags;
+
+	values[0] = (uint8_t)(hours / 10);
+	values[1] = (uint8_t)(hours % 10);
+	values[2] = (uint8_t)(minutes / 10);
+	values[3] = (uint8_t)(minutes % 10);
+	for(i = 0; i < DISPLAY_DIGITS; i++)
+	{
+		on = (uint32_t)displayDigits[values[i] % 10] << DISPLAY_SEGMENT_FIRST;
+		if((i < 2 && (flags & DISPLAY_BLANK_HOURS)) || (i >= 2 && (flags & DISPLAY_BLANK_MINUTES)))
+		{
+			on = 0;
+		}
+		if(i == 1 && (flags & DISPLAY_COLON))
+		{
+			on |= 1ul << DISPLAY_POINT_PIN;
+		}
+		on |= 1ul << (DISPLAY_DIGIT_FIRST + i);
+		frame[i] = on | ((DISPLAY_PINS_MASK & ~on) << 16);
+	}
+}
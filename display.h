@@ -0,0 +1,24 @@
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <stdint.h>
+
+/*
+*	Четырехразрядный семисегментный индикатор с динамической индикацией (ЧЧ:ММ)
+*	Кадр - по одному слову GPIOC->BSRR на разряд (сегменты и выбор разряда одной записью);
+*	DMA1_Channel1 в циклическом режиме переписывает кадр в порт по событию сравнения TIM2_CH3
+*	(раз за период TIM2, около 488 Гц - 122 Гц на разряд), поэтому обновление индикатора не требует работы процессора.
+*	Кадр пересчитывается только при изменении отображаемого времени или признаков
+*/
+
+#define DISPLAY_DIGITS 			4		// Количество разрядов
+
+/* Признаки отображения */
+#define DISPLAY_COLON 			0x01	// Двоеточие включено
+#define DISPLAY_BLANK_HOURS 	0x02	// Разряды часов погашены (мигание при настройке)
+#define DISPLAY_BLANK_MINUTES 	0x04	// Разряды минут погашены
+
+void Display_Init(void);												// Настройка канала сравнения 3 TIM2 и DMA1_Channel1
+void displayShow(uint8_t hours, uint8_t minutes, uint8_t flags);		// Вывод времени (кадр пересчитывается только при изменениях)
+
+#endif /* DISPLAY_H */
@@ -0,0 +1,312 @@
+#include "stm32f10x.h"
+#include "gps.h"
+#include "calendar.h"
+#include "timebase.h"
+#include "calibration.h"
+#include "critical.h"
+
+#define GPS_TIMER_CLOCK 	32000000ul		// Частота счета TIM2 (HCLK, предделитель 1)
+
+gps_stats gpsStats;
+
+static uint8_t enabled;				// Флаг подстройки часов
+static uint8_t locked;				// Время установлено, дальше только плавная подстройка
+static uint8_t ppsValid;			// Предыдущий импульс запомнен (можно измерить интервал)
+static uint16_t ppsCapture;			// Захват TIM2 предыдущего импульса
+static uint32_t ppsSeconds;			// Предыдущий импульс по местным часам
+static uint16_t ppsMilliseconds;
+
+/* Разбор NMEA (состояние между байтами) */
+static uint8_t field;				// Номер поля предложения, 0xFF - ожидание '$'
+static uint8_t position;			// Номер символа в поле
+static uint8_t checksum;			// Исключающее ИЛИ символов между '$' и '*'
+static uint8_t received;			// Контрольная сумма из предложения
+static uint8_t inChecksum;			// Прием контрольной суммы после '*'
+static uint8_t status;				// Поле статуса RMC
+static uint8_t timeDigits;			// Количество цифр времени и даты (по 6)
+static uint8_t dateDigits;
+static uint32_t rmcTime;			// Время ччммсс
+static uint32_t rmcDate;			// Дата ддммгг
+static volatile uint8_t utcValid;	// Время очередного импульса известно
+static uint32_t utcOfPps;			// UTC импульса, к которому относится последнее RMC
+
+/* Настройка USART1 (прием NMEA), канала 1 TIM2 на захват 1PPS по фронту */
+void Gps_Init(void)
+{
+	RCC->APB2ENR |= RCC_APB2ENR_USART1EN;										// Включение тактирования USART1
+	RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;
+
+	field = 0xFF;
+	USART1->BRR = (uint16_t)((SystemCoreClock / 4 + GPS_BAUDRATE / 2) / GPS_BAUDRATE);	// USART1 тактируется от APB2 = HCLK / 4
+	USART1->CR1 = USART_CR1_UE | USART_CR1_RE | USART_CR1_RXNEIE;
+
+	TIM2->CCMR1 |= TIM_CCMR1_CC1S_0;											// Канал 1 - захват по входу TI1 без фильтра
+	TIM2->CCER |= TIM_CCER_CC1E;												// Захват по переднему фронту
+	TIM2->SR = (uint16_t)~TIM_SR_CC1IF;
+	TIM2->DIER |= TIM_DIER_CC1IE;
+
+	NVIC_EnableIRQ(USART1_IRQn);
+	NVIC_EnableIRQ(TIM2_IRQn);
+}
+
+/*
+*	Поправка частоты по измеренной ошибке HSE
+*	Ошибка измерена целиком, поэтому поправки остальных источников (калибровка, температура) вычитаются
+*/
+static void gpsApplyRate(void)
+{
+	timebaseSetRate(TIMEBASE_DISCIPLINE, -gpsStats.frequency - (timebaseGetRate() - timebaseGetSourceRate(TIMEBASE_DISCIPLINE)));
+}
+
+/* Включение подстройки часов (поправки сбрасываются, время устанавливается заново) */
+void gpsSetEnabled(uint8_t enable)
+{
+	uint32_t basepri;
+
+	basepri = criticalEnter(BOARD_LEVEL_TIME);
+	enabled = enable;
+	locked = 0;
+	timebaseSetRate(TIMEBASE_DISCIPLINE, 0);
+	if(enable)
+	{
+		gpsApplyRate();
+	}
+	timebaseSetOffset(0);
+	criticalExit(basepri);
+}
+
+/* 1 - подстройка включена */
+uint8_t gpsIsEnabled(void)
+{
+	return enabled;
+}
+
+/*
+*	Импульс 1PPS: обновление ошибки частоты HSE и подстройка фазы
+*	Число тактов TIM2 между импульсами - n * 32000000 плюс отклонение, которое однозначно определяется по разности
+*	16-битных захватов, пока не превышает 32768 тактов, то есть при ошибке менее 1024 / n ppm (128 ppm при
+*	GPS_MAX_GAP = 8, с запасом для кварца); число секунд n берется по часам TIM3, более длинные пропуски не измеряются
+*/
+void gpsPps(void)
+{
+	uint16_t capture = TIM2->CCR1;											// Чтение CCR1 снимает флаг захвата
+	uint32_t now;
+	uint16_t milliseconds;
+	uint32_t interval, seconds, expected;
+	int32_t deviation, ppb, difference;
+
+	ClockNow(&now, &milliseconds);
+	gpsStats.ppsEdges++;
+
+	interval = (now - ppsSeconds) * 1000ul + milliseconds - ppsMilliseconds;
+	seconds = (interval + 500ul) / 1000ul;
+	if(ppsValid && seconds >= 1 && seconds <= GPS_MAX_GAP)
+	{
+		deviation = (int16_t)(uint16_t)(capture - ppsCapture - (uint16_t)(seconds * GPS_TIMER_CLOCK));
+		ppb = deviation * 125l / (4l * (int32_t)seconds);					// 1 такт за секунду = 31.25 ppb
+		gpsStats.frequency += (ppb - gpsStats.frequency) / (1l << GPS_FREQ_SHIFT);
+		calibrationInterval((uint8_t)seconds, deviation);					// Накопление за длинное окно калибровки
+	}
+	ppsValid = 1;
+	ppsCapture = capture;
+	ppsSeconds = now;
+	ppsMilliseconds = milliseconds;
+
+	if(!enabled)
+	{
+		utcValid = 0;
+		return;
+	}
+
+	if(utcValid)																// Импульс отмечает начало секунды, следующей за временем RMC
+	{
+		expected = utcOfPps + 1;
+		difference = (int32_t)(expected - now);
+		gpsStats.offset = (difference > -1000 && difference < 1000) ? difference * 1000 - milliseconds : (difference < 0 ? -1000000l : 1000000l);
+	}
+	else if(locked)																// Без RMC импульс отмечает ближайшую границу секунды
+	{
+		expected = milliseconds < 500 ? now : now + 1;
+		gpsStats.offset = milliseconds < 500 ? -(int32_t)milliseconds : 1000 - (int32_t)milliseconds;
+	}
+	else
+	{
+		return;
+	}
+	utcValid = 0;
+
+	if(!locked || gpsStats.offset > GPS_STEP_LIMIT || gpsStats.offset < -GPS_STEP_LIMIT)
+	{
+		if(!ClockSetUtc(expected, (uint16_t)((uint16_t)(TIM2->CNT - capture) / (GPS_TIMER_CLOCK / 1000ul))))	// Задержка обработки с момента захвата
+		{
+			return;															// Идет настройка часов - установка по следующему импульсу
+		}
+		timebaseSetOffset(0);
+		locked = 1;
+		ppsValid = 0;															// Интервал до следующего импульса по часам TIM3 включал бы скачок
+		gpsStats.steps++;
+	}
+	else
+	{
+		timebaseSetOffset(gpsStats.offset);
+	}
+	gpsApplyRate();															// Кварц спешит - секунды удлиняются
+}
+
+/* Завершение предложения: проверка контрольной суммы и полей, время RMC относится к последнему импульсу */
+static void gpsSentenceEnd(void)
+{
+	date rmcDay;
+	time rmcClock;
+
+	if(field == 0xFF || !inChecksum)
+	{
+		return;
+	}
+	if(received != checksum)
+	{
+		gpsStats.checksumErrors++;
+		return;
+	}
+	gpsStats.sentences++;
+	gpsStats.fix = (status == 'A' && timeDigits == 6 && dateDigits == 6);
+	if(!gpsStats.fix)
+	{
+		return;
+	}
+
+	rmcClock.hours = (uint8_t)(rmcTime / 10000ul);
+	rmcClock.minutes = (uint8_t)(rmcTime / 100ul % 100ul);
+	rmcClock.seconds = (uint8_t)(rmcTime % 100ul);
+	rmcDay.day = (uint8_t)(rmcDate / 10000ul);
+	rmcDay.month = (uint8_t)(rmcDate / 100ul % 100ul);
+	rmcDay.year = (uint16_t)(2000ul + rmcDate % 100ul);
+	if(rmcDay.month < 1 || rmcDay.month > 12 || rmcDay.day < 1 || rmcDay.day > daysInMonth(rmcDay.year, rmcDay.month) ||	// Месяц проверен до длины месяца
+	   rmcClock.hours > 23 || rmcClock.minutes > 59 || rmcClock.seconds > 59)
+	{
+		return;
+	}
+	utcOfPps = dateTimeToSeconds(&rmcDay, &rmcClock);
+	utcValid = 1;
+}
+
+/* Значение шестнадцатеричной цифры (0xFF - не цифра) */
+static uint8_t gpsHex(uint8_t symbol)
+{
+	if(symbol >= '0' && symbol <= '9')
+	{
+		return (uint8_t)(symbol - '0');
+	}
+	if(symbol >= 'A' && symbol <= 'F')
+	{
+		return (uint8_t)(symbol - 'A' + 10);
+	}
+	return 0xFF;
+}
+
+/*
+*	Разбор очередного символа NMEA
+*	Поля RMC (1 - время, 2 - статус, 9 - дата) накапливаются сразу в числа, прочие предложения отбрасываются по адресу
+*/
+static void gpsParse(uint8_t symbol)
+{
+	uint8_t digit;
+
+	if(symbol == '$')
+	{
+		field = 0;
+		position = 0;
+		checksum = 0;
+		received = 0;
+		inChecksum = 0;
+		status = 0;
+		timeDigits = 0;
+		dateDigits = 0;
+		rmcTime = 0;
+		rmcDate = 0;
+		return;
+	}
+	if(field == 0xFF)
+	{
+		return;
+	}
+	if(symbol == '\r' || symbol == '\n')
+	{
+		gpsSentenceEnd();
+		field = 0xFF;
+		return;
+	}
+	if(inChecksum)
+	{
+		digit = gpsHex(symbol);
+		if(digit == 0xFF || ++position > 2)
+		{
+			field = 0xFF;
+			return;
+		}
+		received = (uint8_t)((received << 4) | digit);
+		return;
+	}
+	if(symbol == '*')
+	{
+		inChecksum = 1;
+		position = 0;
+		return;
+	}
+
+	checksum ^= symbol;
+	if(symbol == ',')
+	{
+		field++;
+		position = 0;
+		return;
+	}
+
+	digit = (uint8_t)(symbol - '0');
+	switch(field)
+	{
+		case 0:																// Адрес: ??RMC (любой источник - GP, GN, GL...)
+			if((position == 2 && symbol != 'R') || (position == 3 && symbol != 'M') || (position == 4 && symbol != 'C') || position > 4)
+			{
+				field = 0xFF;
+			}
+			break;
+		case 1:																// Время ччммсс[.сс]
+			if(position < 6 && digit <= 9)
+			{
+				rmcTime = rmcTime * 10ul + digit;
+				timeDigits++;
+			}
+			break;
+		case 2:
+			status = symbol;
+			break;
+		case 9:																// Дата ддммгг
+			if(position < 6 && digit <= 9)
+			{
+				rmcDate = rmcDate * 10ul + digit;
+				dateDigits++;
+			}
+			break;
+		default:
+			break;
+	}
+	position++;
+}
+
+/* Прием символа NMEA */
+void USART1_IRQHandler(void)
+{
+	uint16_t flags = USART1->SR;
+	uint8_t symbol = (uint8_t)USART1->DR;										// Чтение DR снимает RXNE и ошибки приема
+
+	if(flags & (USART_SR_FE | USART_SR_NE))
+	{
+		field = 0xFF;															// Искаженный символ - предложение отбрасывается
+		return;
+	}
+	if(flags & USART_SR_RXNE)
+	{
+		gpsParse(symbol);
+	}
+}
@@ -0,0 +1,38 @@
+#ifndef GPS_H
+#define GPS_H
+
+#include <stdint.h>
+
+/*
+*	Подстройка часов по приемнику GPS
+*	Импульс 1PPS (PA0) захватывается каналом 1 таймера TIM2 (свободный счет от HSE на 32 МГц, шаг 31.25 нс):
+*	интервал между импульсами дает ошибку частоты HSE, положение импульса относительно секунды TIM3 - ошибку фазы.
+*	Абсолютное время берется из предложения RMC (USART1, PA10 - RX), которое разбирается по мере приема
+*	без буферизации строки. Интервалы между импульсами используются также для калибровки кварца (calibration.h).
+*	Подстройка использует тот же источник поправки хода, что и синхронизация по CAN,
+*	поэтому одновременно включается только один внешний эталон
+*/
+
+#define GPS_BAUDRATE 		9600ul		// Скорость приемника (NMEA)
+#define GPS_STEP_LIMIT 		100			// Рассогласование, при котором время устанавливается скачком (мс)
+#define GPS_FREQ_SHIFT 		3			// Постоянная усреднения ошибки частоты (2^n интервалов)
+#define GPS_MAX_GAP 		8			// Максимальный интервал между импульсами для измерения частоты (секунды, однозначно до 1024 / n ppm)
+
+typedef struct gps_stats_tag{	// Статистика GPS
+	uint16_t ppsEdges;			// Принято импульсов 1PPS
+	uint16_t sentences;			// Принято предложений RMC с верной контрольной суммой
+	uint16_t checksumErrors;	// Предложения с ошибкой контрольной суммы
+	uint16_t steps;				// Установки времени скачком
+	uint8_t fix;				// 1 - последнее RMC с достоверным временем (статус A)
+	int32_t offset;				// Последнее рассогласование по фазе (мс, > 0 - часы отстают)
+	int32_t frequency;			// Усредненная ошибка частоты HSE (ppb, > 0 - кварц спешит)
+} gps_stats;
+
+extern gps_stats gpsStats;
+
+void Gps_Init(void);					// Настройка USART1 и канала захвата TIM2 (после Sunrise_Init)
+void gpsSetEnabled(uint8_t enable);		// Включение подстройки часов
+uint8_t gpsIsEnabled(void);				// 1 - подстройка включена
+void gpsPps(void);						// Обработка захвата 1PPS (вызывается из прерывания TIM2)
+
+#endif /* GPS_H */
@@ -1,57 +1,200 @@
 #include "stm32f10x.h"
-#include "GPIO_STM32F10x.h"
+#include "RTE_Components.h"
+#include "calendar.h"
+#include "timezone.h"
+#include "alarm.h"
+#include "buzzer.h"
+#include "sunrise.h"
+#include "console.h"
+#include "telemetry.h"
+#include "modbus.h"
+#include "timebase.h"
+#include "cansync.h"
+#include "gps.h"
+#include "calibration.h"
+#include "temperature.h"
+#include "clocksource.h"
+#include "display.h"
+#include "oled.h"
+#include "store.h"
+#include "trace.h"
+#include "stack.h"
+#include "bitband.h"
+#include "board.h"
+#include "critical.h"
+#include "sched.h"
+#include "boot.h"
+#include "metrics.h"
+#ifdef RTE_CMSIS_RTOS2_RTX5
+#include "rtx_os.h"
+#endif
 
-#define INC_BTN 		4	// Кнопка увеличения изменяемого параметра (минуты или секунды) на 1, также используется для отключения сигнала сработавшего будильника
-#define LED2 			5	// Светодиод для подачи сигнала (светодиод загорается при срабатывании будильника)
-#define CLOCKTIME_BTN 	6	// Кнопка перехода в режим настройки часов (текущего времени) ИЛИ кнопка подтверждения установленных минут или часов в этом режиме
-#define ALARMTIME_BTN 	7	// Кнопка перехода в режим настройки будильника ИЛИ кнопка подтверждения установленных минут или часов в этом режиме
+#define LOCAL_ZONE 		TZ_EUROPE_MOSCOW	// Часовой пояс для отображения времени и срабатывания будильника
+#define BUTTON_DEBOUNCE_MS 	20				// Фронт кнопки раньше этого времени после предыдущего фронта той же линии - дребезг
 
-typedef struct time_tag{	// Структура для хранения времени часов и будильника
-	uint8_t seconds;
-	uint8_t minutes;
-	uint8_t hours;
-} time;
-
-static uint64_t TIM3_interrupts;	// Счетчик прерываний таймера для счета секунд
+static uint32_t TIM3_interrupts;	// Счетчик прерываний таймера для счета секунд (секунды UTC от 01.01.1970 00:00:00)
 
 /* 
 *	Флаги режимов работы
 *	По умолчанию принимают нулевые значения
 */
-static uint8_t clockTimeSetting;	// Флаг режима настройки часов
-static uint8_t alarmTimeSetting;	// Флаг режима настройки будильника
-static uint8_t clockTimeBtnClick;	// Флаг нажатия на кнопку настройки часов
-static uint8_t alarmTimeBtnClick;	// флаг нажатия на кнопку настройки будильника
-static uint8_t incrementBtnClick;	// Флаг нажатия на кнопку инкремента 
-static uint8_t alarmIsOn;			// Флаг включения режима дежурства (1 - будильник включен, 0 - будильник отключен); защищает от непреднамеренной подачи сигнала тревоги
-static uint8_t alarmSignal;			// Флаг сигнала тревоги (1 - светодиод горит, 0 - светодиод не горит)
+typedef enum flag_tag{			// Номера флагов в слове flags
+	FLAG_CLOCK_SETTING,			// Режим настройки часов
+	FLAG_ALARM_SETTING,			// Режим настройки будильника
+	FLAG_CLOCK_CLICK,			// Нажатие на кнопку настройки часов
+	FLAG_ALARM_CLICK,			// Нажатие на кнопку настройки будильника
+	FLAG_INCREMENT_CLICK,		// Нажатие на кнопку инкремента
+	FLAG_ALARM_ON,				// Режим дежурства (1 - будильник включен, 0 - будильник отключен); защищает от непреднамеренной подачи сигнала тревоги
+	FLAG_ALARM_SIGNAL,			// Сигнал тревоги (1 - сигнал подается или отложен, 0 - сигнал отключен)
+} flag;
+
+/* 
+*	Флаги изменяются в прерываниях и в основном цикле: каждый флаг - отдельное слово псевдонима bit-band,
+*	чтение и запись флага - одна команда без чтения-изменения-записи соседних флагов
+*/
+static uint32_t flags;
+#define FLAG(name) 	BITBAND_SRAM(&flags, FLAG_##name)	// Флаг как переменная (записывается 0 или 1)
 static uint8_t mode;				// Флаг режима настройки времени (0 - настройка минут, 1 - настройка часов, 2 - настройка завершена)
+static time *p_settingTime;			// Настраиваемое время (0 - настройка не идет)
+static volatile uint32_t *p_settingClick;	// Флаг нажатия кнопки настраиваемого устройства
+
+static time currentTime, alarmTime;	// Экземпляры времени часов и будильника (местное время)
+static date currentDate;			// Текущая дата (местная)
+static tz_state localZone;			// Кэш смещения местного часового пояса
+
+typedef struct clock_value_tag{	// Дата и время (местные) одним сообщением
+	date day;
+	time clock;
+} clock_value;
+
+#ifdef RTE_CMSIS_RTOS2_RTX5
+/*
+*	Передача между потоками сборки RTX5 (объекты ядра в статической памяти, OS_DYNAMIC_MEM_SIZE = 0):
+*	очередь снимков времени - от TIM3 и установки часов к потоку индикации (индикация не читает часы сама);
+*	очередь запросов установки - от потока консоли к потоку кнопок, который владеет настройкой часов,
+*	выполнение запроса отмечается флагом события, консоль отвечает после него
+*/
+#define CLOCK_VIEW_QUEUE 	4			// Снимков времени в очереди индикации
+#define CLOCK_SET_QUEUE 	2			// Запросов установки часов
+#define CLOCK_SET_DONE 		0x0001u		// Флаг события: запрос установки часов выполнен
+#define CLOCK_SET_TIMEOUT 	100u		// Ожидание выполнения запроса (тиков ядра)
+
+static osRtxMessageQueue_t viewQueueControl;
+static uint32_t viewQueueMemory[osRtxMessageQueueMemSize(CLOCK_VIEW_QUEUE, sizeof(clock_value)) / 4];
+static osMessageQueueId_t viewQueue;
+static osRtxMessageQueue_t setQueueControl;
+static uint32_t setQueueMemory[osRtxMessageQueueMemSize(CLOCK_SET_QUEUE, sizeof(clock_value)) / 4];
+static osMessageQueueId_t setQueue;
+static osRtxEventFlags_t clockEventsControl;
+static osEventFlagsId_t clockEvents;
+#endif
+
+static uint8_t alarmTune = BUZZER_TUNE_CHIME;			// Мелодия сигнала тревоги
+static uint8_t alarmVolume = BUZZER_VOLUME_MAX / 2;	// Начальная громкость сигнала (увеличивается на каждой ступени усиления)
+static uint8_t alarmStage;								// Ступень усиления, для которой запущена мелодия
+typedef struct isr_stats_tag{	// Счетчики прерываний
+	uint32_t tim3Updates;		// Секундные прерывания TIM3
+	uint32_t tim3Phases;		// Прерывания TIM3 по фазам рисунка сигнала
+	uint16_t exti4;				// Прерывания кнопки инкремента (с дребезгом; нажатия - реестр метрик)
+	uint16_t exti9_5;			// Прерывания кнопок настройки часов и будильника
+} isr_stats;
+
+static isr_stats isrStats;						// Счетчики прерываний
+static uint32_t buttonEdge[8];					// Отсчет DWT последнего фронта по выводам кнопок (PA0...PA7)
+static uint8_t telemetryPeriod;					// Период отправки телеметрии (секунды), 0 - телеметрия выключена
+static uint8_t telemetrySeconds;				// Отсчет периода телеметрии
+
+static uint8_t sunriseMinutes = 15;						// Длительность рассвета перед будильником (SUNRISE_MIN_MINUTES...SUNRISE_MAX_MINUTES, 0 - рассвет выключен)
+
+typedef enum setting_key_tag{	// Ключи настроек в хранилище (store.h)
+	SETTING_ALARM,				// Будильник: часы, минуты, дежурство, мелодия, громкость, длительность рассвета
+	SETTING_TELEMETRY,			// Период телеметрии
+	SETTING_SYNC,				// Подстройка по GPS, роль CAN, термокомпенсация
+} setting_key;
+
+typedef enum event_id_tag{		// Коды событий журнала
+	EVENT_BOOT,					// Запуск (параметр - флаги причины сброса RCC_CSR[31:24])
+	EVENT_ALARM,				// Срабатывание будильника (параметр - время будильника в минутах от полуночи)
+	EVENT_ALARM_OFF,			// Отключение сигнала (параметр - время реакции в секундах)
+	EVENT_SNOOZE,				// Откладывание сигнала
+	EVENT_CLOCK_SET,			// Установка часов (параметр: 0 - консоль или Modbus, 1 - кнопки)
+	EVENT_ALARM_SET,			// Установка будильника кнопками (параметр - новое время в минутах от полуночи)
+} event_id;
 
-static time currentTime, alarmTime;	// Экземпляры времени часов и будильника
+typedef enum task_id_tag{		// Задачи планировщика в порядке приоритета (таблица tasks)
+	TASK_BUTTONS,				// Кнопки: отключение и откладывание сигнала, настройка часов и будильника (по EXTI)
+	TASK_CONSOLE,				// Команды консоли
+	TASK_DISPLAY,				// Индикатор и экран OLED
+	TASK_STORE,					// Запись событий из очереди хранилища
+	TASK_SETTINGS,				// Сохранение изменившихся настроек (по секунде TIM3)
+	TASK_TELEMETRY,				// Кадры телеметрии и трассировки (по периоду телеметрии в прерывании TIM3)
+	TASK_CLOCK,					// Возврат тактирования на HSE после отказа (по секунде TIM3)
+	TASKS
+} task_id;
 
-/* Настройка тактирования */
+static const sched_task tasks[TASKS];	// Таблица задач (определена перед main)
+
+
+/* Настройка тактирования (при отсутствии HSE - запуск от HSI, см. clocksource.h) */
 void SystemCoreClockConfigure(void) {
-	RCC->CR |= ((uint32_t)RCC_CR_HSEBYP);                    // Включение HSE 
-	while ((RCC->CR & RCC_CR_HSERDY) == 0);                  
+	clockStart();
+}
 
-	RCC->CFGR = RCC_CFGR_SW_HSE;                             // Источник тактирования - HSE 
-	while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_HSE);  
+/*
+*	Создание очередей и флагов событий часов (сборка RTX5) и первый снимок времени для индикации
+*	Ядро инициализируется здесь, до первых прерываний TIM3; повторный вызов osKernelInitialize в Sched_Init не мешает
+*/
+void ClockQueues_Init(void)
+{
+#ifdef RTE_CMSIS_RTOS2_RTX5
+	osMessageQueueAttr_t queue = {0};
+	osEventFlagsAttr_t events = {0};
+	clock_value view = {0};
 
-	RCC->CFGR |= RCC_CFGR_HPRE_DIV1;                         // Настройка частоты HCLK, APB1, APB2
-	RCC->CFGR |= RCC_CFGR_PPRE1_DIV1;                        
-	RCC->CFGR |= RCC_CFGR_PPRE2_DIV4;                        
+	osKernelInitialize();
+	queue.cb_mem = &viewQueueControl;
+	queue.cb_size = sizeof(viewQueueControl);
+	queue.mq_mem = viewQueueMemory;
+	queue.mq_size = sizeof(viewQueueMemory);
+	viewQueue = osMessageQueueNew(CLOCK_VIEW_QUEUE, sizeof(clock_value), &queue);
+	queue.cb_mem = &setQueueControl;
+	queue.cb_size = sizeof(setQueueControl);
+	queue.mq_mem = setQueueMemory;
+	queue.mq_size = sizeof(setQueueMemory);
+	setQueue = osMessageQueueNew(CLOCK_SET_QUEUE, sizeof(clock_value), &queue);
+	events.cb_mem = &clockEventsControl;
+	events.cb_size = sizeof(clockEventsControl);
+	clockEvents = osEventFlagsNew(&events);
 
-	RCC->CR &= ~RCC_CR_PLLON;                                // Настройка PLL
-															 
-	RCC->CFGR &= ~(RCC_CFGR_PLLSRC | RCC_CFGR_PLLXTPRE | RCC_CFGR_PLLMULL);
-	RCC->CFGR |=  (RCC_CFGR_PLLSRC_HSE | RCC_CFGR_PLLMULL4);
-	RCC->CR |= RCC_CR_PLLON;                               	 // PLL конфигурация: = HSE * 4 = 32 МГц
-								 
-	while((RCC->CR & RCC_CR_PLLRDY) == 0) __NOP();           
+	view.day = currentDate;
+	view.clock = currentTime;
+	osMessageQueuePut(viewQueue, &view, 0, 0);
+#endif
+}
 
-	RCC->CFGR &= ~RCC_CFGR_SW;                               // Выбор PLL в качестве источника тактирования
-	RCC->CFGR |=  RCC_CFGR_SW_PLL;
-	while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL);  
+/*
+*	Снимок даты и времени для индикации после их изменения (сборка RTX5; в основной сборке индикация читает часы сама)
+*	Вызывается вне критических секций: из потока вызов ядра - SVC. До запуска ядра снимки не передаются
+*/
+void ClockPublish(void)
+{
+#ifdef RTE_CMSIS_RTOS2_RTX5
+	clock_value view;
+	uint32_t basepri;
+
+	if(osKernelGetState() != osKernelRunning)
+	{
+		return;
+	}
+	basepri = criticalEnter(BOARD_LEVEL_TIME);
+	view.day = currentDate;
+	view.clock = currentTime;
+	criticalExit(basepri);
+	if(osMessageQueuePut(viewQueue, &view, 0, 0) != osOK)					// Поток индикации отстал - снимок пропускается
+	{
+		METRIC_ADD(queueOverflows, 1);
+	}
+#endif
 }
 
 /* Настройка таймера TIM3 (прерывание срабатывает каждую секунду) */
@@ -60,59 +203,236 @@ void TIM3_Init() {
 	TIM3 -> CR1 = TIM_CR1_CEN;								 // Включение счетчика
 
 	TIM3->PSC = (uint16_t)(SystemCoreClock / 1000 - 1);	     // Определение значений предделителя (длительность одного тика таймера) 
-	TIM3->ARR = 1000 - 1;									 // и регистра автоматичекой перезагрузки (количество тиков)
+	TIM3->ARR = TIMEBASE_PERIOD - 1;									 // и регистра автоматичекой перезагрузки (количество тиков)
+	TIM3->CCR1 = 1000 / ALARM_PHASES;						 // Канал сравнения 1 отсчитывает фазы рисунка сигнала тревоги
+	TIM3->CCR2 = SCHED_TICK_MS;								 // Канал сравнения 2 отсчитывает тики планировщика
 			
-	TIM3->DIER |= TIM_DIER_UIE;								 // Включение прерываний
+	TIM3->DIER |= TIM_DIER_UIE | TIM_DIER_CC2IE;			 // Включение прерываний
 	NVIC_EnableIRQ (TIM3_IRQn);										 
 }
 
-/* Настройка порта ввода-вывода*/
-void GPIO_Init(void) {            		 	 
-	RCC->APB2ENR |= RCC_APB2ENR_IOPAEN; 					 						// Включение тактирования порта GPIO 
-	
-	GPIO_PinConfigure(GPIOA, LED2, GPIO_OUT_PUSH_PULL, GPIO_MODE_OUT10MHZ); 		// Настройка подачи сигнала на светодиод LD2 (порт PA5)
+/*
+*	Пересчет предделителя TIM3 после смены частоты SYSCLK
+*	Новый предделитель загружается принудительным обновлением (UG), которое сбрасывает счетчик,
+*	поэтому счетчик восстанавливается, а прерывание от UG подавляется битом URS: теряется менее одного тика
+*/
+void TIM3_Retune(void) {
+	uint16_t counter;
+	uint16_t prescaler = (uint16_t)(SystemCoreClock / 1000 - 1);
 	
-	GPIO_PinConfigure(GPIOA, INC_BTN, GPIO_IN_PULL_DOWN, GPIO_MODE_INPUT); 			// Настройка подачи сигнала на порт PA4 (кнопка прибавления единицы к настраиваемому параметру (минуты или часы))
-	GPIO_PinConfigure(GPIOB, CLOCKTIME_BTN, GPIO_IN_PULL_DOWN, GPIO_MODE_INPUT); 	// Настройка подачи сигнала на порт PA6 (кнопка настройки текущего времени)
-	GPIO_PinConfigure(GPIOC, ALARMTIME_BTN, GPIO_IN_PULL_DOWN, GPIO_MODE_INPUT); 	// Настройка подачи сигнала на порт PA7 (кнопка настройки времени срабатывания будильника)
+	if(TIM3->PSC == prescaler)
+	{
+		return;
+	}
+	counter = TIM3->CNT;
+	TIM3->PSC = prescaler;
+	TIM3->CR1 |= TIM_CR1_URS;
+	TIM3->EGR = TIM_EGR_UG;
+	TIM3->CNT = counter;
+	TIM3->CR1 &= ~TIM_CR1_URS;
 }
 
-/* Настройка внешних прерываний */
-void NVIC_InputInit()
+/* 
+*	Функция сравнения времени 
+*	Возвращает 1 при совпадени времени будильника и часов, в противном случае - 0
+*/
+uint8_t compareTime(time *time_1, time *time_2)
 {
-	RCC->APB2ENR |= RCC_APB2ENR_AFIOEN;															// Включение тактирования альтернативных функций
-	
-	AFIO->EXTICR[1] |= AFIO_EXTICR2_EXTI4_PA | AFIO_EXTICR2_EXTI6_PA | AFIO_EXTICR2_EXTI7_PA;   // Выбор источников прерывания (PA4, PA6, PA7)
-	EXTI->IMR |= EXTI_IMR_MR4 | EXTI_IMR_MR6 | EXTI_IMR_MR7;									// Разрешение генерации прерываний в периферии
-	EXTI->RTSR |= EXTI_RTSR_TR4 | EXTI_RTSR_TR6 | EXTI_RTSR_TR7;								// Настройка детектирования прерывания по восходящему фронту
-	NVIC_EnableIRQ(EXTI4_IRQn);																	// Разрешение прерывания в NVIC
-	NVIC_EnableIRQ(EXTI9_5_IRQn);
+	return (time_1->hours == time_2->hours) && (time_1->minutes == time_2->minutes);
 }
 
-/* Включение светодиода */
+/* Управление выходом сигнала тревоги (светодиод LD2) */
+void alarmOutput(uint8_t level) {
+	BITBAND_PERIPH(&GPIOA->ODR, LED2) = level != 0;				// Зажигание или потухание светодиода
+}
+
+/* Начало подачи сигнала тревоги (вызывается из обработчика прерывания TIM3) */
 void ALARM_ON() {
-	alarmSignal = 1;			// Начало подачи сигнала тревоги
-	GPIOA->BSRR = 1ul << LED2;  // Зажигание светодиода                            
+	FLAG(ALARM_SIGNAL) = 1;			// Начало подачи сигнала тревоги
+	alarmStart();				// Запуск первой ступени усиления сигнала
+	storeEvent(EVENT_ALARM, TIM3_interrupts, (uint16_t)(alarmTime.hours * 60u + alarmTime.minutes));
+	traceEvent(TRACE_ALARM, 0);
 }
 
-/* Выключение светодиода */
+/* 
+*	Отключение сигнала тревоги
+*	Будильник остается на дежурстве и сработает при совпадении времени на следующие сутки
+*/
 void ALARM_OFF() {
-	alarmSignal = 0;					// Завершение подачи сигнала тревоги
-	alarmIsOn = 0;	            		// Отключение режима дежурства будильника (при совпадении времени на следующие сутки будильник не сработает, после срабатывания его нужно заводить заново)
-	GPIOA->BSRR = 1ul << (LED2 + 16); 	// Потухание светодиода
+	uint32_t basepri;
+
+	basepri = criticalEnter(BOARD_LEVEL_TIME);	// Состояние обработчика сигнала изменяется также в прерывании TIM3
+	alarmDismiss();						// Завершение сигнала с учетом времени реакции в статистике
+	if(FLAG(ALARM_SIGNAL))
+	{
+		storeEvent(EVENT_ALARM_OFF, TIM3_interrupts, (uint16_t)alarmStats.lastDismissTime);
+		traceEvent(TRACE_ALARM, 1);
+	}
+	FLAG(ALARM_SIGNAL) = 0;					// Завершение подачи сигнала тревоги
+	alarmOutput(0);						// Потухание светодиода
+	buzzerStop();						// Остановка мелодии
+	sunriseStop();						// Выключение светодиода рассвета
+	criticalExit(basepri);
 }
 
-/* Настройка обработчика прерываний для TIM3 */
-void TIM3_IRQHandler() {													
-	TIM3->SR &= ~TIM_SR_UIF;												// Снятие флага события обновления
+/* Откладывание сигнала тревоги на ALARM_SNOOZE_MINUTES минут */
+void ALARM_SNOOZE() {
+	uint32_t basepri;
+
+	basepri = criticalEnter(BOARD_LEVEL_TIME);
+	alarmSnooze();						// Сигнал возобновится из прерывания TIM3 по истечении времени откладывания
+	storeEvent(EVENT_SNOOZE, TIM3_interrupts, 0);
+	traceEvent(TRACE_ALARM, 2);
+	alarmOutput(0);
+	buzzerStop();
+	criticalExit(basepri);
+}
+
+/* Обработка событий TIM3: фазы рисунка сигнала, тики планировщика, секунды */
+void TIM3_Service(void) {
+	uint8_t signal;
+	uint16_t missed;
+	
+	if(TIM3->SR & TIM_SR_CC1IF)												// Событие сравнения - очередная фаза рисунка сигнала тревоги
+	{
+		TIM3->SR = (uint16_t)~TIM_SR_CC1IF;									// Снятие флага (запись 0 не затрагивает остальные флаги)
+		TIM3->CCR1 += 1000 / ALARM_PHASES;									// Следующая фаза (после последней фазы сравнение не наступит до конца секунды)
+		alarmOutput(alarmPhase());
+		isrStats.tim3Phases++;
+	}
+	
+	if(TIM3->SR & TIM_SR_CC2IF)												// Тик планировщика
+	{
+		TIM3->SR = (uint16_t)~TIM_SR_CC2IF;
+		missed = TIM3->CNT >= TIM3->CCR2 ? (uint16_t)((TIM3->CNT - TIM3->CCR2) / SCHED_TICK_MS) : 0;	// Обработка задержана на период и больше
+		METRIC_ADD(ticksMissed, missed);
+		TIM3->CCR2 += (uint16_t)(SCHED_TICK_MS * (missed + 1u));				// Следующее сравнение - впереди счетчика, иначе тики остановятся до конца секунды
+		if(TIM3->CCR2 + SCHED_TICK_MS / 2 > TIM3->ARR)						// Тик на границе секунды дает событие обновления
+		{
+			TIM3->CCR2 = 0xFFFF;
+		}
+		schedTick();
+		temperatureTick();													// Очередная группа отсчетов датчика температуры
+	}
+	
+	if(!(TIM3->SR & TIM_SR_UIF))
+	{
+		return;
+	}
+	TIM3->SR = (uint16_t)~TIM_SR_UIF;										// Снятие флага события обновления
+	TIM3->ARR = timebaseNextPeriod();										// Длительность новой секунды с поправкой хода (буферизация ARR выключена)
 	TIM3_interrupts++;														// Увеличение счетчика прерываний
+	isrStats.tim3Updates++;
+	canSyncSecond();														// Ведущий передает SYNC в начале секунды
+	temperatureSecond();													// Термокомпенсация хода на следующую секунду
+	if(clockSourceSecond())													// Компенсация HSI; возврат на HSE после отказа - в задаче
+	{
+		schedTrigger(TASK_CLOCK);
+	}
+	schedTick();															// Первый тик новой секунды
+	TIM3->CCR2 = SCHED_TICK_MS;
+	schedTrigger(TASK_SETTINGS);											// Сохранение настроек раз в секунду
+	traceSecond();															// Метка времени журнала трассировки при долгой тишине
+	
+	if(telemetryPeriod && ++telemetrySeconds >= telemetryPeriod)			// Кадр телеметрии формируется задачей, прерывание только запускает ее
+	{
+		telemetrySeconds = 0;
+		schedTrigger(TASK_TELEMETRY);
+	}
+	
+	if(!FLAG(CLOCK_SETTING))													// Изменение времени в структуре в режиме настройки часов запрещено
+	{
+		if(tzUpdate(&localZone, TIM3_interrupts))								// Переход на летнее/зимнее время - пересчет местного времени
+		{
+			secondsToDateTime(TIM3_interrupts + (uint32_t)localZone.offset, &currentDate, &currentTime);
+		}
+		else if(timeTick(&currentTime))										// Инкрементное обновление часов, минут, секунд текущего времени (без деления)
+		{
+			dateNextDay(&currentDate);										// Переход через полночь - смена даты
+		}
+		ClockPublish();
+	}
+	
+	/* 
+	*	Сигнал тревоги подается в начале минуты, если до этого он был выключен, будильник стоит на дежурстве и совпало время часов и будильника 
+	*	В режимах настройки время часов и будильника изменяется пользователем, поэтому сравнение не выполняется
+	*/
+	if(!FLAG(ALARM_SIGNAL) && FLAG(ALARM_ON) && !FLAG(CLOCK_SETTING) && !FLAG(ALARM_SETTING) && currentTime.seconds == 0 && compareTime(&currentTime, &alarmTime))
+	{
+		ALARM_ON();
+	}
+	
+	/* Рассвет запускается заранее, чтобы полная яркость была достигнута точно ко времени будильника */
+	if(sunriseMinutes && !FLAG(ALARM_SIGNAL) && FLAG(ALARM_ON) && !FLAG(CLOCK_SETTING) && !FLAG(ALARM_SETTING) && !sunriseIsActive() && alarmLeadMatch(&currentTime, &alarmTime, sunriseMinutes))
+	{
+		sunriseStart(sunriseMinutes);
+	}
+	
+	signal = alarmSecond();													// Усиление, возобновление после откладывания и автоматическое завершение сигнала
+	if(FLAG(ALARM_SIGNAL) && !signal)
+	{
+		sunriseStop();														// Сигнал завершен по таймауту - выключение светодиода рассвета
+		traceEvent(TRACE_ALARM, 3);
+	}
+	FLAG(ALARM_SIGNAL) = signal != 0;
+	TIM3->CCR1 = 1000 / ALARM_PHASES;										// Фазы рисунка сигнала отсчитываются заново с начала секунды
+	if(alarmGetState() == ALARM_RINGING)
+	{
+		TIM3->DIER |= TIM_DIER_CC1IE;										// Прерывания по фазам нужны только во время подачи сигнала
+		if(!buzzerIsPlaying() || alarmGetStage() != alarmStage)				// Начало сигнала или новая ступень - мелодия громче
+		{
+			alarmStage = alarmGetStage();
+			buzzerPlay(alarmTune, alarmVolume + alarmStage, 1);				// Мелодия повторяется средствами DMA до отключения сигнала
+		}
+	}
+	else
+	{
+		TIM3->DIER &= ~TIM_DIER_CC1IE;
+		if(buzzerIsPlaying())
+		{
+			buzzerStop();													// Сигнал отложен или завершен по таймауту
+		}
+	}
+	alarmOutput(alarmPhase());												// Уровень сигнала в первой фазе секунды
+}
+
+/* Прерывание TIM3: обработка с учетом времени в реестре метрик */
+void TIM3_IRQHandler(void)
+{
+	uint32_t start = DWT->CYCCNT;
+	
+	TIM3_Service();
+	metricsIsr(start);
+}
+
+/* Прерывание TIM2: каналы общего таймера обрабатываются своими модулями (канал 1 - захват 1PPS, канал 4 - тишина Modbus; канал 3 - запросы DMA индикатора, без прерываний) */
+void TIM2_IRQHandler(void)
+{
+	if(TIM2->SR & TIM_SR_CC1IF)
+	{
+		gpsPps();
+	}
+	if(TIM2->SR & TIM_SR_CC4IF)
+	{
+		modbusTimeout();
+	}
+}
+
+/*
+*	Отсев дребезга (вызывается из прерываний EXTI): фронт принимается, если кнопка нажата (вход в высоком уровне)
+*	и с предыдущего фронта той же линии прошло не меньше BUTTON_DEBOUNCE_MS. Отброшенный фронт продлевает окно
+*/
+uint8_t ButtonEdge(uint8_t pin, uint32_t now)
+{
+	uint32_t elapsed = now - buttonEdge[pin];
 	
-	if(!clockTimeSetting)													// Изменение времени в структуре в режиме настройки часов запрещено
+	buttonEdge[pin] = now;
+	if(!(GPIOA->IDR & (1ul << pin)) || elapsed < BUTTON_DEBOUNCE_MS * (SystemCoreClock / 1000ul))
 	{
-		currentTime.hours = (uint8_t)(TIM3_interrupts % 86400 / 3600);		// Вычисление часов, минут, секунд текущего времени
-		currentTime.minutes = (uint8_t)(TIM3_interrupts % 3600 / 60);
-		currentTime.seconds = (uint8_t)(TIM3_interrupts % 60);
+		METRIC_COUNT(bounces);												// Изменяется только на уровне BOARD_LEVEL_INPUT
+		return 0;
 	}
+	return 1;
 }
 
 /* 
@@ -124,117 +444,1234 @@ void TIM3_IRQHandler() {
 */
 void EXTI4_IRQHandler(void)
 {
-	incrementBtnClick = clockTimeSetting | alarmTimeSetting | alarmSignal; 
-	EXTI->PR |= EXTI_PR_PR4;	// Очистка флага
+	uint32_t start = DWT->CYCCNT;
+	
+	EXTI->PR = EXTI_PR_PR4;		// Очистка флага (запись 0 не затрагивает остальные линии)
+	isrStats.exti4++;
+	if(ButtonEdge(INC_BTN, start))
+	{
+		FLAG(INCREMENT_CLICK) = FLAG(CLOCK_SETTING) | FLAG(ALARM_SETTING) | FLAG(ALARM_SIGNAL); 
+		METRIC_COUNT(buttonIncrement);
+		traceEvent(TRACE_BUTTON, 0);
+		schedTrigger(TASK_BUTTONS);
+	}
+	metricsIsr(start);
 }
 
 /* Обработка нажатия кнопок настройки часов и будильника */
 void EXTI9_5_IRQHandler(void)
 {
-	clockTimeBtnClick = (EXTI->PR & (1ul << CLOCKTIME_BTN)); // Проверка срабатывания прерывания								
-	alarmTimeBtnClick = (EXTI->PR & (1ul << ALARMTIME_BTN)); // Проверка срабатывания прерывания
+	uint32_t start = DWT->CYCCNT;
+	uint32_t pending = EXTI->PR & ((1ul << CLOCKTIME_BTN) | (1ul << ALARMTIME_BTN));
+	uint32_t accepted = 0;
 	
-	EXTI->PR |= (1ul << CLOCKTIME_BTN);						 // Очистка флагов
-	EXTI->PR |= (1ul << ALARMTIME_BTN);  								
+	EXTI->PR = pending;										// Очистка только обработанных флагов (без чтения-изменения-записи)
+	isrStats.exti9_5++;
+	if((pending & (1ul << CLOCKTIME_BTN)) && ButtonEdge(CLOCKTIME_BTN, start))
+	{
+		accepted |= 1ul << CLOCKTIME_BTN;
+		METRIC_COUNT(buttonClock);
+	}
+	if((pending & (1ul << ALARMTIME_BTN)) && ButtonEdge(ALARMTIME_BTN, start))
+	{
+		accepted |= 1ul << ALARMTIME_BTN;
+		METRIC_COUNT(buttonAlarm);
+	}
+	if(accepted)											// Дребезг не изменяет флаги необработанного нажатия
+	{
+		FLAG(CLOCK_CLICK) = (accepted >> CLOCKTIME_BTN) & 1ul;	// Проверка срабатывания прерывания
+		FLAG(ALARM_CLICK) = (accepted >> ALARMTIME_BTN) & 1ul;
+		traceEvent(TRACE_BUTTON, FLAG(CLOCK_CLICK) ? 1 : 2);
+		schedTrigger(TASK_BUTTONS);
+	}
+	metricsIsr(start);
 }
 
-/* 
-*	Функция сравнения времени 
-*	Возвращает 1 при совпадени времени будильника и часов, в противном случае - 0
+/* Запись числа десятичными цифрами (ровно digits цифр с ведущими нулями) */
+void TextNumber(char *p_text, uint32_t value, uint8_t digits)
+{
+	while(digits)
+	{
+		p_text[--digits] = (char)('0' + value % 10);
+		value /= 10;
+	}
+}
+
+/*
+*	Экран OLED: дата и источник тактирования, время крупным шрифтом с секундами, будильник, состояние GPS и CAN
+*	Строки выводятся целиком, но передаются только действительно изменившиеся столбцы
 */
-uint8_t compareTime(time *time_1, time *time_2)
+void OledUpdate(const time *p_time, const date *p_date, uint8_t flags)
 {
-	return (time_1->hours == time_2->hours) && (time_1->minutes == time_2->minutes);
+	static const char *sources[3] = {"HSE", "HSI", "HSI"};
+	static const char *roles[3] = {"CAN -", "CAN M", "CAN S"};
+	char text[12];
+	
+	TextNumber(&text[0], p_date->day, 2);
+	text[2] = '.';
+	TextNumber(&text[3], p_date->month, 2);
+	text[5] = '.';
+	TextNumber(&text[6], p_date->year, 4);
+	text[10] = 0;
+	oledText(0, 0, text);
+	oledText(110, 0, sources[clockStats.source]);
+	
+	TextNumber(&text[0], p_time->hours, 2);
+	text[2] = (flags & DISPLAY_COLON) ? ':' : ' ';
+	TextNumber(&text[3], p_time->minutes, 2);
+	text[5] = 0;
+	if(flags & DISPLAY_BLANK_HOURS)
+	{
+		text[0] = text[1] = ' ';
+	}
+	if(flags & DISPLAY_BLANK_MINUTES)
+	{
+		text[3] = text[4] = ' ';
+	}
+	oledLargeText(4, 2, text);
+	TextNumber(&text[0], p_time->seconds, 2);
+	text[2] = 0;
+	oledText(92, 4, text);
+	
+	TextNumber(&text[0], alarmTime.hours, 2);
+	text[2] = ':';
+	TextNumber(&text[3], alarmTime.minutes, 2);
+	text[5] = FLAG(ALARM_SIGNAL) ? '*' : ' ';								// Сигнал подается или отложен
+	text[6] = 0;
+	oledText(0, 6, "ALARM");
+	oledText(36, 6, FLAG(ALARM_ON) ? text : "OFF   ");
+	
+	oledText(0, 7, gpsIsEnabled() ? (gpsStats.fix ? "GPS FIX" : "GPS ---") : "GPS OFF");
+	oledText(54, 7, roles[canSyncGetRole()]);
+}
+
+/*
+*	Вывод времени на индикаторы (кадр DMA семисегментного индикатора пересчитывается только при изменениях,
+*	экран OLED перерисовывается при смене секунды или признаков и передается по частям)
+*	В режимах настройки настраиваемые разряды мигают (полсекунды погашены), в обычном режиме мигает двоеточие
+*/
+void DisplayUpdate(const time *p_time, const date *p_date)
+{
+	static time shownTime;
+	static uint8_t shownFlags = 0xFF;
+	uint32_t seconds;
+	uint16_t milliseconds;
+	uint8_t flags = DISPLAY_COLON;
+	
+	if(FLAG(CLOCK_SETTING) || FLAG(ALARM_SETTING))
+	{
+		ClockNow(&seconds, &milliseconds);
+		if(milliseconds >= 500)
+		{
+			flags |= mode == 0 ? DISPLAY_BLANK_MINUTES : DISPLAY_BLANK_HOURS;
+		}
+	}
+	else if(p_time->seconds & 1)
+	{
+		flags = 0;
+	}
+	displayShow(p_time->hours, p_time->minutes, flags);
+	
+	if(flags != shownFlags || p_time->seconds != shownTime.seconds || p_time->minutes != shownTime.minutes || p_time->hours != shownTime.hours)
+	{
+		shownTime = *p_time;
+		shownFlags = flags;
+		OledUpdate(p_time, p_date, flags);
+	}
+	oledFlush();															// Очередной измененный диапазон, если шина свободна
 }
 
 /*
-*	Функция настройки времени для часов или будильника
+*	Начало настройки времени для часов или будильника
 *	Тип настраиваемого устройства (часы или будильник) определяется через указатель на кнопку p_buttonClick
 */
-void TimeSet(time *p_time, uint8_t *p_buttonClick)
+void TimeSetStart(time *p_time, volatile uint32_t *p_buttonClick)
 {
 	p_time->hours = 0;		// Сброс времени
 	p_time->minutes = 0;
 	
 	mode = 0;				// Установка режима настройки минут
 	*p_buttonClick = 0;		// Обнуление нажатия кнопки настройки после перехода в режим настройки
-	while(1)
+	p_settingTime = p_time;
+	p_settingClick = p_buttonClick;
+}
+
+/*
+*	Шаг настройки времени по нажатиям кнопок (вызывается задачей кнопок, не ждет в цикле)
+*	Возвращает 1, когда подтверждены минуты и часы и настройка завершена
+*/
+uint8_t TimeSet(void)
+{
+	if(FLAG(INCREMENT_CLICK)) 											// При нажатии кнопки инкремента
+	{
+		if(mode == 0)													// Режим настройки минут
+		{
+			p_settingTime->minutes = (p_settingTime->minutes + 1) % 60;	// Увеличивается на 1 количество минут (диапазон: 0...59)
+		}
+		else															// Режим настройки часов
+		{
+			p_settingTime->hours = (p_settingTime->hours + 1) % 24;		// Увеличивается количество часов (диапазон: 0...23)
+		}
+		FLAG(INCREMENT_CLICK) = 0;										// Обнуляется флаг нажатия кнопки инкремента (клик считается обработанным)
+	}
+	
+	if(*p_settingClick)													// При нажатии кнопки настройки устройства
+	{
+		mode++;															// Происходит переход в следующий режим (настройка часов или завершение настройки)
+		*p_settingClick = 0;											// Обнуляется флаг нажатия кнопки настройки устройства (клик считается обработанным)
+	}
+	
+	if(mode < 2)
+	{
+		return 0;
+	}
+	p_settingTime = 0;													// Режим завершения настройки
+	return 1;
+}
+
+/* Установка текущих даты и времени (местное время) */
+void ClockSet(const date *p_date, const time *p_time)
+{
+	uint32_t basepri;
+
+	basepri = criticalEnter(BOARD_LEVEL_TIME);								// Время и кэш часового пояса изменяются также в прерывании TIM3
+	TIM3_interrupts = tzLocalToUtc(&localZone, dateTimeToSeconds(p_date, p_time));
+	secondsToDateTime(TIM3_interrupts + (uint32_t)localZone.offset, &currentDate, &currentTime);
+	storeEvent(EVENT_CLOCK_SET, TIM3_interrupts, 0);
+	criticalExit(basepri);
+	ClockPublish();
+	traceEvent(TRACE_TIME, 0);
+}
+
+/*
+*	Установка часов из потока консоли; возвращает 0, если запрос не выполнен
+*	В сборке RTX5 запрос передается очередью потоку кнопок, ответ - по флагу события выполнения
+*/
+uint8_t ClockRequest(const date *p_date, const time *p_time)
+{
+#ifdef RTE_CMSIS_RTOS2_RTX5
+	clock_value request;
+
+	request.day = *p_date;
+	request.clock = *p_time;
+	osEventFlagsClear(clockEvents, CLOCK_SET_DONE);
+	if(osMessageQueuePut(setQueue, &request, 0, 0) != osOK)
+	{
+		return 0;
+	}
+	schedTrigger(TASK_BUTTONS);
+	return (osEventFlagsWait(clockEvents, CLOCK_SET_DONE, osFlagsWaitAny, CLOCK_SET_TIMEOUT) & osFlagsError) == 0;
+#else
+	ClockSet(p_date, p_time);
+	return 1;
+#endif
+}
+
+/*
+*	Текущее время UTC с миллисекундами (счетчик TIM3)
+*	Если переполнение TIM3 еще не обработано (прерывания запрещены или вызов из другого прерывания), секунда уже наступила
+*/
+void ClockNow(uint32_t *p_seconds, uint16_t *p_milliseconds)
+{
+	uint32_t seconds;
+	uint16_t milliseconds;
+	uint32_t basepri;
+	
+	basepri = criticalEnter(BOARD_LEVEL_TIME);
+	seconds = TIM3_interrupts;
+	milliseconds = TIM3->CNT;
+	if(TIM3->SR & TIM_SR_UIF)
+	{
+		seconds++;
+		milliseconds = TIM3->CNT;
+	}
+	criticalExit(basepri);
+	*p_seconds = seconds;
+	*p_milliseconds = milliseconds;
+}
+
+/*
+*	Скачкообразная установка времени UTC (синхронизация): счетчик TIM3 переносится на заданную долю секунды
+*	Во время настройки часов кнопками время не изменяется (заданное пользователем время имеет приоритет),
+*	возвращается 0 - источник повторит установку при следующей синхронизации
+*/
+uint8_t ClockSetUtc(uint32_t seconds, uint16_t milliseconds)
+{
+	uint32_t basepri;
+
+	basepri = criticalEnter(BOARD_LEVEL_TIME);
+	if(FLAG(CLOCK_SETTING))													// Флаг снимается в ButtonTask в такой же критической секции
+	{
+		criticalExit(basepri);
+		return 0;
+	}
+	TIM3->ARR = TIMEBASE_PERIOD - 1;
+	TIM3->CNT = milliseconds;
+	TIM3->SR = (uint16_t)~TIM_SR_UIF;										// Необработанная секунда уже учтена в новом времени
+	TIM3->CCR2 = (milliseconds / SCHED_TICK_MS + 1u) * SCHED_TICK_MS;		// Тики планировщика продолжаются с новой доли секунды
+	TIM3_interrupts = seconds;
+	tzSelect(&localZone, LOCAL_ZONE, seconds);								// Время могло сместиться на любой интервал - смещение пояса ищется заново
+	secondsToDateTime(TIM3_interrupts + (uint32_t)localZone.offset, &currentDate, &currentTime);
+	criticalExit(basepri);
+	ClockPublish();
+	traceEvent(TRACE_TIME, 1);
+	return 1;
+}
+
+/*
+*	Монотонное время журнала трассировки (единицы 10 мс от запуска): секундные прерывания TIM3 и счетчик миллисекунд
+*	Счетчик ограничивается 999 (секунда с поправкой хода может быть длиннее) и не зависит от перевода часов
+*/
+uint32_t traceTicks(void)
+{
+	uint32_t seconds = isrStats.tim3Updates;
+	uint16_t milliseconds = TIM3->CNT;
+	
+	if(TIM3->SR & TIM_SR_UIF)												// Секунда наступила, но еще не обработана
+	{
+		seconds++;
+		milliseconds = TIM3->CNT;
+	}
+	return seconds * 100ul + (milliseconds > 999 ? 999 : milliseconds) / 10u;
+}
+
+/* Сохранение настроек в хранилище (неизменившиеся значения не записываются) */
+void SettingsSave(void)
+{
+	uint8_t value[6];
+	
+	value[0] = alarmTime.hours;
+	value[1] = alarmTime.minutes;
+	value[2] = (uint8_t)FLAG(ALARM_ON);
+	value[3] = alarmTune;
+	value[4] = alarmVolume;
+	value[5] = sunriseMinutes;
+	storeWrite(SETTING_ALARM, value, 6);
+	storeWrite(SETTING_TELEMETRY, &telemetryPeriod, 1);
+	value[0] = gpsIsEnabled();
+	value[1] = canSyncGetRole();
+	value[2] = temperatureIsEnabled();
+	storeWrite(SETTING_SYNC, value, 3);
+}
+
+/* Восстановление настроек из хранилища (вызывается после инициализации модулей; значения вне диапазона не применяются) */
+void SettingsLoad(void)
+{
+	uint8_t value[6];
+	
+	if(storeRead(SETTING_ALARM, value, 6) == 6 && value[0] <= 23 && value[1] <= 59 && value[3] < BUZZER_TUNES && value[4] <= BUZZER_VOLUME_MAX &&
+	   (!value[5] || (value[5] >= SUNRISE_MIN_MINUTES && value[5] <= SUNRISE_MAX_MINUTES)))
+	{
+		alarmTime.hours = value[0];
+		alarmTime.minutes = value[1];
+		FLAG(ALARM_ON) = value[2] != 0;
+		alarmTune = value[3];
+		alarmVolume = value[4];
+		sunriseMinutes = value[5];
+	}
+	storeRead(SETTING_TELEMETRY, &telemetryPeriod, 1);
+	if(storeRead(SETTING_SYNC, value, 3) == 3 && value[1] <= CANSYNC_SLAVE)
+	{
+		gpsSetEnabled(value[0]);
+		canSyncSetRole(value[1]);
+		temperatureSetEnabled(value[2]);
+	}
+}
+
+/*
+*	Отправка кадра телеметрии состояния (формат описан в tools/telemetry_decode.py)
+*	Значения, изменяемые в прерываниях, копируются атомарно, кодирование выполняется сразу в буфер передачи
+*/
+void TelemetrySend(void)
+{
+	uint32_t utc;
+	int32_t offset;
+	isr_stats isr;
+	uint32_t basepri;
+	
+	basepri = criticalEnter(BOARD_LEVEL_TIME);
+	utc = TIM3_interrupts;
+	offset = localZone.offset;
+	isr = isrStats;
+	criticalExit(basepri);
+	
+	if(!telemetryBegin(TELEMETRY_TYPE_STATUS))
+	{
+		return;																// Буфер передачи занят - кадр пропускается, основной цикл не ждет
+	}
+	telemetryPutU32(utc);
+	telemetryPutU16((uint16_t)(offset / 60));
+	telemetryPutU8(alarmTime.hours);
+	telemetryPutU8(alarmTime.minutes);
+	telemetryPutU8((uint8_t)(FLAG(ALARM_ON) | (FLAG(ALARM_SIGNAL) << 1)));
+	telemetryPutU8((uint8_t)alarmGetState());
+	telemetryPutU8(alarmGetStage());
+	telemetryPutU32(isr.tim3Updates);
+	telemetryPutU32(isr.tim3Phases);
+	telemetryPutU16(isr.exti4);
+	telemetryPutU16(isr.exti9_5);
+	telemetryPutU16(alarmStats.fires);
+	telemetryPutU16(alarmStats.snoozes);
+	telemetryPutU16(alarmStats.dismisses);
+	telemetryPutU16(alarmStats.timeouts);
+	telemetryPutU16(consoleStats.frames);
+	telemetryPutU16(consoleStats.lines);
+	telemetryPutU16(consoleStats.rxOverflows);
+	telemetryPutU16(consoleStats.txOverflows);
+	telemetryPutU16(telemetryStats.dropped);
+	telemetryEnd();
+}
+
+#if METRICS_COUNT * 4 + 1 > TELEMETRY_MAX_PAYLOAD
+#error "The metrics registry does not fit in a telemetry frame"
+#endif
+
+/* Кадр телеметрии со снимком реестра метрик: количество метрик и значения (uint32) в порядке METRICS_LIST */
+void MetricsSend(void)
+{
+	uint32_t values[METRICS_COUNT];
+	uint8_t count, i;
+	
+	if(!telemetryBegin(TELEMETRY_TYPE_METRICS))
+	{
+		return;
+	}
+	count = metricsSnapshot(values, METRICS_COUNT);
+	telemetryPutU8(count);
+	for(i = 0; i < count; i++)
+	{
+		telemetryPutU32(values[i]);
+	}
+	telemetryEnd();
+}
+
+/*
+*	Вычитывание журнала трассировки: UTC и время журнала на момент вычитывания, время записи перед первой, записи
+*	(формат - tools/trace_decode.py); возвращает длину данных
+*/
+uint8_t TraceRead(uint8_t *p_data, uint8_t size)
+{
+	uint32_t utc = TIM3_interrupts, ticks = traceTicks(), base;
+	uint8_t length = traceDrain(&p_data[12], (uint8_t)(size - 12), &base), i;
+	
+	for(i = 0; i < 4; i++)
+	{
+		p_data[i] = (uint8_t)(utc >> (8 * i));
+		p_data[4 + i] = (uint8_t)(ticks >> (8 * i));
+		p_data[8 + i] = (uint8_t)(base >> (8 * i));
+	}
+	return (uint8_t)(length + 12);
+}
+
+/* Кадр телеметрии с очередной частью журнала трассировки (только если журнал не пуст и есть место в буфере передачи) */
+void TraceSend(void)
+{
+	uint8_t data[TELEMETRY_MAX_PAYLOAD], length, i;
+	
+	if(!traceStats.used || !telemetryBegin(TELEMETRY_TYPE_TRACE))
+	{
+		return;
+	}
+	length = TraceRead(data, TELEMETRY_MAX_PAYLOAD);
+	for(i = 0; i < length; i++)
+	{
+		telemetryPutU8(data[i]);
+	}
+	telemetryEnd();
+}
+
+/* Чтение регистра хранения Modbus (вызывается из прерывания TIM2) */
+uint8_t modbusReadRegister(uint16_t address, uint16_t *p_value)
+{
+	switch(address)
+	{
+		case MODBUS_REG_HOURS:			*p_value = currentTime.hours;		break;
+		case MODBUS_REG_MINUTES:		*p_value = currentTime.minutes;		break;
+		case MODBUS_REG_SECONDS:		*p_value = currentTime.seconds;		break;
+		case MODBUS_REG_ALARM_HOURS:	*p_value = alarmTime.hours;			break;
+		case MODBUS_REG_ALARM_MINUTES:	*p_value = alarmTime.minutes;		break;
+		case MODBUS_REG_ALARM_IS_ON:	*p_value = FLAG(ALARM_ON);				break;
+		case MODBUS_REG_ALARM_SIGNAL:	*p_value = FLAG(ALARM_SIGNAL);				break;
+		case MODBUS_REG_YEAR:			*p_value = currentDate.year;		break;
+		case MODBUS_REG_MONTH:			*p_value = currentDate.month;		break;
+		case MODBUS_REG_DAY:			*p_value = currentDate.day;			break;
+		default:						return 0;
+	}
+	return 1;
+}
+
+/*
+*	Запись регистра хранения Modbus (вызывается из прерывания TIM2)
+*	Изменение даты или времени выполняется через ClockSet с проверкой допустимости значения; во время настройки часов
+*	кнопками запись отклоняется (как в ClockSetUtc). Флаг устанавливается только в ButtonTask, которая не вытесняет
+*	это прерывание. Время будильника сравнивается в прерывании TIM3, поэтому изменяется в критической секции
+*/
+uint8_t modbusWriteRegister(uint16_t address, uint16_t value)
+{
+	date newDate;
+	time newTime;
+	uint32_t basepri;
+	
+	basepri = criticalEnter(BOARD_LEVEL_TIME);
+	newDate = currentDate;
+	newTime = currentTime;
+	criticalExit(basepri);
+	
+	switch(address)
 	{
-		switch(mode)		
+		case MODBUS_REG_HOURS:			newTime.hours = (uint8_t)value;		break;
+		case MODBUS_REG_MINUTES:		newTime.minutes = (uint8_t)value;	break;
+		case MODBUS_REG_SECONDS:		newTime.seconds = (uint8_t)value;	break;
+		case MODBUS_REG_YEAR:			newDate.year = value;				break;
+		case MODBUS_REG_MONTH:			newDate.month = (uint8_t)value;		break;
+		case MODBUS_REG_DAY:			newDate.day = (uint8_t)value;		break;
+		case MODBUS_REG_ALARM_HOURS:
+		case MODBUS_REG_ALARM_MINUTES:
 		{
-			case 0:			// Режим настройки минут
+			if(value > (address == MODBUS_REG_ALARM_HOURS ? 23 : 59))
 			{
-				if(incrementBtnClick) 								// При нажатии кнопки инкремента
-				{
-					p_time->minutes = (p_time->minutes + 1) % 60;	// Увеличивается на 1 количество минут (диапазон: 0...59)
-					incrementBtnClick = 0;							// Обнуляется флаг нажатия кнопки инкремента (клик считается обработанным)
-				}
-				
-				if(*p_buttonClick)									// При нажатии кнопки настройки устройства
-				{
-					mode++;											// Происходит переход в следующий режим (в режим настройки часов)
-					*p_buttonClick = 0;								// Обнуляется флаг нажатия кнопки настройки устройства (клик считается обработанным)
-				}
+				return 0;
 			}
-				break;
-			case 1:			// Режим настройки часов
+			sunriseStop();													// Рассвет, запущенный для прежнего времени будильника, отменяется
+			basepri = criticalEnter(BOARD_LEVEL_TIME);
+			if(address == MODBUS_REG_ALARM_HOURS)
 			{
-				if(incrementBtnClick)								// При нажатии кнопки инкремента
-				{
-					p_time->hours = (p_time->hours + 1) % 24;		// Увеличивается количество часов (диапазон: 0...23)
-					incrementBtnClick = 0;							// Обнуляется флаг нажатия кнопки инкремента (клик считается обработанным)
-				}
-				
-				if(*p_buttonClick)									// При нажатии кнопки настройки устройства
-				{
-					mode++;											// Происходит переход в следующий режим (в режим завершения настройки)
-					*p_buttonClick = 0;								// Обнуляется флаг нажатия кнопки настройки устройства (клик считается обработанным)
-				}
+				alarmTime.hours = (uint8_t)value;
 			}
-				break;
-			default:        // Режим завершения настройки
+			else
+			{
+				alarmTime.minutes = (uint8_t)value;
+			}
+			criticalExit(basepri);
+			return 1;
+		}
+		case MODBUS_REG_ALARM_IS_ON:
+		{
+			if(value > 1)
+			{
+				return 0;
+			}
+			FLAG(ALARM_ON) = value != 0;
+			return 1;
+		}
+		case MODBUS_REG_ALARM_SIGNAL:
+		{
+			if(value > 1)
 			{
-				return;		// Выход из функции
+				return 0;
 			}
+			modbusWriteCoil(value ? MODBUS_COIL_ALARM_ON : MODBUS_COIL_ALARM_OFF, 1);
+			return 1;
 		}
+		default:
+			return 0;
+	}
+	
+	if(FLAG(CLOCK_SETTING) || newDate.year < CALENDAR_EPOCH_YEAR || newDate.year > 2105 || newDate.month < 1 || newDate.month > 12 || newDate.day < 1 ||
+	   newDate.day > daysInMonth(newDate.year, newDate.month) || newTime.hours > 23 || newTime.minutes > 59 || newTime.seconds > 59)
+	{
+		return 0;
 	}
+	ClockSet(&newDate, &newTime);
+	return 1;
 }
 
-int main (void){
-	SystemCoreClockConfigure();     // Настройка тактирования                        
-	SystemCoreClockUpdate();		// Обновление частоты
-			
-	GPIO_Init();					// Инициализация порта ввода-вывода, таймера и внешних прерываний
-	TIM3_Init();
-	NVIC_InputInit();
-	while (1) 
+/* Чтение катушки Modbus: обе катушки отражают наличие сигнала тревоги */
+uint8_t modbusReadCoil(uint16_t address)
+{
+	return address == MODBUS_COIL_ALARM_ON ? (FLAG(ALARM_SIGNAL) != 0) : (FLAG(ALARM_SIGNAL) == 0);
+}
+
+/* Запись катушки Modbus: 1 в ALARM_ON подает сигнал тревоги, 1 в ALARM_OFF отключает его */
+void modbusWriteCoil(uint16_t address, uint8_t value)
+{
+	uint32_t basepri;
+
+	if(!value)
 	{
-		/* Сигнал тревоги подается, если до этого он был выключен, будильник стоит на дежурстве и совпало время часов и будильника */
-		if(!alarmSignal && alarmIsOn && compareTime(&currentTime, &alarmTime))
+		return;
+	}
+	if(address == MODBUS_COIL_ALARM_ON)
+	{
+		basepri = criticalEnter(BOARD_LEVEL_TIME);							// Состояние обработчика сигнала изменяется также в прерывании TIM3
+		if(!FLAG(ALARM_SIGNAL))
 		{
 			ALARM_ON();
 		}
+		criticalExit(basepri);
+	}
+	else
+	{
+		ALARM_OFF();
+	}
+}
+
+/* Вывод времени в формате ЧЧ:ММ */
+void consolePrintTime(const time *p_time)
+{
+	consolePrintNumber(p_time->hours, 2);
+	consolePrint(":");
+	consolePrintNumber(p_time->minutes, 2);
+}
+
+/* Вывод целого числа со знаком */
+void consolePrintSigned(int32_t value)
+{
+	if(value < 0)
+	{
+		consolePrint("-");
+	}
+	consolePrintNumber(value < 0 ? (uint32_t)-value : (uint32_t)value, 1);
+}
+
+/* Вывод числа с фиксированной точкой (scale - 10, 100 или 1000, decimals - количество знаков после точки) */
+void consolePrintFixed(int32_t value, uint32_t scale, uint8_t decimals)
+{
+	uint32_t magnitude = value < 0 ? (uint32_t)-value : (uint32_t)value;
+	
+	consolePrint(value < 0 ? "-" : "");
+	consolePrintNumber(magnitude / scale, 1);
+	consolePrint(".");
+	consolePrintNumber(magnitude % scale, decimals);
+}
+
+/* Вывод байтов шестнадцатеричными цифрами */
+void consolePrintHex(const uint8_t *p_data, uint8_t length)
+{
+	static const char digits[] = "0123456789abcdef";
+	char text[3] = {0};
+	
+	while(length--)
+	{
+		text[0] = digits[*p_data >> 4];
+		text[1] = digits[*p_data++ & 0x0F];
+		consolePrint(text);
+	}
+}
+
+/*
+*	Обработка команды консоли
+*	time								- текущие дата и время
+*	time ГГГГ-ММ-ДД ЧЧ:ММ[:СС]			- установка даты и времени
+*	alarm								- время и состояние будильника
+*	alarm ЧЧ:ММ | alarm on | alarm off	- установка времени, включение и отключение будильника
+*	stats								- статистика будильника и консоли
+*	telemetry [период] | telemetry off	- включение (период в секундах) и выключение двоичной телеметрии
+*	cansync [master | slave | off]		- роль узла и состояние синхронизации времени по CAN
+*	gps [on | off]						- подстройка часов по приемнику GPS (1PPS и RMC)
+*	calibrate [start | clear]			- калибровка кварца по опорному импульсу, остаточная ошибка хода
+*	temp [on | off]						- температура кристалла и термокомпенсация хода
+*	clock								- источник тактирования и отказы HSE
+*	store								- состояние хранилища настроек, коэффициент усиления записи, время построения индекса
+*	events								- последние события журнала
+*	trace								- статистика и очередная часть журнала трассировки (tools/trace_decode.py)
+*	stack								- наибольшая глубина стека и распределенное ОЗУ
+*	update								- перезапуск в загрузчик для обновления (tools/boot_image.py)
+*	tasks								- запуски, наибольшее время, бюджет, превышения, опоздания и задержка запуска задач, доля сна
+*	metrics								- снимок реестра метрик (счетчики и показатели, metrics.h)
+*/
+void consoleCommand(char *line)
+{
+	static const char *weekdays[7] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
+	uint32_t value[6] = {0};
+	uint8_t count = 0;
+	date newDate;
+	time newTime;
+	uint32_t basepri;
+	
+	if(consoleMatch(&line, "time"))
+	{
+		while(count < 6 && consoleNumber(&line, &value[count]))		// Год, месяц, день, часы, минуты, секунды
+		{
+			count++;
+		}
+		if(count >= 5)
+		{
+			if(value[0] < CALENDAR_EPOCH_YEAR || value[0] > 2105 || value[1] < 1 || value[1] > 12 || value[2] < 1 ||
+			   value[2] > daysInMonth((uint16_t)value[0], (uint8_t)value[1]) || value[3] > 23 || value[4] > 59 || value[5] > 59)
+			{
+				consolePrint("ERR range\r\n");
+				return;
+			}
+			newDate.year = (uint16_t)value[0];
+			newDate.month = (uint8_t)value[1];
+			newDate.day = (uint8_t)value[2];
+			newTime.hours = (uint8_t)value[3];
+			newTime.minutes = (uint8_t)value[4];
+			newTime.seconds = (uint8_t)value[5];
+			if(!ClockRequest(&newDate, &newTime))
+			{
+				consolePrint("ERR busy\r\n");
+				return;
+			}
+		}
+		else if(count)
+		{
+			consolePrint("ERR format\r\n");
+			return;
+		}
+		
+		basepri = criticalEnter(BOARD_LEVEL_TIME);
+		newDate = currentDate;
+		newTime = currentTime;
+		criticalExit(basepri);
+		consolePrintNumber(newDate.year, 4);
+		consolePrint("-");
+		consolePrintNumber(newDate.month, 2);
+		consolePrint("-");
+		consolePrintNumber(newDate.day, 2);
+		consolePrint(" ");
+		consolePrintTime(&newTime);
+		consolePrint(":");
+		consolePrintNumber(newTime.seconds, 2);
+		consolePrint(" ");
+		consolePrint(weekdays[newDate.weekday]);
+		consolePrint(" ");
+		consolePrint(localZone.zone->name);
+		consolePrint("\r\n");
+	}
+	else if(consoleMatch(&line, "alarm"))
+	{
+		if(consoleNumber(&line, &value[0]))
+		{
+			if(!consoleNumber(&line, &value[1]))								// Часы без минут
+			{
+				consolePrint("ERR format\r\n");
+				return;
+			}
+			if(value[0] > 23 || value[1] > 59)
+			{
+				consolePrint("ERR range\r\n");
+				return;
+			}
+			sunriseStop();															// Рассвет, запущенный для прежнего времени будильника, отменяется
+			basepri = criticalEnter(BOARD_LEVEL_TIME);								// Время будильника сравнивается в прерывании TIM3
+			alarmTime.hours = (uint8_t)value[0];
+			alarmTime.minutes = (uint8_t)value[1];
+			criticalExit(basepri);
+			FLAG(ALARM_ON) = 1;
+		}
+		else if(consoleMatch(&line, "on"))
+		{
+			FLAG(ALARM_ON) = 1;
+		}
+		else if(consoleMatch(&line, "off"))
+		{
+			FLAG(ALARM_ON) = 0;
+			ALARM_OFF();
+		}
+		else if(*line)
+		{
+			consolePrint("ERR format\r\n");
+			return;
+		}
+		
+		consolePrint("alarm ");
+		consolePrintTime(&alarmTime);
+		consolePrint(FLAG(ALARM_ON) ? " on" : " off");
+		consolePrint(alarmGetState() == ALARM_RINGING ? " ringing\r\n" : (alarmGetState() == ALARM_SNOOZED ? " snoozed\r\n" : "\r\n"));
+	}
+	else if(consoleMatch(&line, "stats"))
+	{
+		consolePrint("fires ");
+		consolePrintNumber(alarmStats.fires, 1);
+		consolePrint(" snoozes ");
+		consolePrintNumber(alarmStats.snoozes, 1);
+		consolePrint(" dismisses ");
+		consolePrintNumber(alarmStats.dismisses, 1);
+		consolePrint(" timeouts ");
+		consolePrintNumber(alarmStats.timeouts, 1);
+		consolePrint(" dismiss_s last ");
+		consolePrintNumber(alarmStats.lastDismissTime, 1);
+		consolePrint(" max ");
+		consolePrintNumber(alarmStats.maxDismissTime, 1);
+		consolePrint(" avg ");
+		consolePrintNumber(alarmStats.dismisses ? alarmStats.totalDismissTime / alarmStats.dismisses : 0, 1);
+		consolePrint("\r\nrx ");
+		consolePrintNumber(consoleStats.rxBytes, 1);
+		consolePrint(" tx ");
+		consolePrintNumber(consoleStats.txBytes, 1);
+		consolePrint(" frames ");
+		consolePrintNumber(consoleStats.frames, 1);
+		consolePrint(" lines ");
+		consolePrintNumber(consoleStats.lines, 1);
+		consolePrint(" rx_ovf ");
+		consolePrintNumber(consoleStats.rxOverflows, 1);
+		consolePrint(" tx_ovf ");
+		consolePrintNumber(consoleStats.txOverflows, 1);
+		consolePrint("\r\nmodbus requests ");
+		consolePrintNumber(modbusStats.requests, 1);
+		consolePrint(" crc ");
+		consolePrintNumber(modbusStats.crcErrors, 1);
+		consolePrint(" exceptions ");
+		consolePrintNumber(modbusStats.exceptions, 1);
+		consolePrint(" overruns ");
+		consolePrintNumber(modbusStats.overruns, 1);
+		consolePrint("\r\n");
+	}
+	else if(consoleMatch(&line, "cansync"))
+	{
+		if(consoleMatch(&line, "master"))
+		{
+			canSyncSetRole(CANSYNC_MASTER);
+		}
+		else if(consoleMatch(&line, "slave"))
+		{
+			gpsSetEnabled(0);														// Ведомый подстраивается только по CAN
+			canSyncSetRole(CANSYNC_SLAVE);
+		}
+		else if(consoleMatch(&line, "off"))
+		{
+			canSyncSetRole(CANSYNC_OFF);
+		}
+		else if(*line)
+		{
+			consolePrint("ERR format\r\n");
+			return;
+		}
 		
+		consolePrint(canSyncGetRole() == CANSYNC_MASTER ? "cansync master" : (canSyncGetRole() == CANSYNC_SLAVE ? "cansync slave" : "cansync off"));
+		consolePrint(" syncs ");
+		consolePrintNumber(cansyncStats.syncs, 1);
+		consolePrint(" followups ");
+		consolePrintNumber(cansyncStats.followUps, 1);
+		consolePrint(" lost ");
+		consolePrintNumber(cansyncStats.lost, 1);
+		consolePrint(" steps ");
+		consolePrintNumber(cansyncStats.steps, 1);
+		consolePrint(" offset_ms ");
+		consolePrintSigned(cansyncStats.offset);
+		consolePrint(" rate_ppb ");
+		consolePrintSigned(cansyncStats.rate);
+		consolePrint("\r\n");
+	}
+	else if(consoleMatch(&line, "gps"))
+	{
+		if(consoleMatch(&line, "on"))
+		{
+			if(canSyncGetRole() == CANSYNC_SLAVE)
+			{
+				canSyncSetRole(CANSYNC_MASTER);										// Узел с GPS раздает время остальным по CAN
+			}
+			gpsSetEnabled(1);
+		}
+		else if(consoleMatch(&line, "off"))
+		{
+			gpsSetEnabled(0);
+		}
+		else if(*line)
+		{
+			consolePrint("ERR format\r\n");
+			return;
+		}
+		
+		consolePrint(gpsIsEnabled() ? "gps on" : "gps off");
+		consolePrint(gpsStats.fix ? " fix" : " nofix");
+		consolePrint(" pps ");
+		consolePrintNumber(gpsStats.ppsEdges, 1);
+		consolePrint(" rmc ");
+		consolePrintNumber(gpsStats.sentences, 1);
+		consolePrint(" crc ");
+		consolePrintNumber(gpsStats.checksumErrors, 1);
+		consolePrint(" steps ");
+		consolePrintNumber(gpsStats.steps, 1);
+		consolePrint(" offset_ms ");
+		consolePrintSigned(gpsStats.offset);
+		consolePrint(" hse_ppb ");
+		consolePrintSigned(gpsStats.frequency);
+		consolePrint("\r\n");
+	}
+	else if(consoleMatch(&line, "calibrate"))
+	{
+		static const char *states[3] = {"idle", "running", "done"};
+		
+		if(consoleMatch(&line, "start"))
+		{
+			calibrationStart();
+		}
+		else if(consoleMatch(&line, "clear"))
+		{
+			calibrationClear();
+		}
+		else if(*line)
+		{
+			consolePrint("ERR format\r\n");
+			return;
+		}
+		
+		consolePrint("calibrate ");
+		consolePrint(states[calibrationStats.state]);
+		consolePrint(" window_s ");
+		consolePrintNumber(calibrationStats.seconds, 1);
+		consolePrint("/");
+		consolePrintNumber(CALIBRATION_WINDOW, 1);
+		consolePrint(" hse_ppm ");
+		consolePrintFixed(calibrationStats.error, 1000, 3);
+		consolePrint(" trim_ppm ");
+		consolePrintFixed(calibrationStats.trim, 1000, 3);
+		consolePrint(" residual_ppm ");
+		consolePrintFixed(calibrationStats.residual, 1000, 3);
+		consolePrint("\r\n");
+	}
+	else if(consoleMatch(&line, "temp"))
+	{
+		if(consoleMatch(&line, "on"))
+		{
+			temperatureSetEnabled(1);
+		}
+		else if(consoleMatch(&line, "off"))
+		{
+			temperatureSetEnabled(0);
+		}
+		else if(*line)
+		{
+			consolePrint("ERR format\r\n");
+			return;
+		}
+		
+		consolePrint(temperatureIsEnabled() ? "temp on " : "temp off ");
+		consolePrintFixed(temperatureGet(), 100, 2);
+		consolePrint("C correction_ppm ");
+		consolePrintFixed(temperatureCorrection(), 1000, 3);
+		consolePrint(" total_ppm ");
+		consolePrintFixed(timebaseGetRate(), 1000, 3);
+		consolePrint("\r\n");
+	}
+	else if(consoleMatch(&line, "clock"))
+	{
+		static const char *sources[3] = {"hse", "hsi_pll", "hsi"};
+		
+		consolePrint("clock ");
+		consolePrint(sources[clockStats.source]);
+		consolePrint(" failures ");
+		consolePrintNumber(clockStats.failures, 1);
+		consolePrint(" last ");
+		consolePrintNumber(clockStats.lastFailure, 1);
+		consolePrint(" recoveries ");
+		consolePrintNumber(clockStats.recoveries, 1);
+		consolePrint(" last ");
+		consolePrintNumber(clockStats.lastRecovery, 1);
+		consolePrint(" hsi_ppm ");
+		consolePrintFixed(clockStats.hsiRate, 1000, 3);
+		consolePrint("\r\n");
+	}
+	else if(consoleMatch(&line, "store"))
+	{
+		consolePrint("store page ");
+		consolePrintNumber(storeStats.page, 1);
+		consolePrint(" free ");
+		consolePrintNumber(storeStats.free, 1);
+		consolePrint(" erases ");
+		consolePrintNumber(storeStats.erases, 1);
+		consolePrint(" copies ");
+		consolePrintNumber(storeStats.copies, 1);
+		consolePrint(" events ");
+		consolePrintNumber(storeStats.events, 1);
+		consolePrint(" lost ");
+		consolePrintNumber(storeStats.eventsLost, 1);
+		consolePrint(" errors ");
+		consolePrintNumber(storeStats.errors, 1);
+		consolePrint("\r\npayload ");
+		consolePrintNumber(storeStats.payloadBytes, 1);
+		consolePrint(" programmed ");
+		consolePrintNumber(storeStats.programBytes, 1);
+		consolePrint(" amplification ");
+		consolePrintFixed(storeStats.payloadBytes ? (int32_t)(storeStats.programBytes * 100ull / storeStats.payloadBytes) : 0, 100, 2);
+		consolePrint("\r\nboot records ");
+		consolePrintNumber(storeStats.bootRecords, 1);
+		consolePrint(" crc ");
+		consolePrintNumber(storeStats.crcErrors, 1);
+		consolePrint(" us ");
+		consolePrintNumber(storeStats.bootCycles / (SystemCoreClock / 1000000ul), 1);
+		consolePrint("\r\n");
+	}
+	else if(consoleMatch(&line, "events"))
+	{
+		static const char *names[6] = {"boot", "alarm", "alarm_off", "snooze", "clock_set", "alarm_set"};
+		store_event events[8];
+		
+		count = storeReadEvents(events, 8);
+		for(value[0] = 0; value[0] < count; value[0]++)
+		{
+			secondsToDateTime(events[value[0]].seconds + (uint32_t)localZone.offset, &newDate, &newTime);
+			consolePrintNumber(newDate.year, 4);
+			consolePrint("-");
+			consolePrintNumber(newDate.month, 2);
+			consolePrint("-");
+			consolePrintNumber(newDate.day, 2);
+			consolePrint(" ");
+			consolePrintTime(&newTime);
+			consolePrint(":");
+			consolePrintNumber(newTime.seconds, 2);
+			consolePrint(" ");
+			consolePrint(events[value[0]].id < 6 ? names[events[value[0]].id] : "?");
+			consolePrint(" ");
+			consolePrintNumber(events[value[0]].arg, 1);
+			consolePrint("\r\n");
+		}
+	}
+	else if(consoleMatch(&line, "trace"))
+	{
+		uint8_t data[44];
+		
+		consolePrint("trace events ");
+		consolePrintNumber(traceStats.events, 1);
+		consolePrint(" lost ");
+		consolePrintNumber(traceStats.lost, 1);
+		consolePrint(" used ");
+		consolePrintNumber(traceStats.used, 1);
+		consolePrint("/");
+		consolePrintNumber(TRACE_SIZE, 1);
+		consolePrint(" drained ");
+		consolePrintNumber(traceStats.drained, 1);
+		consolePrint("\r\ntrace ");
+		consolePrintHex(data, TraceRead(data, sizeof(data)));
+		consolePrint("\r\n");
+	}
+	else if(consoleMatch(&line, "update"))
+	{
+		BKP->DR6 = BOOT_REQUEST;											// Запрос сохраняется при сбросе; ответ - BOOT_READY загрузчика
+		NVIC_SystemReset();
+	}
+	else if(consoleMatch(&line, "stack"))
+	{
+		consolePrint("stack used ");
+		consolePrintNumber(stackUsed(), 1);
+		consolePrint("/");
+		consolePrintNumber(stackSize(), 1);
+		consolePrint(" ram ");
+		consolePrintNumber(stackRamUsed(), 1);
+		consolePrint("/");
+		consolePrintNumber(STACK_RAM_SIZE, 1);
+		consolePrint("\r\n");
+	}
+	else if(consoleMatch(&line, "tasks"))
+	{
+		for(value[0] = 0; value[0] < TASKS; value[0]++)
+		{
+			consolePrint("task ");
+			consolePrintNumber(value[0], 1);
+			consolePrint(" runs ");
+			consolePrintNumber(schedStats[value[0]].runs, 1);
+			consolePrint(" max us ");
+			consolePrintNumber(schedStats[value[0]].maxCycles / (SystemCoreClock / 1000000ul), 1);
+			consolePrint(" budget ");
+			consolePrintNumber(tasks[value[0]].budget, 1);
+			consolePrint(" overruns ");
+			consolePrintNumber(schedStats[value[0]].overruns, 1);
+			consolePrint(" late ");
+			consolePrintNumber(schedStats[value[0]].late, 1);
+			consolePrint(" latency us ");
+			consolePrintNumber(schedStats[value[0]].maxLatency / (SystemCoreClock / 1000000ul), 1);
+			consolePrint("\r\n");
+		}
+		consolePrint("idle ");
+		consolePrintFixed(1000 - (int32_t)metrics.awake, 10, 1);
+		consolePrint("%\r\n");
+	}
+	else if(consoleMatch(&line, "metrics"))
+	{
+		uint32_t values[METRICS_COUNT];
+		
+		count = metricsSnapshot(values, METRICS_COUNT);
+		for(value[0] = 0; value[0] < count; value[0]++)
+		{
+			consolePrint(metricsName((uint8_t)value[0]));
+			consolePrint(" ");
+			consolePrintNumber(values[value[0]], 1);
+			consolePrint("\r\n");
+		}
+	}
+	else if(consoleMatch(&line, "telemetry"))
+	{
+		if(consoleNumber(&line, &value[0]))
+		{
+			telemetryPeriod = (uint8_t)(value[0] ? (value[0] > 255 ? 255 : value[0]) : 1);
+		}
+		else if(consoleMatch(&line, "off"))
+		{
+			telemetryPeriod = 0;
+		}
+		else
+		{
+			telemetryPeriod = 1;
+		}
+		consolePrint("OK\r\n");
+	}
+	else
+	{
+		consolePrint("ERR command\r\n");
+	}
+}
+
+/*
+*	Задача кнопок (запускается прерываниями EXTI)
+*	Настройка часов и будильника идет по шагам: между нажатиями остальные задачи продолжают работать
+*/
+void ButtonTask(void)
+{
+	uint32_t basepri;
+#ifdef RTE_CMSIS_RTOS2_RTX5
+	clock_value request;
+
+	while(osMessageQueueGet(setQueue, &request, 0, 0) == osOK)					// Установка часов, запрошенная консолью
+	{
+		ClockSet(&request.day, &request.clock);
+		osEventFlagsSet(clockEvents, CLOCK_SET_DONE);
+	}
+#endif
+
+	if(!FLAG(CLOCK_SETTING) && !FLAG(ALARM_SETTING))
+	{
 		/* Сигнал тревоги отключается, если до этого он был включен, нажата кнопка инкремента и устройство не находится в режиме настройки часов и будильника */
-		if(alarmSignal && incrementBtnClick)
+		if(FLAG(ALARM_SIGNAL) && FLAG(INCREMENT_CLICK))
 		{
 			ALARM_OFF();
+			FLAG(INCREMENT_CLICK) = 0;													// Нажатие обработано
 		}
 		
-		if(clockTimeBtnClick)														// При нажатии кнопки настройки часов
+		/* Во время подачи сигнала кнопка настройки будильника откладывает сигнал на ALARM_SNOOZE_MINUTES минут */
+		if(FLAG(ALARM_CLICK) && alarmGetState() == ALARM_RINGING)
 		{
-			clockTimeSetting = 1;													// Устанавливается режим настройки часов
-			TimeSet(&currentTime, &clockTimeBtnClick);								// Производится вызов функции настройки
-			TIM3_interrupts = currentTime.hours * 3600 + currentTime.minutes * 60;  // После завершения настройки обновляется общее время на таймере
-			clockTimeSetting = 0;													// Происходит возврат в обычный режим работы
+			ALARM_SNOOZE();
+			FLAG(ALARM_CLICK) = 0;													// Нажатие обработано (режим настройки будильника не включается)
 		}
 		
-		if(alarmTimeBtnClick)														// При нажатии кнопки настройки будильника
+		if(FLAG(CLOCK_CLICK))														// При нажатии кнопки настройки часов
 		{
-			alarmTimeSetting = 1;													// Устанавливается режим настройки будильника
-			TimeSet(&alarmTime, &alarmTimeBtnClick);								// Производится вызов функции настройки 
-			alarmIsOn = 1;															// После завершения настройки будильник ставится на дежурство
-			alarmTimeSetting = 0;													// Происходит возврат в обычный режим работы
+			FLAG(CLOCK_SETTING) = 1;													// Устанавливается режим настройки часов
+			traceEvent(TRACE_MODE, 1);
+			TimeSetStart(&currentTime, &FLAG(CLOCK_CLICK));
 		}
+		else if(FLAG(ALARM_CLICK))													// При нажатии кнопки настройки будильника
+		{
+			FLAG(ALARM_SETTING) = 1;													// Устанавливается режим настройки будильника
+			traceEvent(TRACE_MODE, 2);
+			sunriseStop();															// Рассвет, запущенный для прежнего времени будильника, отменяется
+			TimeSetStart(&alarmTime, &FLAG(ALARM_CLICK));
+		}
+	}
+	
+	if(!p_settingTime || !TimeSet())												// Настройка не идет или не завершена
+	{
+		return;
+	}
+	
+	if(FLAG(CLOCK_SETTING))
+	{
+		basepri = criticalEnter(BOARD_LEVEL_TIME);								// Время и кэш пояса изменяются также в прерываниях TIM3 и синхронизации (ClockSetUtc)
+		currentTime.seconds = 0;												// Отсчет продолжается с заданного пользователем времени со сбросом секунд
+		TIM3_interrupts = tzLocalToUtc(&localZone, dateTimeToSeconds(&currentDate, &currentTime));	// После завершения настройки обновляется общее время (UTC) на таймере
+		storeEvent(EVENT_CLOCK_SET, TIM3_interrupts, 1);
+		FLAG(CLOCK_SETTING) = 0;													// Происходит возврат в обычный режим работы
+		criticalExit(basepri);
+		ClockPublish();
+	}
+	else
+	{
+		FLAG(ALARM_ON) = 1;															// После завершения настройки будильник ставится на дежурство
+		storeEvent(EVENT_ALARM_SET, TIM3_interrupts, (uint16_t)(alarmTime.hours * 60u + alarmTime.minutes));
+		FLAG(ALARM_SETTING) = 0;													// Происходит возврат в обычный режим работы
+	}
+	traceEvent(TRACE_MODE, 0);
+	if(FLAG(CLOCK_CLICK) || FLAG(ALARM_CLICK))									// Нажатие другой кнопки во время настройки обрабатывается после нее
+	{
+		schedTrigger(TASK_BUTTONS);
+	}
+}
+
+/* Задача консоли: обработка команд, принятых по последовательному порту */
+void ConsoleTask(void)
+{
+	consolePoll(consoleCommand);
+}
+
+/*
+*	Задача индикации: текущее или настраиваемое время
+*	В сборке RTX5 текущие дата и время - последний снимок из очереди (снимки приходят раз в секунду и при установке)
+*/
+void DisplayTask(void)
+{
+#ifdef RTE_CMSIS_RTOS2_RTX5
+	static clock_value view;
+
+	while(osMessageQueueGet(viewQueue, &view, 0, 0) == osOK)
+	{
+	}
+	DisplayUpdate(p_settingTime ? p_settingTime : &view.clock, &view.day);
+#else
+	DisplayUpdate(p_settingTime ? p_settingTime : &currentTime, &currentDate);
+#endif
+}
+
+/* Задача сохранения: изменившиеся настройки сохраняются не чаще раза в секунду и не во время настройки */
+void SettingsTask(void)
+{
+	if(!FLAG(CLOCK_SETTING) && !FLAG(ALARM_SETTING))
+	{
+		SettingsSave();
+	}
+}
+
+/* Задача телеметрии: кадры состояния и метрик, часть журнала трассировки */
+void TelemetryTask(void)
+{
+	TelemetrySend();
+	MetricsSend();
+	TraceSend();
+}
+
+/*
+*	Таблица задач в порядке task_id (период в тиках SCHED_TICK_MS, бюджет в мкс - оценки, не измерения)
+*	Потоки сборки RTX5: 0 - кнопки и тактирование, 1 - индикация, 2 - связь (консоль, хранилище и телеметрия делят UART и flash)
+*/
+static const sched_task tasks[TASKS] = {
+	{ButtonTask, 0, 1000, 0},
+	{ConsoleTask, 1, 5000, 2},
+	{DisplayTask, 2, 2000, 1},
+	{storePoll, 10, 25000, 2},							// Стирание страницы flash - до 20 мс
+	{SettingsTask, 0, 25000, 2},
+	{TelemetryTask, 0, 2000, 2},
+	{clockRecover, 0, 1000, 0},							// Запуск PLL - сотни мкс
+};
+
+/* Задача превысила бюджет - событие в журнале трассировки */
+void schedOverrun(uint8_t task, uint32_t cycles)
+{
+	(void)cycles;
+	traceEvent(TRACE_OVERRUN, task);
+}
+
+int main (void){
+	SCB->VTOR = BOOT_APP_BASE;		// Таблица векторов приложения - после загрузчика (SystemInit устанавливает начало flash)
+	SystemCoreClockConfigure();     // Настройка тактирования                        
+	SystemCoreClockUpdate();		// Обновление частоты
+	Metrics_Init();					// Счетчик тактов для метрик прерываний и отсева дребезга
+			
+	tzSelect(&localZone, LOCAL_ZONE, TIM3_interrupts);									// Выбор часового пояса и вычисление местного времени
+	secondsToDateTime(TIM3_interrupts + (uint32_t)localZone.offset, &currentDate, &currentTime);
+	
+	Board_Init();					// Настройка выводов, внешних прерываний и приоритетов по описанию платы
+	Buzzer_Init();
+	Sunrise_Init();
+	Console_Init();
+	Modbus_Init();
+	CanSync_Init();
+	Gps_Init();
+	Temperature_Init();
+	Display_Init();
+	Oled_Init();
+	Calibration_Init();
+	Store_Init();					// Построение индекса хранилища и восстановление настроек
+	SettingsLoad();
+	storeEvent(EVENT_BOOT, TIM3_interrupts, (uint16_t)(RCC->CSR >> 24));				// Причина сброса
+	RCC->CSR |= RCC_CSR_RMVF;
+	ClockQueues_Init();				// Сборка RTX5: очереди и флаги событий часов до первых прерываний TIM3
+	TIM3_Init();
+	boardExtiEnable();				// Кнопки
+	Sched_Init(tasks, TASKS);		// Задачи запускаются тиками TIM3 и прерываниями
+	while (1) 
+	{
+		schedRun();					// Очередная готовая задача или сон до прерывания
 	}
 }
@@ -0,0 +1,71 @@
+#include "stm32f10x.h"
+#include "metrics.h"
+
+#define METRICS_NAME(name, kind) 	#name,
+
+volatile metrics_registry metrics;
+
+static const char *const names[METRICS_COUNT] = {METRICS_LIST(METRICS_NAME)};
+
+/* Счетчик тактов DWT запускается до разрешения прерываний кнопок (планировщик запускает его позже) */
+void Metrics_Init(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/* Атомарное сложение: вытеснение между LDREX и STREX (вход и выход из прерывания снимают монитор) приводит к повтору */
+void metricsAdd(volatile uint32_t *p_metric, uint32_t value)
+{
+	uint32_t current;
+
+	do
+	{
+		current = __LDREXW(p_metric);
+	} while(__STREXW(current + value, p_metric));
+}
+
+/* Атомарное наибольшее значение (запись только при увеличении) */
+void metricsMax(volatile uint32_t *p_metric, uint32_t value)
+{
+	do
+	{
+		if(__LDREXW(p_metric) >= value)
+		{
+			__CLREX();
+			return;
+		}
+	} while(__STREXW(value, p_metric));
+}
+
+/* Время обработчика от входа до вызова (включая вытеснившие его прерывания более высокого уровня) */
+void metricsIsr(uint32_t start)
+{
+	uint32_t cycles = DWT->CYCCNT - start;
+
+	metricsAdd(&metrics.isrCount, 1);
+	metricsAdd(&metrics.isrCycles, cycles);
+	metricsMax(&metrics.isrMaxCycles, cycles);
+}
+
+/* Снимок: каждое поле копируется одним чтением слова, прерывания не запрещаются */
+uint8_t metricsSnapshot(uint32_t *p_values, uint8_t count)
+{
+	const volatile uint32_t *p_field = (const volatile uint32_t *)&metrics;
+	uint8_t i;
+
+	if(count > METRICS_COUNT)
+	{
+		count = METRICS_COUNT;
+	}
+	for(i = 0; i < count; i++)
+	{
+		p_values[i] = p_field[i];
+	}
+	return count;
+}
+
+const char *metricsName(uint8_t index)
+{
+	return index < METRICS_COUNT ? names[index] : "?";
+}
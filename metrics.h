@@ -0,0 +1,59 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+
+/*
+*	Реестр метрик: счетчики и показатели всей программы в одной статической структуре 32-битных полей
+*	Поле, которое изменяется с одного уровня прерываний (или при маскированном этом уровне), увеличивается
+*	обычной командой (METRIC_COUNT): обработчики одного уровня друг друга не вытесняют. Поле, изменяемое с разных
+*	уровней, - METRIC_ADD/METRIC_MAX (LDREX/STREX, без запрета прерываний; Cortex-M3 не имеет атомарного сложения
+*	с памятью одной командой). Показатель записывается одной командой (METRIC_SET).
+*	Выровненное слово читается одной командой, поэтому снимок (metricsSnapshot), консоль (команда metrics),
+*	кадр телеметрии TELEMETRY_TYPE_METRICS и отладчик (окно Watch: metrics, периодическое обновление без останова
+*	процессора) видят целые значения; согласованность разных полей между собой не гарантируется.
+*	Порядок полей - порядок значений снимка и кадра телеметрии (tools/telemetry_decode.py)
+*/
+
+/* Метрики: X(поле, вид); вид - для декодера телеметрии (у счетчиков выводится прирост между кадрами) */
+#define METRIC_COUNTER 	0		// Счетчик (только растет, по модулю 2^32)
+#define METRIC_GAUGE 	1		// Показатель (текущее или наибольшее значение)
+
+#define METRICS_LIST(X) \
+	X(ticks, 			METRIC_COUNTER) 	/* Тики планировщика (SCHED_TICK_MS) */ \
+	X(ticksMissed, 		METRIC_COUNTER) 	/* Тики, пропущенные из-за задержки обработки TIM3 */ \
+	X(buttonIncrement, 	METRIC_COUNTER) 	/* Нажатия кнопок по линиям EXTI (после отсева дребезга) */ \
+	X(buttonClock, 		METRIC_COUNTER) \
+	X(buttonAlarm, 		METRIC_COUNTER) \
+	X(bounces, 			METRIC_COUNTER) 	/* Фронты кнопок, отброшенные как дребезг */ \
+	X(alarmFires, 		METRIC_COUNTER) 	/* Срабатывания будильника */ \
+	X(queueOverflows, 	METRIC_COUNTER) 	/* Переполнения очередей: прием и передача консоли, кадры телеметрии, события хранилища и трассировки */ \
+	X(isrCount, 		METRIC_COUNTER) 	/* Обработчики прерываний с измерением времени (TIM3, EXTI) */ \
+	X(isrCycles, 		METRIC_COUNTER) 	/* Суммарное время этих обработчиков (тактов) */ \
+	X(isrMaxCycles, 	METRIC_GAUGE) 		/* Наибольшее время обработчика (тактов) */ \
+	X(awake, 			METRIC_GAUGE) 		/* Доля бодрствования процессора за последнюю секунду (десятые доли процента) */
+
+#define METRICS_FIELD(name, kind) 	uint32_t name;
+#define METRICS_ONE(name, kind) 	+ 1
+
+#define METRICS_COUNT 	(0 METRICS_LIST(METRICS_ONE))		// Количество метрик
+
+typedef struct metrics_registry_tag{	// Реестр (поля - METRICS_LIST)
+	METRICS_LIST(METRICS_FIELD)
+} metrics_registry;
+
+extern volatile metrics_registry metrics;
+
+#define METRIC_COUNT(name) 			(metrics.name++)						// Увеличение счетчика одного уровня прерываний
+#define METRIC_ADD(name, value) 	metricsAdd(&metrics.name, (value))		// Увеличение счетчика с любого уровня
+#define METRIC_MAX(name, value) 	metricsMax(&metrics.name, (value))		// Наибольшее значение с любого уровня
+#define METRIC_SET(name, value) 	(metrics.name = (value))				// Запись показателя
+
+void Metrics_Init(void);											// Запуск счетчика тактов DWT (время обработчиков, отсев дребезга)
+void metricsAdd(volatile uint32_t *p_metric, uint32_t value);		// Атомарное сложение (LDREX/STREX)
+void metricsMax(volatile uint32_t *p_metric, uint32_t value);		// Атомарное наибольшее значение
+void metricsIsr(uint32_t start);									// Учет времени обработчика прерывания (start - DWT->CYCCNT при входе)
+uint8_t metricsSnapshot(uint32_t *p_values, uint8_t count);			// Значения в порядке METRICS_LIST (не более count), возвращает количество
+const char *metricsName(uint8_t index);								// Имя метрики
+
+#endif /* METRICS_H */
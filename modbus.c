@@ -0,0 +1,248 @@
+#include "stm32f10x.h"
+#include "modbus.h"
+
+
+#define MODBUS_TIMER_CLOCK 	32000000ul											// Частота счета TIM2 (HCLK, предделитель 1)
+#define MODBUS_CHAR_TICKS 	(MODBUS_TIMER_CLOCK * 11ul / MODBUS_BAUDRATE)		// Длительность символа (11 бит) в тиках TIM2
+#define MODBUS_T25_TICKS 	(MODBUS_CHAR_TICKS * 5ul / 2ul)						// Ожидание после IDLE до 3.5 символов тишины
+
+#if MODBUS_T25_TICKS > 0xFFFF
+#error "MODBUS_BAUDRATE is too low for the 16-bit TIM2 timeout"
+#endif
+
+/* Функции и исключения Modbus */
+#define MODBUS_READ_COILS 			0x01
+#define MODBUS_READ_HOLDING 		0x03
+#define MODBUS_WRITE_COIL 			0x05
+#define MODBUS_WRITE_REGISTER 		0x06
+#define MODBUS_WRITE_REGISTERS 		0x10
+#define MODBUS_ILLEGAL_FUNCTION 	0x01
+#define MODBUS_ILLEGAL_ADDRESS 		0x02
+#define MODBUS_ILLEGAL_VALUE 		0x03
+
+modbus_stats modbusStats;
+
+static uint8_t rxFrame[MODBUS_FRAME_SIZE];		// Принимаемый кадр (заполняется DMA)
+static uint8_t txFrame[MODBUS_FRAME_SIZE];		// Ответ (передается DMA)
+static uint16_t rxCountAtIdle;					// Количество байт на момент прерывания IDLE
+
+/* CRC-16 Modbus (полином 0xA001, начальное значение 0xFFFF) */
+static uint16_t modbusCrc(const uint8_t *data, uint16_t length)
+{
+	uint16_t crc = 0xFFFF;
+	uint8_t bit;
+
+	while(length--)
+	{
+		crc ^= *data++;
+		for(bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 1) ? (uint16_t)((crc >> 1) ^ 0xA001) : (uint16_t)(crc >> 1);
+		}
+	}
+	return crc;
+}
+
+/* Перезапуск приема с начала буфера */
+static void modbusRestartRx(void)
+{
+	DMA1_Channel3->CCR = 0;
+	DMA1_Channel3->CNDTR = MODBUS_FRAME_SIZE;
+	DMA1_Channel3->CCR = DMA_CCR1_MINC | DMA_CCR1_EN;		// USART -> память
+}
+
+/* Отправка ответа длиной length (без CRC) */
+static void modbusSend(uint16_t length)
+{
+	uint16_t crc = modbusCrc(txFrame, length);
+
+	txFrame[length++] = (uint8_t)crc;
+	txFrame[length++] = (uint8_t)(crc >> 8);
+
+	DMA1_Channel2->CCR = 0;
+	DMA1->IFCR = DMA_IFCR_CGIF2;
+	DMA1_Channel2->CNDTR = length;
+	DMA1_Channel2->CCR = DMA_CCR1_DIR | DMA_CCR1_MINC | DMA_CCR1_EN;	// Память -> USART
+}
+
+/* Ответ с кодом исключения */
+static uint16_t modbusException(uint8_t code)
+{
+	modbusStats.exceptions++;
+	txFrame[1] |= 0x80;
+	txFrame[2] = code;
+	return 3;
+}
+
+/*
+*	Обработка запроса и формирование ответа в txFrame
+*	Возвращает длину ответа без CRC
+*/
+static uint16_t modbusProcess(const uint8_t *request, uint16_t length)
+{
+	uint16_t address = (uint16_t)((request[2] << 8) | request[3]);
+	uint16_t count = (uint16_t)((request[4] << 8) | request[5]);
+	uint16_t i;
+	uint16_t value;
+
+	txFrame[0] = request[0];
+	txFrame[1] = request[1];
+
+	switch(request[1])
+	{
+		case MODBUS_READ_COILS:
+		{
+			if(count < 1 || address + count > MODBUS_COILS)
+			{
+				return modbusException(MODBUS_ILLEGAL_ADDRESS);
+			}
+			txFrame[2] = 1;
+			txFrame[3] = 0;
+			for(i = 0; i < count; i++)
+			{
+				txFrame[3] |= (uint8_t)(modbusReadCoil(address + i) << i);
+			}
+			return 4;
+		}
+		case MODBUS_READ_HOLDING:
+		{
+			if(count < 1 || count > 125 || address + count > MODBUS_REGISTERS)
+			{
+				return modbusException(MODBUS_ILLEGAL_ADDRESS);
+			}
+			txFrame[2] = (uint8_t)(count * 2);
+			for(i = 0; i < count; i++)
+			{
+				modbusReadRegister(address + i, &value);
+				txFrame[3 + i * 2] = (uint8_t)(value >> 8);
+				txFrame[4 + i * 2] = (uint8_t)value;
+			}
+			return (uint16_t)(3 + count * 2);
+		}
+		case MODBUS_WRITE_COIL:
+		{
+			if(address >= MODBUS_COILS)
+			{
+				return modbusException(MODBUS_ILLEGAL_ADDRESS);
+			}
+			if(count != 0xFF00 && count != 0x0000)							// Значение катушки: 0xFF00 - 1, 0x0000 - 0
+			{
+				return modbusException(MODBUS_ILLEGAL_VALUE);
+			}
+			modbusWriteCoil(address, count == 0xFF00);
+			for(i = 2; i < 6; i++)
+			{
+				txFrame[i] = request[i];									// Ответ повторяет запрос
+			}
+			return 6;
+		}
+		case MODBUS_WRITE_REGISTER:
+		{
+			if(!modbusWriteRegister(address, count))
+			{
+				return modbusException(address < MODBUS_REGISTERS ? MODBUS_ILLEGAL_VALUE : MODBUS_ILLEGAL_ADDRESS);
+			}
+			for(i = 2; i < 6; i++)
+			{
+				txFrame[i] = request[i];
+			}
+			return 6;
+		}
+		case MODBUS_WRITE_REGISTERS:
+		{
+			if(count < 1 || count > 123 || address + count > MODBUS_REGISTERS || length < 7u + count * 2u || request[6] != count * 2)
+			{
+				return modbusException(MODBUS_ILLEGAL_ADDRESS);
+			}
+			for(i = 0; i < count; i++)
+			{
+				if(!modbusWriteRegister(address + i, (uint16_t)((request[7 + i * 2] << 8) | request[8 + i * 2])))
+				{
+					return modbusException(MODBUS_ILLEGAL_VALUE);
+				}
+			}
+			for(i = 2; i < 6; i++)
+			{
+				txFrame[i] = request[i];
+			}
+			return 6;
+		}
+		default:
+			return modbusException(MODBUS_ILLEGAL_FUNCTION);
+	}
+}
+
+/* Настройка USART3, DMA1_Channel3 (прием), DMA1_Channel2 (передача) и канала сравнения 4 TIM2 */
+void Modbus_Init(void)
+{
+	RCC->APB1ENR |= RCC_APB1ENR_USART3EN | RCC_APB1ENR_TIM2EN;					// Включение тактирования USART3 и TIM2
+	RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+
+	USART3->BRR = (uint16_t)((SystemCoreClock + MODBUS_BAUDRATE / 2) / MODBUS_BAUDRATE);
+	USART3->CR3 = USART_CR3_DMAR | USART_CR3_DMAT;
+
+	DMA1_Channel3->CPAR = (uint32_t)&USART3->DR;
+	DMA1_Channel3->CMAR = (uint32_t)rxFrame;
+	modbusRestartRx();
+	DMA1_Channel2->CPAR = (uint32_t)&USART3->DR;
+	DMA1_Channel2->CMAR = (uint32_t)txFrame;
+
+	TIM2->CR1 = TIM_CR1_CEN;													// TIM2 считает непрерывно (общий с ШИМ рассвета)
+
+	USART3->CR1 = USART_CR1_UE | USART_CR1_M | USART_CR1_PCE | USART_CR1_TE | USART_CR1_RE | USART_CR1_IDLEIE;	// 8 бит данных + четность
+	NVIC_EnableIRQ(USART3_IRQn);
+	NVIC_EnableIRQ(TIM2_IRQn);
+}
+
+/* Один символ тишины - запуск отсчета оставшихся 2.5 символов */
+void USART3_IRQHandler(void)
+{
+	if(USART3->SR & USART_SR_IDLE)
+	{
+		(void)USART3->DR;								// Чтение SR, затем DR снимает флаг IDLE
+		rxCountAtIdle = (uint16_t)(MODBUS_FRAME_SIZE - DMA1_Channel3->CNDTR);
+		TIM2->CCR4 = (uint16_t)(TIM2->CNT + MODBUS_T25_TICKS);
+		TIM2->SR = (uint16_t)~TIM_SR_CC4IF;
+		TIM2->DIER |= TIM_DIER_CC4IE;
+	}
+}
+
+/* Истекли 3.5 символа тишины - кадр принят, ответ формируется и передается сразу (вызывается из прерывания TIM2) */
+void modbusTimeout(void)
+{
+	uint16_t length;
+	uint16_t crc;
+
+	if(!(TIM2->SR & TIM_SR_CC4IF))
+	{
+		return;
+	}
+	TIM2->SR = (uint16_t)~TIM_SR_CC4IF;
+	TIM2->DIER &= ~TIM_DIER_CC4IE;
+
+	length = (uint16_t)(MODBUS_FRAME_SIZE - DMA1_Channel3->CNDTR);
+	if(length != rxCountAtIdle)							// Прием возобновился раньше 3.5 символов - кадр ждет следующего IDLE
+	{
+		modbusStats.overruns++;
+		return;
+	}
+	modbusRestartRx();
+
+	if(length < 8 || (rxFrame[0] != MODBUS_ADDRESS && rxFrame[0] != 0))
+	{
+		return;
+	}
+	crc = modbusCrc(rxFrame, (uint16_t)(length - 2));
+	if(rxFrame[length - 2] != (uint8_t)crc || rxFrame[length - 1] != (uint8_t)(crc >> 8))
+	{
+		modbusStats.crcErrors++;
+		return;
+	}
+	modbusStats.requests++;
+
+	length = modbusProcess(rxFrame, (uint16_t)(length - 2));
+	if(rxFrame[0] != 0)									// На широковещательные запросы ответ не передается
+	{
+		modbusSend(length);
+	}
+}
@@ -0,0 +1,53 @@
+#ifndef MODBUS_H
+#define MODBUS_H
+
+#include <stdint.h>
+
+/*
+*	Ведомое устройство Modbus RTU на USART3 (PB10 - TX, PB11 - RX), 8E1
+*	Прием: DMA1_Channel3, конец кадра - прерывание IDLE (1 символ тишины) плюс 2.5 символа,
+*	отсчитываемые каналом сравнения 4 таймера TIM2 (свободный счет на 32 МГц), итого 3.5 символа.
+*	Кадр обрабатывается в прерывании TIM2, ответ передается DMA1_Channel2
+*/
+
+#define MODBUS_ADDRESS 		1			// Адрес устройства
+#define MODBUS_BAUDRATE 	115200ul	// Скорость обмена (не ниже 19200: 2.5 символа должны укладываться в период TIM2)
+#define MODBUS_FRAME_SIZE 	256			// Максимальный размер кадра RTU
+
+/* Регистры хранения */
+#define MODBUS_REG_HOURS 			0	// Текущее время (местное): часы
+#define MODBUS_REG_MINUTES 			1	// минуты
+#define MODBUS_REG_SECONDS 			2	// секунды
+#define MODBUS_REG_ALARM_HOURS 		3	// Время будильника: часы
+#define MODBUS_REG_ALARM_MINUTES 	4	// минуты
+#define MODBUS_REG_ALARM_IS_ON 		5	// Будильник на дежурстве (alarmIsOn)
+#define MODBUS_REG_ALARM_SIGNAL 	6	// Сигнал тревоги (alarmSignal), запись 0 - отключение сигнала
+#define MODBUS_REG_YEAR 			7	// Текущая дата: год
+#define MODBUS_REG_MONTH 			8	// месяц
+#define MODBUS_REG_DAY 				9	// день
+#define MODBUS_REGISTERS 			10
+
+/* Катушки */
+#define MODBUS_COIL_ALARM_ON 		0	// Запись 1 - ALARM_ON (чтение - состояние сигнала)
+#define MODBUS_COIL_ALARM_OFF 		1	// Запись 1 - ALARM_OFF
+#define MODBUS_COILS 				2
+
+typedef struct modbus_stats_tag{	// Статистика Modbus
+	uint16_t requests;				// Принято кадров с верным адресом и CRC
+	uint16_t crcErrors;				// Кадры с ошибкой CRC
+	uint16_t exceptions;			// Ответы с кодом исключения
+	uint16_t overruns;				// Кадры, прерванные новым приемом до истечения 3.5 символов
+} modbus_stats;
+
+extern modbus_stats modbusStats;
+
+void Modbus_Init(void);		// Настройка USART3, DMA и канала сравнения TIM2
+void modbusTimeout(void);	// Обработка сравнения канала 4 TIM2 (вызывается из общего прерывания TIM2)
+
+/* Доступ к данным устройства (реализуется приложением, вызывается из прерывания TIM2) */
+uint8_t modbusReadRegister(uint16_t address, uint16_t *p_value);	// 0 - неверный адрес
+uint8_t modbusWriteRegister(uint16_t address, uint16_t value);		// 0 - неверный адрес или значение
+uint8_t modbusReadCoil(uint16_t address);
+void modbusWriteCoil(uint16_t address, uint8_t value);
+
+#endif /* MODBUS_H */
@@ -0,0 +1,129 @@
+#include "oled.h"
+#include "oled_font.h"
+
+#define OLED_CLEAN 	0xFF		// Признак страницы без изменений (в dirtyFirst)
+
+static uint8_t frame[OLED_PAGES][OLED_WIDTH];	// Кадр (байты диапазона читает прерывание I2C1)
+static uint8_t dirtyFirst[OLED_PAGES];			// Первый измененный столбец страницы, OLED_CLEAN - изменений нет
+static uint8_t dirtyLast[OLED_PAGES];			// Последний измененный столбец страницы
+
+/* Запись байта кадра: диапазон страницы расширяется, только если байт действительно изменился */
+static void oledPut(uint8_t page, uint8_t x, uint8_t value)
+{
+	if(page >= OLED_PAGES || x >= OLED_WIDTH || frame[page][x] == value)
+	{
+		return;
+	}
+	frame[page][x] = value;
+	if(dirtyFirst[page] == OLED_CLEAN)
+	{
+		dirtyFirst[page] = x;
+		dirtyLast[page] = x;
+	}
+	else if(x < dirtyFirst[page])
+	{
+		dirtyFirst[page] = x;
+	}
+	else if(x > dirtyLast[page])
+	{
+		dirtyLast[page] = x;
+	}
+}
+
+/* Очистка кадра */
+void oledClear(void)
+{
+	uint8_t page, x;
+
+	for(page = 0; page < OLED_PAGES; page++)
+	{
+		for(x = 0; x < OLED_WIDTH; x++)
+		{
+			oledPut(page, x, 0);
+		}
+	}
+}
+
+/* Строка мелким шрифтом: символ - 5 столбцов рисунка и столбец промежутка; символы вне шрифта выводятся пробелом */
+void oledText(uint8_t x, uint8_t page, const char *text)
+{
+	const uint8_t *glyph;
+	uint8_t column;
+
+	for(; *text; text++)
+	{
+		glyph = (*text >= OLED_FONT_FIRST && *text <= OLED_FONT_LAST) ? oledFontSmall[*text - OLED_FONT_FIRST] : oledFontSmall[0];
+		for(column = 0; column < OLED_FONT_WIDTH; column++)
+		{
+			oledPut(page, (uint8_t)(x + column), glyph[column]);
+		}
+		oledPut(page, (uint8_t)(x + OLED_FONT_WIDTH), 0);
+		x = (uint8_t)(x + OLED_FONT_WIDTH + 1);
+	}
+}
+
+/* Строка крупным шрифтом: клетка 16 столбцов на 3 страницы, рисунок копируется без сдвигов */
+void oledLargeText(uint8_t x, uint8_t page, const char *text)
+{
+	uint8_t index, row, column;
+
+	for(; *text; text++)
+	{
+		if(*text >= '0' && *text <= '9')
+		{
+			index = (uint8_t)(*text - '0');
+		}
+		else
+		{
+			index = *text == ':' ? OLED_LARGE_COLON : OLED_LARGE_BLANK;
+		}
+		for(row = 0; row < OLED_LARGE_PAGES; row++)
+		{
+			for(column = 0; column < OLED_LARGE_WIDTH; column++)
+			{
+				oledPut((uint8_t)(page + row), (uint8_t)(x + column), oledFontLarge[index][row][column]);
+			}
+		}
+		x = (uint8_t)(x + OLED_LARGE_WIDTH);
+	}
+}
+
+/* Отметка всего кадра для передачи (после инициализации контроллера его память не совпадает с кадром) */
+void oledInvalidate(void)
+{
+	uint8_t page;
+
+	for(page = 0; page < OLED_PAGES; page++)
+	{
+		dirtyFirst[page] = 0;
+		dirtyLast[page] = OLED_WIDTH - 1;
+	}
+}
+
+/*
+*	Следующий измененный диапазон для передачи; диапазон страницы сбрасывается до передачи,
+*	поэтому изменение кадра во время передачи снова отметит страницу и она будет передана еще раз
+*/
+uint8_t oledNextSegment(uint8_t *p_page, uint8_t *p_first, uint8_t *p_last)
+{
+	uint8_t page;
+
+	for(page = 0; page < OLED_PAGES; page++)
+	{
+		if(dirtyFirst[page] != OLED_CLEAN)
+		{
+			*p_page = page;
+			*p_first = dirtyFirst[page];
+			*p_last = dirtyLast[page];
+			dirtyFirst[page] = OLED_CLEAN;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Данные кадра начиная со столбца first страницы page */
+const uint8_t *oledSegmentData(uint8_t page, uint8_t first)
+{
+	return &frame[page][first];
+}
@@ -0,0 +1,48 @@
+#ifndef OLED_H
+#define OLED_H
+
+#include <stdint.h>
+
+/*
+*	Графический индикатор OLED 128x64 (контроллер SSD1306) на I2C1 (PB6 - SCL, PB7 - SDA)
+*	Изображение строится в кадре в ОЗУ (8 страниц по 128 столбцов, байт - 8 пикселей столбца).
+*	Запись в кадр отмечает только действительно изменившиеся байты: для каждой страницы хранится
+*	диапазон измененных столбцов, и передаются только эти диапазоны (смена секунды - несколько байт вместо 1 КБ).
+*	Передача идет в прерывании событий I2C1, по байту на TXE; смена команд на данные - повторный START
+*	(канал DMA1_Channel6 занят приемом консоли, который должен переживать остановку процессора при стирании flash).
+*	Отметки изменений используются только в основном цикле: oledFlush запускает передачу следующего диапазона,
+*	когда шина свободна, и прерывание читает его байты прямо из кадра. Построение кадра (oled.c) не зависит
+*	от аппаратуры и собирается также в модели на компьютере (tools/oled_sim.c), передача - oled_i2c.c
+*/
+
+#define OLED_WIDTH 		128		// Ширина (столбцы)
+#define OLED_PAGES 		8		// Высота (страницы по 8 пикселей)
+#define OLED_ADDRESS 	0x3C	// Адрес SSD1306 на шине I2C (7 бит)
+#define OLED_I2C_SPEED 	400000ul	// Частота шины I2C (Гц)
+
+#define OLED_CONTROL_COMMAND 	0x00	// Управляющий байт: далее команды
+#define OLED_CONTROL_DATA 		0x40	// Управляющий байт: далее данные кадра
+#define OLED_SEGMENT_COMMANDS 	6		// Команд перед диапазоном: столбцы (0x21, начало, конец), страницы (0x22, начало, конец)
+
+typedef struct oled_stats_tag{	// Статистика передачи
+	uint32_t bytes;				// Передано байт по I2C (адреса, управляющие байты, команды и данные)
+	uint16_t segments;			// Передано диапазонов кадра
+	uint16_t errors;			// Ошибки шины (нет подтверждения, потеря арбитража)
+} oled_stats;
+
+extern oled_stats oledStats;
+
+/* Построение кадра (oled.c) */
+void oledClear(void);															// Очистка кадра
+void oledText(uint8_t x, uint8_t page, const char *text);						// Строка мелким шрифтом 5x7 (символы ' '...'Z', шаг 6 столбцов)
+void oledLargeText(uint8_t x, uint8_t page, const char *text);					// Строка крупным шрифтом (цифры, ':' и пробел, 16x24)
+void oledInvalidate(void);														// Отметка всего кадра для передачи
+uint8_t oledNextSegment(uint8_t *p_page, uint8_t *p_first, uint8_t *p_last);	// Следующий измененный диапазон (0 - кадр передан)
+const uint8_t *oledSegmentData(uint8_t page, uint8_t first);					// Данные кадра начиная со столбца first страницы page
+
+/* Передача (oled_i2c.c) */
+void Oled_Init(void);						// Настройка I2C1 и инициализация SSD1306
+void oledFlush(void);						// Запуск передачи следующего измененного диапазона (вызывается из основного цикла)
+uint8_t oledIsBusy(void);					// 1 - идет передача
+
+#endif /* OLED_H */
@@ -0,0 +1,18 @@
+/* Файл сгенерирован tools/oled_font.py, не редактировать вручную */
+#ifndef OLED_FONT_H
+#define OLED_FONT_H
+
+#include <stdint.h>
+
+#define OLED_FONT_FIRST 		' '	// Первый символ мелкого шрифта
+#define OLED_FONT_LAST 		'Z'	// Последний символ мелкого шрифта
+#define OLED_FONT_WIDTH 		5		// Ширина символа мелкого шрифта (столбцы, без промежутка)
+#define OLED_LARGE_WIDTH 		16		// Ширина клетки крупного символа (столбцы)
+#define OLED_LARGE_PAGES 		3		// Высота клетки крупного символа (страницы)
+#define OLED_LARGE_COLON 		10		// Индекс двоеточия в крупном шрифте (0...9 - цифры)
+#define OLED_LARGE_BLANK 		11		// Индекс пустой клетки
+
+extern const uint8_t oledFontSmall[59][OLED_FONT_WIDTH];
+extern const uint8_t oledFontLarge[12][OLED_LARGE_PAGES][OLED_LARGE_WIDTH];
+
+#endif /* OLED_FONT_H */
@@ -0,0 +1,174 @@
+#include "stm32f10x.h"
+#include "oled.h"
+
+typedef enum oled_state_tag{	// Состояние передачи
+	OLED_IDLE,					// Шина свободна
+	OLED_COMMANDS,				// Передаются команды; далее данные диапазона
+	OLED_DATA,					// Передаются данные (или команды инициализации); далее STOP
+} oled_state;
+
+oled_stats oledStats;
+
+/* Команды инициализации SSD1306 128x64 (внутренний преобразователь напряжения, горизонтальная адресация) */
+static const uint8_t oledSetup[] = {
+	0xAE,				// Индикатор выключен
+	0xD5, 0x80,			// Частота генератора
+	0xA8, 0x3F,			// 64 строки
+	0xD3, 0x00,			// Без вертикального сдвига
+	0x40,				// Начальная строка 0
+	0x8D, 0x14,			// Включение преобразователя напряжения
+	0x20, 0x00,			// Горизонтальная адресация: после конца диапазона столбцов - следующая страница
+	0xA1,				// Столбец 127 - сегмент 0 (изображение не зеркально)
+	0xC8,				// Строки сверху вниз
+	0xDA, 0x12,			// Схема выводов строк
+	0x81, 0xCF,			// Контраст
+	0xD9, 0xF1,			// Предзаряд
+	0xDB, 0x40,			// Уровень VCOMH
+	0xA4,				// Изображение из памяти
+	0xA6,				// Без инверсии
+	0xAF				// Индикатор включен
+};
+
+static volatile uint8_t state;						// Состояние передачи (oled_state)
+static volatile uint8_t transferring;				// Адресная фаза пройдена, байты транзакции передаются по TXE
+static volatile uint8_t lost;						// Состояние контроллера неизвестно (запуск, ошибка шины): инициализация и весь кадр заново
+static uint8_t control;								// Управляющий байт текущей транзакции
+static const uint8_t *data;							// Данные текущей транзакции
+static uint8_t length;								// Длина данных текущей транзакции
+static uint8_t position;							// Передано байт данных текущей транзакции
+static uint8_t commands[OLED_SEGMENT_COMMANDS];		// Команды выбора диапазона
+static const uint8_t *segmentData;					// Данные диапазона (передаются после команд)
+static uint8_t segmentLength;
+
+/* Начало транзакции: START, далее адрес, управляющий байт и данные - в прерывании событий, по байту */
+static void oledTransfer(uint8_t controlByte, const uint8_t *p_data, uint8_t size)
+{
+	control = controlByte;
+	data = p_data;
+	length = size;
+	I2C1->CR1 |= I2C_CR1_START;						// В середине передачи - повторный START
+}
+
+/* Настройка I2C1 (400 кГц, прерывания событий и ошибок) и отправка команд инициализации */
+void Oled_Init(void)
+{
+	RCC->APB1ENR |= RCC_APB1ENR_I2C1EN;
+
+	I2C1->CR1 = I2C_CR1_SWRST;													// Сброс модуля (шина могла остаться занятой)
+	I2C1->CR1 = 0;
+	I2C1->CR2 = (uint16_t)(SystemCoreClock / 1000000ul) | I2C_CR2_ITEVTEN | I2C_CR2_ITERREN;	// APB1 = HCLK
+	I2C1->CCR = (uint16_t)(I2C_CCR_FS | ((SystemCoreClock + 3ul * OLED_I2C_SPEED - 1ul) / (3ul * OLED_I2C_SPEED)));	// Быстрый режим, Tlow/Thigh = 2
+	I2C1->TRISE = (uint16_t)(SystemCoreClock / 1000000ul * 300ul / 1000ul + 1ul);	// Фронт не более 300 нс
+	I2C1->CR1 = I2C_CR1_PE;
+
+	NVIC_EnableIRQ(I2C1_EV_IRQn);
+	NVIC_EnableIRQ(I2C1_ER_IRQn);
+
+	lost = 1;
+	oledFlush();
+}
+
+/* Запуск передачи следующего измененного диапазона: команды выбора столбцов и страницы, затем данные */
+void oledFlush(void)
+{
+	uint8_t page, first, last;
+
+	if(state != OLED_IDLE || (I2C1->CR1 & I2C_CR1_STOP))							// Новый START - только после завершения STOP
+	{
+		return;
+	}
+	if(lost)																	// Индикатор мог быть отключен - сначала команды инициализации
+	{
+		lost = 0;
+		oledInvalidate();
+		state = OLED_DATA;
+		oledTransfer(OLED_CONTROL_COMMAND, oledSetup, sizeof(oledSetup));
+		return;
+	}
+	if(!oledNextSegment(&page, &first, &last))
+	{
+		return;
+	}
+	commands[0] = 0x21;															// Диапазон столбцов
+	commands[1] = first;
+	commands[2] = last;
+	commands[3] = 0x22;															// Диапазон страниц
+	commands[4] = page;
+	commands[5] = page;
+	segmentData = oledSegmentData(page, first);
+	segmentLength = (uint8_t)(last - first + 1);
+	oledStats.segments++;
+	state = OLED_COMMANDS;
+	oledTransfer(OLED_CONTROL_COMMAND, commands, OLED_SEGMENT_COMMANDS);
+}
+
+/* 1 - идет передача */
+uint8_t oledIsBusy(void)
+{
+	return state != OLED_IDLE;
+}
+
+/*
+*	События I2C1: START передан - адрес; адрес подтвержден - управляющий байт и разрешение прерывания TXE;
+*	регистр данных свободен (TXE) - следующий байт; после последнего TXE запрещается до конца транзакции,
+*	последний байт передан (BTF) - данные диапазона или STOP. Изменение секунды (около 106 байт) - столько же прерываний
+*/
+void I2C1_EV_IRQHandler(void)
+{
+	uint16_t flags = I2C1->SR1;
+
+	if(flags & I2C_SR1_SB)
+	{
+		I2C1->DR = OLED_ADDRESS << 1;												// Чтение SR1 и запись DR снимают SB
+		return;
+	}
+	if(flags & I2C_SR1_ADDR)
+	{
+		(void)I2C1->SR2;															// Чтение SR1, затем SR2 снимает ADDR
+		I2C1->DR = control;
+		oledStats.bytes += 2ul + length;
+		position = 0;
+		transferring = 1;
+		I2C1->CR2 |= I2C_CR2_ITBUFEN;												// Прерывание по освобождению регистра данных
+		return;
+	}
+	if(!transferring)
+	{
+		return;
+	}
+	if(position < length)
+	{
+		if(flags & I2C_SR1_TXE)
+		{
+			I2C1->DR = data[position++];												// Запись DR снимает TXE (и BTF)
+		}
+		return;
+	}
+	I2C1->CR2 &= ~I2C_CR2_ITBUFEN;													// Все байты записаны - далее только BTF
+	if(flags & I2C_SR1_BTF)
+	{
+		transferring = 0;															// BTF снимается формированием START или STOP
+		if(state == OLED_COMMANDS)
+		{
+			state = OLED_DATA;
+			oledTransfer(OLED_CONTROL_DATA, segmentData, segmentLength);
+		}
+		else
+		{
+			I2C1->CR1 |= I2C_CR1_STOP;
+			state = OLED_IDLE;
+		}
+	}
+}
+
+/* Ошибки I2C1 (индикатор не ответил, ошибка шины): передача прекращается, индикатор будет инициализирован заново */
+void I2C1_ER_IRQHandler(void)
+{
+	I2C1->SR1 = (uint16_t)~(I2C_SR1_AF | I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_OVR);
+	I2C1->CR2 &= ~I2C_CR2_ITBUFEN;
+	I2C1->CR1 |= I2C_CR1_STOP;
+	oledStats.errors++;
+	transferring = 0;
+	lost = 1;
+	state = OLED_IDLE;
+}
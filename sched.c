@@ -0,0 +1,238 @@
+#include "stm32f10x.h"
+#include "RTE_Components.h"
+#include "sched.h"
+#include "bitband.h"
+#include "metrics.h"
+#ifdef RTE_CMSIS_RTOS2_RTX5
+#include "rtx_os.h"
+#endif
+
+sched_stats schedStats[SCHED_TASKS_MAX];
+
+static const sched_task *p_table;				// Таблица задач приложения
+static uint8_t tasks;							// Количество задач
+static uint16_t countdown[SCHED_TASKS_MAX];		// Тиков до выпуска периодической задачи (изменяется только в прерывании TIM3)
+static uint32_t released[SCHED_TASKS_MAX];		// Отсчет DWT выпуска (задержка до запуска)
+static volatile uint32_t ready;					// Биты готовых задач
+static volatile uint32_t woken;					// Выпуск после последней проверки перед сном
+static uint32_t idleMs;							// Миллисекунд сна в текущем окне (изменяется при запрещенных прерываниях)
+static uint8_t windowTicks;						// Тиков в текущем окне загрузки (окно - секунда)
+
+#ifdef RTE_CMSIS_RTOS2_RTX5
+static osRtxThread_t threadControl[SCHED_THREADS_MAX];							// Блоки управления потоков (без динамической памяти RTX)
+static uint64_t threadStack[SCHED_THREADS_MAX][SCHED_STACK_SIZE / 8];
+static osThreadId_t threadId[SCHED_THREADS_MAX];
+#endif
+
+/* Выполнение задачи с учетом задержки, времени выполнения и бюджета */
+static void schedExecute(uint8_t task)
+{
+	uint32_t start, cycles;
+
+	BITBAND_SRAM(&ready, task) = 0;
+	start = DWT->CYCCNT;
+	if(start - released[task] > schedStats[task].maxLatency)
+	{
+		schedStats[task].maxLatency = start - released[task];
+	}
+	p_table[task].p_function();
+	cycles = DWT->CYCCNT - start;
+
+	schedStats[task].runs++;
+	if(cycles > schedStats[task].maxCycles)
+	{
+		schedStats[task].maxCycles = cycles;
+	}
+	if(cycles / (SystemCoreClock / 1000000ul) > p_table[task].budget)
+	{
+		schedStats[task].overruns++;
+		schedOverrun(task, cycles);
+	}
+}
+
+/*
+*	Сон до прерывания (вызывается при запрещенных прерываниях): WFI при установленной PRIMASK пробуждается ожидающим
+*	прерыванием, которое обслуживается сразу после снятия маски, поэтому выпуск между проверкой и WFI не задерживает
+*	задачу до следующего прерывания. Время сна (мс, без обработчиков прерываний) - по счетчику TIM3: тактирование
+*	ядра во сне остановлено, и DWT->CYCCNT без отладчика (DBGMCU_CR.DBG_SLEEP) сна почти не видит.
+*	Сон не длиннее тика планировщика, поэтому счетчик TIM3 переходит через период не более одного раза
+*/
+static uint32_t schedSleep(void)
+{
+	uint16_t start = (uint16_t)TIM3->CNT;
+	uint16_t end;
+	uint32_t slept;
+
+	if(!woken)
+	{
+		__WFI();
+	}
+	woken = 0;
+	end = (uint16_t)TIM3->CNT;
+	slept = end >= start ? (uint32_t)(end - start) : (uint32_t)end + TIM3->ARR + 1u - start;
+	idleMs += slept;
+	return slept;
+}
+
+#ifdef RTE_CMSIS_RTOS2_RTX5
+/* Поток: готовые задачи своего номера потока по порядку таблицы, между выпусками - ожидание флагов */
+static __NO_RETURN void schedThread(void *argument)
+{
+	uint8_t thread = (uint8_t)(uint32_t)argument;
+	uint32_t mask = 0;
+	uint32_t pending;
+	uint8_t i;
+
+	for(i = 0; i < tasks; i++)
+	{
+		if(p_table[i].thread == thread)
+		{
+			mask |= 1ul << i;
+		}
+	}
+	while(1)
+	{
+		osThreadFlagsWait(mask, osFlagsWaitAny, osWaitForever);
+		while((pending = ready & mask) != 0)
+		{
+			schedExecute((uint8_t)__CLZ(__RBIT(pending)));
+		}
+	}
+}
+
+/*
+*	Поток простоя (заменяет слабую функцию RTX_Config.c): ядро приостанавливается вместе с SysTick, процессор спит
+*	до прерывания, после пробуждения ход ядра продолжается на проспанное число тиков (миллисекунды TIM3 в тиках ядра).
+*	Ближайшее пробуждение - тик планировщика TIM3, таймауты ядра (не короче тика) продлеваются не более чем на него
+*/
+__NO_RETURN void osRtxIdleThread(void *argument)
+{
+	uint32_t slept;
+
+	(void)argument;
+	while(1)
+	{
+		slept = 0;
+		if(osKernelSuspend())
+		{
+			__disable_irq();
+			slept = schedSleep();
+			__enable_irq();
+		}
+		osKernelResume(slept * osKernelGetTickFreq() / 1000u);
+	}
+}
+#endif
+
+/*
+*	Таблица задач; периодические задачи выпускаются через период после запуска
+*	В сборке RTX5 создаются потоки по номерам потоков таблицы (приоритет убывает с номером) и запускается ядро
+*/
+void Sched_Init(const sched_task *p_tasks, uint8_t count)
+{
+	uint8_t i;
+#ifdef RTE_CMSIS_RTOS2_RTX5
+	osThreadAttr_t attributes = {0};
+#endif
+
+	p_table = p_tasks;
+	tasks = count < SCHED_TASKS_MAX ? count : SCHED_TASKS_MAX;
+	for(i = 0; i < tasks; i++)
+	{
+		countdown[i] = p_table[i].period;
+	}
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;								// Счетчик тактов DWT
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+#ifdef RTE_CMSIS_RTOS2_RTX5
+	osKernelInitialize();
+	for(i = 0; i < tasks; i++)
+	{
+		if(p_table[i].thread >= SCHED_THREADS_MAX || threadId[p_table[i].thread])
+		{
+			continue;
+		}
+		attributes.cb_mem = &threadControl[p_table[i].thread];
+		attributes.cb_size = sizeof(threadControl[0]);
+		attributes.stack_mem = threadStack[p_table[i].thread];
+		attributes.stack_size = sizeof(threadStack[0]);
+		attributes.priority = (osPriority_t)(osPriorityHigh - p_table[i].thread);
+		threadId[p_table[i].thread] = osThreadNew(schedThread, (void *)(uint32_t)p_table[i].thread, &attributes);
+	}
+	osKernelStart();
+#endif
+}
+
+/*
+*	Выпуск задачи: бит готовности устанавливается одной записью в псевдоним bit-band (без чтения-изменения-записи,
+*	поэтому выпуски из прерываний разных уровней не теряются). Счетчик late - только статистика
+*	В сборке RTX5 поток задачи будится флагом (из прерывания или потока, но не внутри criticalEnter: вызов ядра - SVC)
+*/
+void schedTrigger(uint8_t task)
+{
+	if(task >= tasks)
+	{
+		return;
+	}
+	if(BITBAND_SRAM(&ready, task))
+	{
+		schedStats[task].late++;
+	}
+	else
+	{
+		released[task] = DWT->CYCCNT;
+	}
+	BITBAND_SRAM(&ready, task) = 1;
+	woken = 1;
+#ifdef RTE_CMSIS_RTOS2_RTX5
+	if(p_table[task].thread < SCHED_THREADS_MAX)
+	{
+		osThreadFlagsSet(threadId[p_table[task].thread], 1ul << task);
+	}
+#endif
+}
+
+/* Тик: отсчет периодов и доля бодрствования за последнюю секунду (реестр метрик) */
+void schedTick(void)
+{
+	uint8_t i;
+
+	METRIC_COUNT(ticks);
+	for(i = 0; i < tasks; i++)
+	{
+		if(p_table[i].period && --countdown[i] == 0)
+		{
+			countdown[i] = p_table[i].period;
+			schedTrigger(i);
+		}
+	}
+
+	if(++windowTicks >= 1000u / SCHED_TICK_MS)									// Окно - секунда тиков (1000 мс)
+	{
+		METRIC_SET(awake, idleMs < 1000u ? 1000u - idleMs : 0u);
+		idleMs = 0;
+		windowTicks = 0;
+	}
+}
+
+/*
+*	Выполнение готовой задачи с наименьшим номером (наибольшим приоритетом)
+*	Бит готовности снимается до запуска: выпуск во время выполнения запустит задачу еще раз. Без готовых задач - сон
+*	В сборке RTX5 не вызывается (Sched_Init не возвращается)
+*/
+void schedRun(void)
+{
+	uint32_t pending = ready;
+
+	if(!pending)
+	{
+		__disable_irq();
+		if(!ready)
+		{
+			schedSleep();
+		}
+		__enable_irq();
+		return;
+	}
+	schedExecute((uint8_t)__CLZ(__RBIT(pending)));								// Младший установленный бит
+}
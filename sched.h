@@ -0,0 +1,49 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdint.h>
+
+/*
+*	Кооперативный планировщик с выпуском задач по времени и по событиям
+*	Таблица задач - константа приложения (без кучи, память фиксирована: SCHED_TASKS_MAX записей статистики).
+*	Периодические задачи выпускает schedTick (тик SCHED_TICK_MS из прерывания TIM3), событийные - schedTrigger
+*	из любого прерывания или задачи. Готовность - бит слова, устанавливаемый через bit-band одной записью.
+*	schedRun выполняет готовую задачу с наименьшим номером до завершения (задачи друг друга не вытесняют),
+*	время выполнения измеряется счетчиком DWT и сравнивается с бюджетом задачи; без готовых задач процессор
+*	спит до прерывания (WFI)
+*	В сборке RTX5 (цель RTX5, RTE_CMSIS_RTOS2_RTX5) задачи выполняются потоками: задачи с одинаковым номером потока
+*	выполняются одним потоком по очереди и друг друга не вытесняют, поток с меньшим номером вытесняет остальные.
+*	Выпуск - флаг потока; поток простоя останавливает тик ядра и спит до прерывания (tickless idle)
+*/
+
+#define SCHED_TICK_MS 		10		// Период тика (мс, канал сравнения 2 TIM3)
+#define SCHED_TASKS_MAX 	8		// Наибольшее количество задач
+#define SCHED_THREADS_MAX 	4		// Наибольшее количество потоков (сборка RTX5)
+#define SCHED_STACK_SIZE 	1024	// Стек потока (байт, сборка RTX5)
+
+typedef struct sched_task_tag{	// Описание задачи
+	void (*p_function)(void);	// Функция задачи (выполняется до завершения, не ждет в цикле)
+	uint16_t period;			// Период выпуска (тиков SCHED_TICK_MS), 0 - только по событию
+	uint16_t budget;			// Допустимое время выполнения (мкс, включая вытеснившие задачу прерывания и потоки)
+	uint8_t thread;				// Поток RTX5 (0 - наивысший приоритет); в основной сборке не используется
+} sched_task;
+
+typedef struct sched_stats_tag{	// Статистика задачи
+	uint32_t runs;				// Запусков
+	uint32_t maxCycles;			// Наибольшее время выполнения (тактов)
+	uint32_t maxLatency;		// Наибольшая задержка от выпуска до запуска (тактов, в сборке RTX5 - с переключением потока)
+	uint16_t overruns;			// Превышений бюджета
+	uint16_t late;				// Выпусков, пришедших до запуска по предыдущему (объединены с ним)
+} sched_stats;
+
+extern sched_stats schedStats[SCHED_TASKS_MAX];
+
+void Sched_Init(const sched_task *p_tasks, uint8_t count);	// Таблица задач (count не более SCHED_TASKS_MAX), запуск счетчика тактов DWT; в сборке RTX5 - запуск ядра без возврата
+void schedTick(void);										// Тик: выпуск периодических задач, метрики ticks и awake (вызывается из прерывания TIM3)
+void schedTrigger(uint8_t task);							// Выпуск задачи по событию (из прерывания или задачи)
+void schedRun(void);										// Выполнение одной готовой задачи или сон до прерывания (основной цикл)
+
+/* Реализуется приложением */
+void schedOverrun(uint8_t task, uint32_t cycles);			// Превышение бюджета (вызывается после завершения задачи)
+
+#endif /* SCHED_H */
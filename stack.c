@@ -0,0 +1,30 @@
+#include "stm32f10x.h"
+#include "stack.h"
+
+extern uint32_t Stack_Mem[];					// Границы стека (startup_stm32f10x_md.s)
+extern uint32_t __initial_sp[];
+extern uint8_t Image$$RW_IRAM1$$ZI$$Limit[];	// Конец распределенного ОЗУ (область по умолчанию µVision)
+
+/* Размер стека */
+uint32_t stackSize(void)
+{
+	return (uint32_t)__initial_sp - (uint32_t)Stack_Mem;
+}
+
+/* Наибольшая глубина: поиск первого слова снизу, отличного от заполнения (стек растет вниз) */
+uint32_t stackUsed(void)
+{
+	const uint32_t *p_word = Stack_Mem;
+
+	while(p_word < __initial_sp && *p_word == STACK_PAINT)
+	{
+		p_word++;
+	}
+	return (uint32_t)__initial_sp - (uint32_t)p_word;
+}
+
+/* Распределенное ОЗУ от начала SRAM до конца области RW_IRAM1 */
+uint32_t stackRamUsed(void)
+{
+	return (uint32_t)Image$$RW_IRAM1$$ZI$$Limit - SRAM_BASE;
+}
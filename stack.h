@@ -0,0 +1,20 @@
+#ifndef STACK_H
+#define STACK_H
+
+#include <stdint.h>
+
+/*
+*	Измерение глубины стека: при сбросе Reset_Handler (startup_stm32f10x_md.s) заполняет весь стек словом STACK_PAINT,
+*	наибольшая глубина - расстояние от вершины до нижнего измененного слова. Используемое ОЗУ (RW и ZI, включая стек)
+*	определяется по символу компоновщика конца области RW_IRAM1. Статическая оценка по графу вызовов
+*	и отчет о размерах секций после сборки - tools/mem_report.py
+*/
+
+#define STACK_PAINT 	0xDEADBEEFul	// Слово заполнения стека (совпадает с Reset_Handler)
+#define STACK_RAM_SIZE 	20480ul			// ОЗУ STM32F103RB
+
+uint32_t stackSize(void);			// Размер стека (байт)
+uint32_t stackUsed(void);			// Наибольшая глубина стека с момента сброса (байт)
+uint32_t stackRamUsed(void);		// Статически распределенное ОЗУ (байт)
+
+#endif /* STACK_H */
@@ -0,0 +1,477 @@
+#include "stm32f10x.h"
+#include "store.h"
+#include "critical.h"
+#include "metrics.h"
+
+#define STORE_HEADER 		4u			// Заголовок страницы: признак и номер страницы в журнале
+#define STORE_MAGIC 		0x5354u		// Признак страницы хранилища
+#define STORE_ERASED 		0xFFFFu		// Стертое полуслово
+#define STORE_EVENT_KEY 	0x0100u		// Ключ записи события (младший байт - код события)
+#define STORE_EVENT_SIZE 	6u			// Данные события: время (4 байта) и параметр (2 байта)
+
+typedef void (*store_visitor)(uint16_t offset, uint8_t valid);	// Обработка записи при просмотре страницы
+
+store_stats storeStats;
+
+static uint16_t keyOffset[STORE_KEYS];		// Индекс: смещение последней записи ключа от STORE_BASE, 0 - значения нет
+static uint8_t head;						// Текущая страница
+static uint16_t sequence;					// Номер текущей страницы в журнале
+static uint16_t writeOffset;				// Свободное место в текущей странице (смещение от начала страницы)
+
+static store_event queue[STORE_QUEUE];		// Очередь событий (заполняется также в прерываниях)
+static volatile uint8_t queueHead;
+static volatile uint8_t queueTail;
+
+static store_event *eventsOut;				// Чтение событий: приемник, пропуск более старых, заполнение
+static uint16_t eventsSkip;
+static uint16_t eventsCount;
+
+/* Полуслово хранилища по смещению от STORE_BASE */
+static uint16_t storeHalf(uint32_t offset)
+{
+	return *(const volatile uint16_t *)(STORE_BASE + offset);
+}
+
+/* Размер записи: заголовок, данные с выравниванием до слова, CRC */
+static uint16_t storeRecordSize(uint16_t length)
+{
+	return (uint16_t)(8u + ((length + 3u) & ~3u));
+}
+
+/* CRC-32 записи (аппаратный блок CRC считает словами): заголовок и данные, дополненные нулями до слова */
+static uint32_t storeCrc(uint32_t header, const uint8_t *p_data, uint16_t length)
+{
+	uint32_t word;
+	uint16_t i, j;
+
+	CRC->CR = CRC_CR_RESET;
+	CRC->DR = header;
+	for(i = 0; i < length; i += 4)
+	{
+		word = 0;
+		for(j = 0; j < 4 && i + j < length; j++)
+		{
+			word |= (uint32_t)p_data[i + j] << (8 * j);
+		}
+		CRC->DR = word;
+	}
+	return CRC->DR;
+}
+
+/* Проверка записи по смещению от STORE_BASE */
+static uint8_t storeRecordValid(uint32_t offset)
+{
+	uint16_t length = storeHalf(offset + 2);
+	uint32_t crcOffset = offset + storeRecordSize(length) - 4;
+	uint32_t crc = storeHalf(crcOffset) | ((uint32_t)storeHalf(crcOffset + 2) << 16);
+
+	return storeCrc(storeHalf(offset) | ((uint32_t)length << 16), (const uint8_t *)(STORE_BASE + offset + 4), length) == crc;
+}
+
+/* Снятие защиты от записи flash */
+static void storeUnlock(void)
+{
+	if(FLASH->CR & FLASH_CR_LOCK)
+	{
+		FLASH->KEYR = 0x45670123ul;
+		FLASH->KEYR = 0xCDEF89ABul;
+	}
+}
+
+/* Программирование полуслова (1 - успешно); процессор ожидает окончания записи (около 50 мкс) */
+static uint8_t storeProgram(uint32_t offset, uint16_t value)
+{
+	volatile uint16_t *p_half = (volatile uint16_t *)(STORE_BASE + offset);
+
+	FLASH->CR |= FLASH_CR_PG;
+	*p_half = value;
+	while(FLASH->SR & FLASH_SR_BSY);
+	FLASH->CR &= ~FLASH_CR_PG;
+	storeStats.programBytes += 2;
+	if(FLASH->SR & (FLASH_SR_PGERR | FLASH_SR_WRPRTERR))					// Полуслово не было стерто
+	{
+		FLASH->SR = FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+		storeStats.errors++;
+		return 0;
+	}
+	return *p_half == value;
+}
+
+/* 1 - страница полностью стерта */
+static uint8_t storeBlank(uint8_t page)
+{
+	const uint32_t *p_word = (const uint32_t *)(STORE_BASE + (uint32_t)page * STORE_PAGE_SIZE);
+	uint16_t i;
+
+	for(i = 0; i < STORE_PAGE_SIZE / 4; i++)
+	{
+		if(p_word[i] != 0xFFFFFFFFul)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* Стирание страницы (20...40 мс, выполнение программы из flash на это время останавливается) */
+static void storeErase(uint8_t page)
+{
+	FLASH->CR |= FLASH_CR_PER;
+	FLASH->AR = STORE_BASE + (uint32_t)page * STORE_PAGE_SIZE;
+	FLASH->CR |= FLASH_CR_STRT;
+	while(FLASH->SR & FLASH_SR_BSY);
+	FLASH->CR &= ~FLASH_CR_PER;
+	FLASH->SR = FLASH_SR_EOP;
+	storeStats.erases++;
+}
+
+/*
+*	Добавление записи в текущую страницу (0 - нет места или ошибка программирования)
+*	Заголовок программируется первым: прерванная запись имеет известную длину и пропускается по неверной CRC
+*/
+static uint8_t storeAppend(uint16_t key, const uint8_t *p_data, uint16_t length)
+{
+	uint32_t offset = (uint32_t)head * STORE_PAGE_SIZE + writeOffset;
+	uint16_t size = storeRecordSize(length);
+	uint32_t crc = storeCrc(key | ((uint32_t)length << 16), p_data, length);
+	uint16_t i, half;
+	uint8_t ok;
+
+	if(writeOffset + size > STORE_PAGE_SIZE)
+	{
+		return 0;
+	}
+	writeOffset = (uint16_t)(writeOffset + size);								// При ошибке место не используется повторно
+	ok = storeProgram(offset, key) && storeProgram(offset + 2, length);
+	for(i = 0; ok && i < size - 8; i += 2)
+	{
+		half = (uint16_t)((i < length ? p_data[i] : 0) | ((i + 1 < length ? p_data[i + 1] : 0) << 8));
+		ok = storeProgram(offset + 4 + i, half);
+	}
+	ok = ok && storeProgram(offset + size - 4, (uint16_t)crc) && storeProgram(offset + size - 2, (uint16_t)(crc >> 16));
+	if(ok && key < STORE_KEYS)
+	{
+		keyOffset[key] = (uint16_t)offset;
+	}
+	storeStats.free = (uint16_t)(STORE_PAGE_SIZE - writeOffset);
+	return ok;
+}
+
+/* Освобождение страницы: действующие значения переносятся в текущую страницу, страница стирается */
+static void storeReclaim(uint8_t page)
+{
+	const uint8_t *p_record;
+	uint8_t key;
+
+	for(key = 0; key < STORE_KEYS; key++)
+	{
+		if(keyOffset[key] && keyOffset[key] / STORE_PAGE_SIZE == page)
+		{
+			p_record = (const uint8_t *)(STORE_BASE + keyOffset[key]);
+			if(storeAppend(key, p_record + 4, storeHalf(keyOffset[key] + 2u)))
+			{
+				storeStats.copies++;
+			}
+			else
+			{
+				keyOffset[key] = 0;												// Значение теряется вместе со страницей
+			}
+		}
+	}
+	if(!storeBlank(page))
+	{
+		storeErase(page);
+	}
+}
+
+/* Смена страницы: следующая (стертая) страница становится текущей, за ней освобождается самая старая */
+static void storeRotate(void)
+{
+	uint32_t offset;
+
+	head = (uint8_t)((head + 1) % STORE_PAGES);
+	sequence++;
+	offset = (uint32_t)head * STORE_PAGE_SIZE;
+	writeOffset = STORE_PAGE_SIZE;												// Без заголовка страница не используется
+	if(storeProgram(offset, STORE_MAGIC) && storeProgram(offset + 2, sequence))
+	{
+		writeOffset = STORE_HEADER;
+	}
+	storeReclaim((uint8_t)((head + 1) % STORE_PAGES));
+}
+
+/* Запись с переходом на следующую страницу при нехватке места */
+static uint8_t storeRecord(uint16_t key, const uint8_t *p_data, uint16_t length)
+{
+	if(storeAppend(key, p_data, length))
+	{
+		return 1;
+	}
+	storeRotate();
+	return storeAppend(key, p_data, length);
+}
+
+/*
+*	Просмотр записей страницы до конца журнала; возвращает смещение свободного места в странице
+*	Заголовок записи с недопустимой длиной или ключом (прерванная запись заголовка) закрывает страницу
+*/
+static uint16_t storeScan(uint8_t page, store_visitor visit)
+{
+	uint32_t base = (uint32_t)page * STORE_PAGE_SIZE;
+	uint16_t offset = STORE_HEADER;
+	uint16_t key, length;
+
+	while(offset + 8u <= STORE_PAGE_SIZE)
+	{
+		key = storeHalf(base + offset);
+		length = storeHalf(base + offset + 2);
+		if(key == STORE_ERASED)
+		{
+			break;
+		}
+		if(length == STORE_ERASED)												// Сброс между ключом и длиной: данные не программировались
+		{
+			visit((uint16_t)(base + offset), 0);
+			offset += 4;
+			continue;
+		}
+		if((key < STORE_KEYS ? length > STORE_VALUE_MAX : ((key & 0xFF00u) != STORE_EVENT_KEY || length != STORE_EVENT_SIZE)) ||
+		   offset + storeRecordSize(length) > STORE_PAGE_SIZE)
+		{
+			return STORE_PAGE_SIZE;
+		}
+		visit((uint16_t)(base + offset), storeRecordValid(base + offset));
+		offset = (uint16_t)(offset + storeRecordSize(length));
+	}
+	return offset;
+}
+
+/* Построение индекса: записи просматриваются от старых к новым, поэтому в индексе остается последняя */
+static void storeIndex(uint16_t offset, uint8_t valid)
+{
+	uint16_t key = storeHalf(offset);
+
+	storeStats.bootRecords++;
+	if(!valid)
+	{
+		storeStats.crcErrors++;
+		return;
+	}
+	if(key < STORE_KEYS)
+	{
+		keyOffset[key] = offset;
+	}
+}
+
+/* 1 - страница содержит журнал */
+static uint8_t storeUsed(uint8_t page)
+{
+	return storeHalf((uint32_t)page * STORE_PAGE_SIZE) == STORE_MAGIC;
+}
+
+/*
+*	Запуск хранилища: поиск текущей страницы (наибольший номер), построение индекса от старых страниц к новым,
+*	восстановление резервной страницы, если смена страницы была прервана сбросом. Время построения индекса
+*	измеряется счетчиком тактов DWT
+*/
+void Store_Init(void)
+{
+	uint8_t page, found = 0, i;
+	uint32_t start;
+
+	RCC->AHBENR |= RCC_AHBENR_CRCEN;											// Включение тактирования блока CRC
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;								// Счетчик тактов DWT
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	start = DWT->CYCCNT;
+
+	for(page = 0; page < STORE_PAGES; page++)
+	{
+		if(storeUsed(page) && (!found || (int16_t)(storeHalf((uint32_t)page * STORE_PAGE_SIZE + 2) - sequence) > 0))
+		{
+			head = page;
+			sequence = storeHalf((uint32_t)page * STORE_PAGE_SIZE + 2);
+			found = 1;
+		}
+	}
+
+	storeUnlock();
+	if(found)
+	{
+		for(i = 1; i <= STORE_PAGES; i++)
+		{
+			page = (uint8_t)((head + i) % STORE_PAGES);
+			if(storeUsed(page))
+			{
+				writeOffset = storeScan(page, storeIndex);						// Текущая страница просматривается последней
+			}
+		}
+		storeStats.free = (uint16_t)(STORE_PAGE_SIZE - writeOffset);
+		storeStats.bootCycles = DWT->CYCCNT - start;
+		if(!storeBlank((uint8_t)((head + 1) % STORE_PAGES)))
+		{
+			storeReclaim((uint8_t)((head + 1) % STORE_PAGES));
+		}
+	}
+	else																		// Первый запуск: разметка хранилища
+	{
+		for(page = 0; page < STORE_PAGES; page++)
+		{
+			if(!storeBlank(page))
+			{
+				storeErase(page);
+			}
+		}
+		head = STORE_PAGES - 1;
+		sequence = 0;
+		storeRotate();
+		storeStats.bootCycles = DWT->CYCCNT - start;
+	}
+	storeStats.page = head;
+	FLASH->CR |= FLASH_CR_LOCK;
+}
+
+/* Чтение значения (возвращает длину значения, 0 - значения нет; копируется не более size байт) */
+uint8_t storeRead(uint8_t key, void *p_value, uint8_t size)
+{
+	const uint8_t *p_data;
+	uint16_t length, i;
+
+	if(key >= STORE_KEYS || !keyOffset[key])
+	{
+		return 0;
+	}
+	length = storeHalf(keyOffset[key] + 2u);
+	p_data = (const uint8_t *)(STORE_BASE + keyOffset[key] + 4u);
+	for(i = 0; i < length && i < size; i++)
+	{
+		((uint8_t *)p_value)[i] = p_data[i];
+	}
+	return (uint8_t)length;
+}
+
+/* Запись значения (вызывается из основного цикла); совпадающее с сохраненным значение не программируется */
+uint8_t storeWrite(uint8_t key, const void *p_value, uint8_t size)
+{
+	const uint8_t *p_data = (const uint8_t *)p_value;
+	uint8_t i, ok;
+
+	if(key >= STORE_KEYS || size > STORE_VALUE_MAX)
+	{
+		return 0;
+	}
+	if(keyOffset[key] && storeHalf(keyOffset[key] + 2u) == size)
+	{
+		for(i = 0; i < size && p_data[i] == *(const uint8_t *)(STORE_BASE + keyOffset[key] + 4u + i); i++);
+		if(i == size)
+		{
+			return 1;
+		}
+	}
+	storeStats.payloadBytes += size;
+	storeUnlock();
+	ok = storeRecord(key, p_data, size);
+	FLASH->CR |= FLASH_CR_LOCK;
+	storeStats.page = head;
+	return ok;
+}
+
+/* Постановка события в очередь (состояние маски прерываний сохраняется - можно вызывать в критической секции) */
+void storeEvent(uint8_t id, uint32_t seconds, uint16_t arg)
+{
+	uint32_t basepri;
+	uint8_t next;
+
+	basepri = criticalEnter(BOARD_LEVEL_TIME);
+	next = (uint8_t)((queueHead + 1) % STORE_QUEUE);
+	if(next == queueTail)
+	{
+		storeStats.eventsLost++;
+		METRIC_ADD(queueOverflows, 1);
+	}
+	else
+	{
+		queue[queueHead].seconds = seconds;
+		queue[queueHead].arg = arg;
+		queue[queueHead].id = id;
+		queueHead = next;
+	}
+	criticalExit(basepri);
+}
+
+/* Запись событий из очереди */
+void storePoll(void)
+{
+	uint8_t data[STORE_EVENT_SIZE];
+	store_event *p_event;
+
+	if(queueTail == queueHead)
+	{
+		return;
+	}
+	storeUnlock();
+	while(queueTail != queueHead)
+	{
+		p_event = &queue[queueTail];
+		data[0] = (uint8_t)p_event->seconds;
+		data[1] = (uint8_t)(p_event->seconds >> 8);
+		data[2] = (uint8_t)(p_event->seconds >> 16);
+		data[3] = (uint8_t)(p_event->seconds >> 24);
+		data[4] = (uint8_t)p_event->arg;
+		data[5] = (uint8_t)(p_event->arg >> 8);
+		storeStats.payloadBytes += STORE_EVENT_SIZE;
+		if(storeRecord((uint16_t)(STORE_EVENT_KEY | p_event->id), data, STORE_EVENT_SIZE))
+		{
+			storeStats.events++;
+		}
+		queueTail = (uint8_t)((queueTail + 1) % STORE_QUEUE);
+	}
+	FLASH->CR |= FLASH_CR_LOCK;
+	storeStats.page = head;
+}
+
+/* Чтение событий: первые eventsSkip событий пропускаются, остальные копируются */
+static void storeCollect(uint16_t offset, uint8_t valid)
+{
+	const uint8_t *p_data = (const uint8_t *)(STORE_BASE + offset + 4u);
+
+	if(!valid || storeHalf(offset) < STORE_EVENT_KEY)
+	{
+		return;
+	}
+	if(eventsSkip)
+	{
+		eventsSkip--;
+		return;
+	}
+	if(eventsOut)
+	{
+		eventsOut[eventsCount].seconds = p_data[0] | ((uint32_t)p_data[1] << 8) | ((uint32_t)p_data[2] << 16) | ((uint32_t)p_data[3] << 24);
+		eventsOut[eventsCount].arg = (uint16_t)(p_data[4] | (p_data[5] << 8));
+		eventsOut[eventsCount].id = (uint8_t)storeHalf(offset);
+	}
+	eventsCount++;
+}
+
+/* Последние count событий от старых к новым: первый проход считает события, второй копирует последние */
+uint8_t storeReadEvents(store_event *p_events, uint8_t count)
+{
+	uint8_t pass, i, page;
+	uint16_t total = 0;
+
+	for(pass = 0; pass < 2; pass++)
+	{
+		eventsOut = pass ? p_events : 0;
+		eventsSkip = pass && total > count ? (uint16_t)(total - count) : 0;
+		eventsCount = 0;
+		for(i = 1; i <= STORE_PAGES; i++)
+		{
+			page = (uint8_t)((head + i) % STORE_PAGES);
+			if(storeUsed(page))
+			{
+				storeScan(page, storeCollect);
+			}
+		}
+		total = eventsCount;
+	}
+	return (uint8_t)total;
+}
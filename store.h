@@ -0,0 +1,57 @@
+#ifndef STORE_H
+#define STORE_H
+
+#include <stdint.h>
+
+/*
+*	Журнальное хранилище настроек и событий в последних страницах flash (STM32F103RB: 128 страниц по 1 КБ)
+*	Записи только добавляются в текущую страницу программированием полуслов: [ключ | длина][данные][CRC-32].
+*	Новое значение ключа не стирает старое - действует последняя запись. Заполненная страница сменяется
+*	следующей по кругу (равномерный износ); самая старая страница перед стиранием переносит в текущую
+*	еще действующие значения, а события в ней теряются (история ограничена объемом хранилища).
+*	Целостность записей проверяется аппаратным блоком CRC; при старте страницы просматриваются один раз
+*	и строится индекс в ОЗУ (смещение последней записи каждого ключа), дальше чтение идет по индексу
+*/
+
+#define STORE_BASE 			0x0801F000ul	// Начало хранилища (последние STORE_PAGES страниц, в проекте область исключена из ROM)
+#define STORE_PAGES 		4				// Страниц хранилища (одна всегда стерта - резерв для смены)
+#define STORE_PAGE_SIZE 	1024u			// Размер страницы flash
+#define STORE_KEYS 			16				// Количество ключей настроек (0...STORE_KEYS - 1)
+#define STORE_VALUE_MAX 	16				// Максимальная длина значения (байт)
+#define STORE_QUEUE 		8				// Очередь событий, записываемых из основного цикла
+
+#if STORE_KEYS * (STORE_VALUE_MAX + 8) > STORE_PAGE_SIZE / 2
+#error "All live values must fit into half of a store page"
+#endif
+
+typedef struct store_event_tag{	// Событие журнала
+	uint32_t seconds;			// Время (UTC)
+	uint16_t arg;				// Параметр события
+	uint8_t id;					// Код события (задается приложением)
+} store_event;
+
+typedef struct store_stats_tag{	// Статистика хранилища
+	uint32_t payloadBytes;		// Байт новых значений и событий, переданных на запись
+	uint32_t programBytes;		// Байт запрограммировано (заголовки, выравнивание, CRC, перенос при смене страницы)
+	uint32_t bootCycles;		// Построение индекса при старте (такты процессора)
+	uint16_t bootRecords;		// Записей просмотрено при старте
+	uint16_t crcErrors;			// Испорченных записей (прерванная запись)
+	uint16_t erases;			// Стираний страниц
+	uint16_t copies;			// Значений перенесено при смене страницы
+	uint16_t events;			// Событий записано
+	uint16_t eventsLost;		// Событий потеряно при переполнении очереди
+	uint16_t errors;			// Ошибок программирования
+	uint16_t free;				// Свободно в текущей странице (байт)
+	uint8_t page;				// Текущая страница
+} store_stats;
+
+extern store_stats storeStats;
+
+void Store_Init(void);													// Просмотр страниц, построение индекса, восстановление после сбоя
+uint8_t storeRead(uint8_t key, void *p_value, uint8_t size);			// Чтение значения (возвращает длину, 0 - значения нет)
+uint8_t storeWrite(uint8_t key, const void *p_value, uint8_t size);		// Запись значения (без изменений - не программируется)
+void storeEvent(uint8_t id, uint32_t seconds, uint16_t arg);			// Постановка события в очередь (можно вызывать из прерываний)
+void storePoll(void);													// Запись событий из очереди (вызывается из основного цикла)
+uint8_t storeReadEvents(store_event *p_events, uint8_t count);			// Последние count событий по порядку (возвращает количество)
+
+#endif /* STORE_H */
@@ -0,0 +1,106 @@
+#include "stm32f10x.h"
+#include "sunrise.h"
+
+#define SUNRISE_STEP_MS 	250		// Шаг таблицы на минуту длительности рассвета (60000 мс / SUNRISE_STEPS)
+
+/* Яркость светодиода с гамма-коррекцией: 65535 * ((i + 1) / 240) ^ 2.2 */
+static const uint16_t sunriseGamma[SUNRISE_STEPS] = {
+	    0,     2,     4,     8,    13,    20,    27,    37,    48,    60,    74,    90,
+	  107,   126,   147,   169,   194,   220,   247,   277,   308,   341,   377,   413,
+	  452,   493,   536,   580,   627,   676,   726,   779,   833,   890,   948,  1009,
+	 1072,  1136,  1203,  1272,  1343,  1416,  1492,  1569,  1648,  1730,  1814,  1900,
+	 1988,  2078,  2171,  2266,  2363,  2462,  2563,  2667,  2773,  2881,  2991,  3104,
+	 3219,  3336,  3456,  3578,  3702,  3828,  3957,  4088,  4222,  4357,  4495,  4636,
+	 4779,  4924,  5072,  5222,  5374,  5529,  5686,  5845,  6007,  6172,  6338,  6508,
+	 6679,  6853,  7030,  7209,  7390,  7574,  7761,  7950,  8141,  8335,  8531,  8730,
+	 8931,  9135,  9341,  9550,  9761,  9975, 10192, 10411, 10632, 10856, 11083, 11312,
+	11544, 11778, 12015, 12254, 12496, 12741, 12988, 13238, 13490, 13745, 14003, 14263,
+	14526, 14791, 15059, 15330, 15603, 15879, 16158, 16439, 16723, 17009, 17298, 17590,
+	17885, 18182, 18482, 18784, 19089, 19397, 19708, 20021, 20337, 20656, 20977, 21301,
+	21628, 21958, 22290, 22625, 22962, 23303, 23646, 23992, 24341, 24692, 25046, 25403,
+	25762, 26125, 26490, 26858, 27229, 27602, 27978, 28357, 28739, 29124, 29511, 29901,
+	30294, 30690, 31089, 31490, 31894, 32301, 32711, 33124, 33539, 33957, 34378, 34802,
+	35229, 35659, 36091, 36526, 36965, 37406, 37849, 38296, 38746, 39198, 39654, 40112,
+	40573, 41037, 41503, 41973, 42446, 42921, 43400, 43881, 44365, 44852, 45342, 45835,
+	46331, 46829, 47331, 47835, 48343, 48853, 49366, 49882, 50402, 50924, 51449, 51976,
+	52507, 53041, 53578, 54118, 54660, 55206, 55754, 56306, 56860, 57418, 57978, 58542,
+	59108, 59677, 60250, 60825, 61403, 61985, 62569, 63156, 63746, 64340, 64936, 65535,
+};
+
+static volatile uint8_t active;		// Флаг работы рассвета
+
+/* Настройка TIM2 (ШИМ светодиода), TIM4 (отсчет шагов яркости) и DMA1_Channel4 (запрос TIM4_CH2) */
+void Sunrise_Init(void)
+{
+	RCC->APB1ENR |= RCC_APB1ENR_TIM2EN | RCC_APB1ENR_TIM4EN;					// Включение тактирования таймеров
+	RCC->AHBENR |= RCC_AHBENR_DMA1EN;											// Включение тактирования DMA
+
+	TIM2->PSC = 0;																// ШИМ 16 бит на частоте HCLK (около 490 Гц)
+	TIM2->ARR = 0xFFFF;
+	TIM2->CCMR1 = TIM_CCMR1_OC2M_2 | TIM_CCMR1_OC2M_1 | TIM_CCMR1_OC2PE;		// Режим ШИМ 1 с предзагрузкой CCR2
+	TIM2->CCER = TIM_CCER_CC2E;
+	TIM2->CCR2 = 0;
+	TIM2->CR1 = TIM_CR1_CEN;													// TIM2 считает непрерывно: счетчик используется также как шкала времени Modbus
+
+	TIM4->PSC = (uint16_t)(SystemCoreClock / 1000 - 1);							// Счет в миллисекундах
+	TIM4->DIER = TIM_DIER_CC2DE;												// Запрос DMA по событию сравнения канала 2
+
+	DMA1_Channel4->CPAR = (uint32_t)&TIM2->CCR2;								// Приемник - регистр сравнения ШИМ
+	NVIC_EnableIRQ(DMA1_Channel4_IRQn);
+}
+
+/*
+*	Запуск нарастания яркости длительностью minutes минут
+*	Событие сравнения наступает в конце каждого периода TIM4, поэтому последняя ступень (полная яркость)
+*	загружается через minutes минут после запуска (с точностью до 1 мс)
+*/
+void sunriseStart(uint8_t minutes)
+{
+	if(minutes < SUNRISE_MIN_MINUTES)
+	{
+		minutes = SUNRISE_MIN_MINUTES;
+	}
+	if(minutes > SUNRISE_MAX_MINUTES)
+	{
+		minutes = SUNRISE_MAX_MINUTES;
+	}
+
+	sunriseStop();
+
+	DMA1_Channel4->CMAR = (uint32_t)sunriseGamma;
+	DMA1_Channel4->CNDTR = SUNRISE_STEPS;
+	DMA1_Channel4->CCR = DMA_CCR1_DIR | DMA_CCR1_MINC | DMA_CCR1_PSIZE_0 | DMA_CCR1_MSIZE_0 | DMA_CCR1_TCIE | DMA_CCR1_EN;	// Flash -> таймер, 16 бит
+
+	TIM4->ARR = (uint16_t)(minutes * SUNRISE_STEP_MS - 1);
+	TIM4->CCR2 = TIM4->ARR;
+	TIM4->CNT = 0;
+	TIM4->EGR = TIM_EGR_UG;
+	TIM4->SR = 0;
+
+	active = 1;
+	TIM4->CR1 = TIM_CR1_CEN;
+}
+
+/* Выключение светодиода и остановка нарастания яркости */
+void sunriseStop(void)
+{
+	TIM4->CR1 = 0;
+	DMA1_Channel4->CCR = 0;
+	DMA1->IFCR = DMA_IFCR_CGIF4;
+	TIM2->CCR2 = 0;																// Светодиод гаснет по ближайшему событию обновления (не позднее 2 мс)
+	active = 0;
+}
+
+/* 1 - рассвет идет или светодиод включен */
+uint8_t sunriseIsActive(void)
+{
+	return active;
+}
+
+/* Достигнута полная яркость: отсчет шагов останавливается, светодиод горит до отключения будильника */
+void DMA1_Channel4_IRQHandler(void)
+{
+	DMA1->IFCR = DMA_IFCR_CGIF4;
+	TIM4->CR1 = 0;
+	DMA1_Channel4->CCR = 0;
+}
@@ -0,0 +1,21 @@
+#ifndef SUNRISE_H
+#define SUNRISE_H
+
+#include <stdint.h>
+
+/*
+*	Имитация рассвета перед срабатыванием будильника
+*	Светодиод на ШИМ-выходе TIM2_CH2 (порт PA1), яркость по гамма-таблице во flash загружается в TIM2->CCR2
+*	каналом DMA1_Channel4 по событию сравнения TIM4_CH2, поэтому нарастание яркости не требует работы процессора
+*/
+
+#define SUNRISE_STEPS 			240		// Количество ступеней яркости (шаг = длительность в минутах * 250 мс)
+#define SUNRISE_MIN_MINUTES 	5		// Минимальная длительность рассвета (минуты)
+#define SUNRISE_MAX_MINUTES 	30		// Максимальная длительность рассвета (минуты)
+
+void Sunrise_Init(void);				// Настройка TIM2, TIM4 и DMA
+void sunriseStart(uint8_t minutes);		// Запуск нарастания яркости (максимум через minutes минут)
+void sunriseStop(void);					// Выключение светодиода
+uint8_t sunriseIsActive(void);			// 1 - рассвет идет или светодиод включен
+
+#endif /* SUNRISE_H */
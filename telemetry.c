@@ -0,0 +1,109 @@
+#include "telemetry.h"
+#include "console.h"
+#include "metrics.h"
+
+/*
+*	Кодирование COBS выполняется потоково: байт-код текущего блока резервируется заранее
+*	и записывается, когда встречается нулевой байт или блок достигает 254 байт
+*/
+
+#define TELEMETRY_FRAME_SIZE 	(TELEMETRY_MAX_PAYLOAD + 2 + 2 + 2)	// Тип, номер, данные, CRC, байт-код, разделитель
+
+telemetry_stats telemetryStats;
+
+static uint8_t *frame;			// Начало кадра в буфере передачи (0 - кадр не формируется)
+static uint16_t length;			// Записано байт кадра
+static uint16_t payload;		// Записано байт данных (до кодирования)
+static uint16_t codeIndex;		// Позиция байт-кода текущего блока
+static uint8_t code;			// Значение байт-кода (длина блока + 1)
+static uint16_t crc;			// CRC-16/CCITT (полином 0x1021, начальное значение 0xFFFF)
+static uint8_t sequence;		// Номер кадра
+
+static const uint16_t crcTable[16] = {	// Таблица CRC-16/CCITT для полубайта
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+/* Добавление байта в кодированный кадр */
+static void telemetryEncode(uint8_t value)
+{
+	if(value)
+	{
+		frame[length++] = value;
+		code++;
+	}
+	if(!value || code == 0xFF)						// Конец блока: запись байт-кода и начало нового блока
+	{
+		frame[codeIndex] = code;
+		codeIndex = length++;
+		code = 1;
+	}
+}
+
+/* Добавление байта данных (с учетом в CRC) */
+static void telemetryPut(uint8_t value)
+{
+	if(!frame || payload >= TELEMETRY_MAX_PAYLOAD + 2)
+	{
+		return;
+	}
+	payload++;
+	crc = (uint16_t)((crc << 4) ^ crcTable[(crc >> 12) ^ (value >> 4)]);
+	crc = (uint16_t)((crc << 4) ^ crcTable[(crc >> 12) ^ (value & 0x0F)]);
+	telemetryEncode(value);
+}
+
+/* Начало кадра: резервирование места в буфере передачи консоли */
+uint8_t telemetryBegin(uint8_t type)
+{
+	frame = consoleReserve(TELEMETRY_FRAME_SIZE);
+	if(!frame)
+	{
+		telemetryStats.dropped++;
+		METRIC_ADD(queueOverflows, 1);
+		return 0;
+	}
+	length = 1;
+	codeIndex = 0;
+	code = 1;
+	payload = 0;
+	crc = 0xFFFF;
+	telemetryPut(type);
+	telemetryPut(sequence++);
+	return 1;
+}
+
+void telemetryPutU8(uint8_t value)
+{
+	telemetryPut(value);
+}
+
+void telemetryPutU16(uint16_t value)
+{
+	telemetryPut((uint8_t)value);
+	telemetryPut((uint8_t)(value >> 8));
+}
+
+void telemetryPutU32(uint32_t value)
+{
+	telemetryPutU16((uint16_t)value);
+	telemetryPutU16((uint16_t)(value >> 16));
+}
+
+/* Завершение кадра: CRC (старшим байтом вперед), последний байт-код, разделитель 0x00 и отправка */
+void telemetryEnd(void)
+{
+	uint16_t value = crc;
+
+	if(!frame)
+	{
+		return;
+	}
+	telemetryEncode((uint8_t)(value >> 8));
+	telemetryEncode((uint8_t)value);
+	frame[codeIndex] = code;
+	frame[length++] = 0;
+	consoleCommit(length);
+	telemetryStats.frames++;
+	frame = 0;
+}
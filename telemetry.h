@@ -0,0 +1,30 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+/*
+*	Двоичная телеметрия: кадр = COBS(тип, номер, данные, CRC-16) + 0x00
+*	Кадр кодируется непосредственно в буфер передачи консоли (DMA), промежуточный буфер не используется.
+*	Многобайтовые поля передаются младшим байтом вперед. Декодер: tools/telemetry_decode.py
+*/
+
+#define TELEMETRY_MAX_PAYLOAD 	64		// Максимальный размер данных кадра (байт)
+#define TELEMETRY_TYPE_STATUS 	1		// Кадр состояния часов, будильника и счетчиков
+#define TELEMETRY_TYPE_TRACE 	2		// Кадр с частью журнала трассировки (trace.h)
+#define TELEMETRY_TYPE_METRICS 	3		// Кадр со снимком реестра метрик (metrics.h)
+
+typedef struct telemetry_stats_tag{	// Статистика телеметрии
+	uint16_t frames;				// Отправлено кадров
+	uint16_t dropped;				// Пропущено кадров (нет места в буфере передачи)
+} telemetry_stats;
+
+extern telemetry_stats telemetryStats;
+
+uint8_t telemetryBegin(uint8_t type);		// Начало кадра (0 - нет места, кадр пропускается)
+void telemetryPutU8(uint8_t value);			// Добавление полей кадра
+void telemetryPutU16(uint16_t value);
+void telemetryPutU32(uint32_t value);
+void telemetryEnd(void);					// Завершение кадра и отправка
+
+#endif /* TELEMETRY_H */
@@ -0,0 +1,130 @@
+#include "stm32f10x.h"
+#include "temperature.h"
+#include "timebase.h"
+
+#define TEMPERATURE_CHANNEL 	16			// Канал внутреннего датчика температуры
+
+static uint32_t sum;							// Сумма отсчетов групп за текущую секунду
+static uint16_t count;							// Отсчетов в сумме
+static int32_t filtered;						// Сглаженное напряжение датчика (мВ * 16 * 2^TEMPERATURE_FILTER_SHIFT), 0 - отсчетов еще нет
+static uint8_t enabled = 1;						// Флаг термокомпенсации
+static int16_t celsius = TEMPERATURE_TURNOVER;	// Последняя температура (0.01 C)
+static int16_t reference = TEMPERATURE_TURNOVER;	// Температура калибровки (0.01 C)
+static int32_t correction;						// Текущая поправка хода (ppb)
+
+/*
+*	Настройка ADC1: инжектированная группа из 4 преобразований канала 16 с программным запуском
+*	(DMA1_Channel1 занят индикатором, см. display.h)
+*/
+void Temperature_Init(void)
+{
+	uint32_t delay;
+
+	RCC->CFGR |= RCC_CFGR_ADCPRE_DIV2;											// ADCCLK = APB2 / 2 = 4 МГц (не более 14 МГц)
+	RCC->APB2ENR |= RCC_APB2ENR_ADC1EN;
+
+	ADC1->SMPR1 = ADC_SMPR1_SMP16;												// 239.5 такта: датчику нужно не менее 17.1 мкс
+	ADC1->JSQR = ADC_JSQR_JL | (TEMPERATURE_CHANNEL << 15) | (TEMPERATURE_CHANNEL << 10) | (TEMPERATURE_CHANNEL << 5) | TEMPERATURE_CHANNEL;	// JSQ4...JSQ1, 4 преобразования
+	ADC1->CR1 = ADC_CR1_SCAN;													// Группа из нескольких преобразований
+	ADC1->CR2 = ADC_CR2_TSVREFE | ADC_CR2_ADON;									// Включение АЦП и датчика
+	for(delay = 0; delay < 100; delay++) __NOP();								// Стабилизация АЦП (не менее 1 мкс)
+
+	ADC1->CR2 |= ADC_CR2_CAL;													// Калибровка АЦП
+	for(delay = 0; (ADC1->CR2 & ADC_CR2_CAL) && delay < 100000ul; delay++);
+
+	ADC1->CR2 |= ADC_CR2_JEXTSEL | ADC_CR2_JEXTTRIG;							// Запуск группы битом JSWSTART
+	ADC1->CR2 |= ADC_CR2_JSWSTART;
+}
+
+/*
+*	Накопление отсчетов: группа, запущенная тиком раньше, давно завершена (4 * 252 такта ADCCLK = 252 мкс),
+*	ее результаты добавляются к сумме секунды и группа запускается снова
+*/
+void temperatureTick(void)
+{
+	if(!(ADC1->SR & ADC_SR_JEOC))
+	{
+		return;
+	}
+	sum += ADC1->JDR1 + ADC1->JDR2 + ADC1->JDR3 + ADC1->JDR4;
+	count += TEMPERATURE_SAMPLES;
+	ADC1->SR = ~ADC_SR_JEOC;
+	ADC1->CR2 |= ADC_CR2_JSWSTART;
+}
+
+/*
+*	Усреднение отсчетов секунды (около 400), фильтрация и поправка хода
+*	T = 25 C + (V25 - V) / наклон; поправка = -(K * (T - T0)^2 - K * (Tкал - T0)^2),
+*	поскольку ошибка кварца при температуре калибровки уже учтена калибровкой.
+*	Отсчеты 12 бит: сумма за секунду * 16 и среднее * VDDA укладываются в 32 бита
+*/
+void temperatureSecond(void)
+{
+	int32_t millivolts16, value, deviation, deviationReference;
+
+	temperatureTick();
+	if(!count)
+	{
+		return;
+	}
+	millivolts16 = (int32_t)(sum * 16u / count * TEMPERATURE_VDDA / 4096u);	// Напряжение * 16 (мВ)
+	sum = 0;
+	count = 0;
+	if(!filtered)
+	{
+		filtered = millivolts16 << TEMPERATURE_FILTER_SHIFT;					// Первый отсчет - начальное значение фильтра
+	}
+	filtered += millivolts16 - (filtered >> TEMPERATURE_FILTER_SHIFT);
+	millivolts16 = filtered >> TEMPERATURE_FILTER_SHIFT;
+
+	value = 2500 + (TEMPERATURE_V25 * 16 - millivolts16) * 1000 / (TEMPERATURE_SLOPE * 16);
+	if(value < -4000 || value > 12500)											// Вне рабочего диапазона - отсчет пропускается
+	{
+		return;
+	}
+	celsius = (int16_t)value;
+
+	if(!enabled)
+	{
+		return;
+	}
+	deviation = celsius - TEMPERATURE_TURNOVER;									// Отклонение от вершины (0.01 C)
+	deviationReference = reference - TEMPERATURE_TURNOVER;
+	correction = -(deviation * deviation / 100 - deviationReference * deviationReference / 100) * TEMPERATURE_K / 100;
+	timebaseSetRate(TIMEBASE_TEMPERATURE, correction);
+}
+
+/* Последняя температура (0.01 C) */
+int16_t temperatureGet(void)
+{
+	return celsius;
+}
+
+/* Текущая поправка хода (ppb) */
+int32_t temperatureCorrection(void)
+{
+	return correction;
+}
+
+/* Включение термокомпенсации */
+void temperatureSetEnabled(uint8_t enable)
+{
+	enabled = enable;
+	if(!enable)
+	{
+		correction = 0;
+		timebaseSetRate(TIMEBASE_TEMPERATURE, 0);
+	}
+}
+
+/* 1 - термокомпенсация включена */
+uint8_t temperatureIsEnabled(void)
+{
+	return enabled;
+}
+
+/* Температура, при которой откалиброван кварц (0.01 C) */
+void temperatureSetReference(int16_t value)
+{
+	reference = value;
+}
@@ -0,0 +1,31 @@
+#ifndef TEMPERATURE_H
+#define TEMPERATURE_H
+
+#include <stdint.h>
+
+/*
+*	Термокомпенсация хода часов
+*	Каждый тик планировщика запускается инжектированная группа ADC1 из 4 преобразований внутреннего датчика температуры
+*	(канал 16, без DMA: DMA1_Channel1 занят индикатором). Результаты из JDR1...JDR4 суммируются за секунду (около 400
+*	отсчетов - усреднение вместо аппаратной передискретизации) и сглаживаются экспоненциальным фильтром (постоянная 16 с).
+*	По параболической модели кварца df/f = K * (T - T0)^2 вычисляется поправка хода. Только целочисленная арифметика
+*/
+
+#define TEMPERATURE_SAMPLES 	4			// Преобразований в инжектированной группе (отсчетов за тик планировщика)
+#define TEMPERATURE_FILTER_SHIFT 	4		// Постоянная времени фильтра - 2^4 секунд
+#define TEMPERATURE_VDDA 		3300		// Напряжение питания АЦП (мВ)
+#define TEMPERATURE_V25 		1430		// Напряжение датчика при 25 C (мВ, по документации 1.34...1.52 В)
+#define TEMPERATURE_SLOPE 		43			// Наклон характеристики датчика (0.1 мВ/C)
+#define TEMPERATURE_TURNOVER 	2500		// Температура вершины параболы кварца T0 (0.01 C)
+#define TEMPERATURE_K 			(-34)		// Коэффициент параболы K (ppb/C^2), уточняется для конкретного кварца
+
+void Temperature_Init(void);					// Настройка ADC1 (инжектированная группа)
+void temperatureTick(void);						// Накопление отсчетов группы и ее перезапуск (тик планировщика, прерывание TIM3)
+void temperatureSecond(void);					// Усреднение, фильтрация и поправка хода (вызывается из прерывания TIM3)
+int16_t temperatureGet(void);					// Последняя температура (0.01 C)
+int32_t temperatureCorrection(void);			// Текущая поправка хода (ppb)
+void temperatureSetEnabled(uint8_t enable);		// Включение термокомпенсации
+uint8_t temperatureIsEnabled(void);				// 1 - термокомпенсация включена
+void temperatureSetReference(int16_t value);  	// Температура, при которой откалиброван кварц (0.01 C)
+
+#endif /* TEMPERATURE_H */
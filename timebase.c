@@ -0,0 +1,97 @@
+#include "stm32f10x.h"
+#include "timebase.h"
+#include "critical.h"
+
+#define NS_PER_TICK 	1000000l		// Длительность тика TIM3 (нс)
+
+static int32_t rates[TIMEBASE_SOURCES];	// Поправки частоты источников (ppb)
+static int32_t rate;					// Суммарная поправка (ppb = нс за секунду)
+static int32_t accumulator;				// Накопленная поправка частоты (нс)
+static int32_t offset;					// Оставшаяся поправка фазы (мс)
+
+/* Поправка частоты от источника (> 0 - часы идут быстрее) */
+void timebaseSetRate(uint8_t source, int32_t ppb)
+{
+	int32_t total = 0;
+	uint8_t i;
+	uint32_t basepri;
+
+	if(source >= TIMEBASE_SOURCES)
+	{
+		return;
+	}
+	basepri = criticalEnter(BOARD_LEVEL_TIME);
+	rates[source] = ppb;
+	for(i = 0; i < TIMEBASE_SOURCES; i++)
+	{
+		total += rates[i];
+	}
+	if(total > TIMEBASE_MAX_RATE)
+	{
+		total = TIMEBASE_MAX_RATE;
+	}
+	if(total < -TIMEBASE_MAX_RATE)
+	{
+		total = -TIMEBASE_MAX_RATE;
+	}
+	rate = total;
+	criticalExit(basepri);
+}
+
+/* Суммарная поправка частоты (ppb) */
+int32_t timebaseGetRate(void)
+{
+	return rate;
+}
+
+/* Поправка частоты источника (ppb) */
+int32_t timebaseGetSourceRate(uint8_t source)
+{
+	return source < TIMEBASE_SOURCES ? rates[source] : 0;
+}
+
+/*
+*	Плавная поправка фазы (> 0 - часы уходят вперед)
+*	Новое измерение рассогласования уже учитывает отработанную часть, поэтому неотработанная поправка заменяется
+*/
+void timebaseSetOffset(int32_t milliseconds)
+{
+	uint32_t basepri;
+
+	basepri = criticalEnter(BOARD_LEVEL_TIME);
+	offset = milliseconds;
+	criticalExit(basepri);
+}
+
+/*
+*	Период TIM3 на следующую секунду
+*	Часы идут быстрее, если секунда короче: каждая накопленная 1 мс положительной поправки укорачивает секунду на тик
+*/
+uint16_t timebaseNextPeriod(void)
+{
+	int32_t ticks = 0;
+
+	accumulator += rate;
+	while(accumulator >= NS_PER_TICK)										// Поправка более 1000 ppm (работа от HSI) - несколько тиков за секунду
+	{
+		accumulator -= NS_PER_TICK;
+		ticks++;
+	}
+	while(accumulator <= -NS_PER_TICK)
+	{
+		accumulator += NS_PER_TICK;
+		ticks--;
+	}
+
+	if(offset > 0)
+	{
+		offset--;
+		ticks++;
+	}
+	else if(offset < 0)
+	{
+		offset++;
+		ticks--;
+	}
+	return (uint16_t)(TIMEBASE_PERIOD - ticks - 1);
+}
@@ -0,0 +1,34 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+
+/*
+*	Подстройка хода часов
+*	Секундный период TIM3 (1000 тиков по 1 мс) укорачивается или удлиняется на 1 мс в отдельные секунды:
+*	поправка частоты (ppb) накапливается и дает в среднем точный ход, поправка фазы (мс) отрабатывается
+*	плавно - не более чем на 1 мс в секунду. Поправка частоты складывается из нескольких источников
+*/
+
+#define TIMEBASE_PERIOD 	1000		// Номинальный период TIM3 (тиков по 1 мс)
+#define TIMEBASE_MAX_RATE 	20000000l	// Ограничение суммарной поправки частоты (ppb): 2% - разброс частоты HSI
+
+typedef enum timebase_source_tag{	// Источники поправки частоты
+	TIMEBASE_CALIBRATION,			// Сохраненная калибровка кварца
+	TIMEBASE_TEMPERATURE,			// Термокомпенсация
+	TIMEBASE_OSCILLATOR,			// Компенсация HSI при отказе HSE
+	TIMEBASE_DISCIPLINE,			// Подстройка по внешнему эталону (CAN, GPS)
+	TIMEBASE_SOURCES
+} timebase_source;
+
+void timebaseSetRate(uint8_t source, int32_t ppb);	// Поправка частоты от источника (> 0 - часы идут быстрее)
+int32_t timebaseGetRate(void);						// Суммарная поправка частоты (ppb)
+int32_t timebaseGetSourceRate(uint8_t source);		// Поправка частоты источника (ppb)
+void timebaseSetOffset(int32_t milliseconds);		// Плавная поправка фазы (> 0 - часы уходят вперед), заменяет неотработанную
+uint16_t timebaseNextPeriod(void);					// Период TIM3 на следующую секунду (вызывается из прерывания TIM3)
+
+/* Реализуется приложением */
+void ClockNow(uint32_t *p_seconds, uint16_t *p_milliseconds);	// Текущее время UTC с миллисекундами
+uint8_t ClockSetUtc(uint32_t seconds, uint16_t milliseconds);	// Скачкообразная установка времени UTC (0 - отложена: идет настройка часов)
+
+#endif /* TIMEBASE_H */
@@ -0,0 +1,79 @@
+#include "timezone.h"
+
+/*
+*	Часовые пояса и переход на летнее время
+*	Внутренний отсчет ведется по UTC, местное время получается добавлением смещения пояса.
+*	Смещение кэшируется вместе с моментом следующего перехода, поэтому на каждой секунде
+*	выполняется только одно сравнение, а поиск по таблице - только после прохождения перехода
+*/
+
+/* Поиск смещения пояса для момента utc (двоичный поиск первого перехода позже utc) */
+static void tzResolve(tz_state *p_state, uint32_t utc)
+{
+	const tz_zone *zone = p_state->zone;
+	uint16_t low = 0;
+	uint16_t high = zone->count;
+
+	while(low < high)
+	{
+		uint16_t middle = (uint16_t)((low + high) >> 1);
+		if(zone->utc[middle] <= utc)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	p_state->index = low;
+	p_state->offset = (int32_t)(low ? zone->offset[low - 1] : zone->standardOffset) * 900;	// 15 минут = 900 секунд
+	p_state->nextTransition = (low < zone->count) ? zone->utc[low] : TZ_NO_TRANSITION;
+}
+
+/* Выбор часового пояса и поиск смещения для момента utc */
+void tzSelect(tz_state *p_state, uint8_t zoneId, uint32_t utc)
+{
+	p_state->zone = &tzZones[zoneId];
+	tzResolve(p_state, utc);
+}
+
+/*
+*	Проверка прохождения перехода на летнее/зимнее время
+*	Возвращает 1, если смещение изменилось (местное время необходимо пересчитать)
+*/
+uint8_t tzUpdate(tz_state *p_state, uint32_t utc)
+{
+	int32_t offset;
+
+	if(utc < p_state->nextTransition)		// Переход еще не наступил - смещение из кэша
+	{
+		return 0;
+	}
+
+	offset = p_state->offset;
+	tzResolve(p_state, utc);
+	return offset != p_state->offset;
+}
+
+/*
+*	Преобразование местного времени в UTC
+*	Смещение определяется по приблизительному UTC и уточняется один раз (на границе перехода)
+*/
+uint32_t tzLocalToUtc(tz_state *p_state, uint32_t local)
+{
+	uint32_t utc = local - (uint32_t)p_state->offset;
+
+	tzResolve(p_state, utc);
+	utc = local - (uint32_t)p_state->offset;
+	tzResolve(p_state, utc);
+	return utc;
+}
+
+/* Местные дата и время пояса для момента utc (для мирового времени достаточно одного tz_state на пояс) */
+void tzLocalTime(tz_state *p_state, uint32_t utc, date *p_date, time *p_time)
+{
+	tzUpdate(p_state, utc);
+	secondsToDateTime(utc + (uint32_t)p_state->offset, p_date, p_time);
+}
@@ -0,0 +1,32 @@
+#ifndef TIMEZONE_H
+#define TIMEZONE_H
+
+#include <stdint.h>
+#include "calendar.h"
+#include "tz_table.h"
+
+#define TZ_NO_TRANSITION 	0xFFFFFFFFul	// Признак отсутствия следующего перехода
+
+typedef struct tz_zone_tag{		// Описание часового пояса (таблица переходов формируется tools/tz_gen.py)
+	const char *name;			// Сокращенное название пояса
+	int8_t standardOffset;		// Смещение до первого перехода (в 15-минутных интервалах)
+	uint16_t count;				// Количество переходов в таблице
+	const uint32_t *utc;		// Моменты переходов (UTC, секунды от 01.01.1970), по возрастанию
+	const int8_t *offset;		// Смещение после перехода (в 15-минутных интервалах)
+} tz_zone;
+
+typedef struct tz_state_tag{	// Кэш текущего смещения пояса (пересчитывается только после прохождения перехода)
+	const tz_zone *zone;		// Часовой пояс
+	int32_t offset;				// Текущее смещение от UTC (секунды)
+	uint32_t nextTransition;	// Момент следующего перехода (UTC) или TZ_NO_TRANSITION
+	uint16_t index;				// Индекс следующего перехода в таблице
+} tz_state;
+
+extern const tz_zone tzZones[TZ_COUNT];
+
+void tzSelect(tz_state *p_state, uint8_t zoneId, uint32_t utc);				// Выбор пояса и поиск смещения для момента utc
+uint8_t tzUpdate(tz_state *p_state, uint32_t utc);							// Проверка прохождения перехода (1 - смещение изменилось)
+uint32_t tzLocalToUtc(tz_state *p_state, uint32_t local);					// Местное время -> UTC (с обновлением кэша)
+void tzLocalTime(tz_state *p_state, uint32_t utc, date *p_date, time *p_time);	// UTC -> местные дата и время пояса
+
+#endif /* TIMEZONE_H */
@@ -0,0 +1,281 @@
+#!/usr/bin/env python3
+# -*- coding: cp1251 -*-
+"""
+Образ обновления для загрузчика (boot.h) и передача по USART2
+
+Образ приложения (.bin, fromelf после сборки: Objects\\Practice.bin) дополняется до слова и сжимается в поток LZ.
+С --base (установленный образ) строится разностный поток: копии берутся также из установленного образа,
+но только из страниц, которые загрузчик еще не перезаписал. Выводятся размер потока и оценка времени
+обновления: передача на заданной скорости и стирание и запись измененных страниц (типовые времена flash
+STM32F103: стирание страницы 20 мс, полуслово 52,5 мкс); оценка - модель, а не измерение.
+С --port образ передается загрузчику (требуется pyserial); загрузчик сообщает время обновления,
+число записанных и пропущенных (совпавших) страниц - это измеренное значение.
+Запуск: python tools/boot_image.py Objects\\Practice.bin [--base old.bin] [--port COM5 [--enter]] [--save поток.bin]
+"""
+import argparse
+import struct
+import sys
+import time
+
+MAGIC = 0x544F4F42
+FORMAT_FULL, FORMAT_DELTA = 0, 1
+PAGE_SIZE = 1024
+APP_SIZE = 0x1D000							# BOOT_APP_SIZE
+BLOCK = 256									# BOOT_BLOCK
+WINDOW = 2048								# BOOT_WINDOW
+MATCH_MIN = 4
+MAX_DISTANCE = 65535
+CANDIDATES = 16								# Проверяемых позиций на каждый поиск копии
+ERASE_TIME = 0.020
+HALFWORD_TIME = 52.5e-6
+RESULTS = ("ok", "idle", "header", "base", "timeout", "stream", "flash", "crc")
+
+CRC_TABLE = []
+for _byte in range(256):
+	_crc = _byte << 24
+	for _ in range(8):
+		_crc = ((_crc << 1) ^ 0x04C11DB7) & 0xFFFFFFFF if _crc & 0x80000000 else (_crc << 1) & 0xFFFFFFFF
+	CRC_TABLE.append(_crc)
+
+
+def crc32_words(data):
+	"""CRC-32 аппаратного блока STM32: полином 0x04C11DB7, начальное 0xFFFFFFFF, слова little-endian старшим битом вперед"""
+	crc = 0xFFFFFFFF
+	for (word,) in struct.iter_unpack("<I", data):
+		for byte in word.to_bytes(4, "big"):
+			crc = ((crc << 8) & 0xFFFFFFFF) ^ CRC_TABLE[(crc >> 24) ^ byte]
+	return crc
+
+
+def pad(data):
+	return bytes(data) + b"\xFF" * (-len(data) % 4)
+
+
+def match_length(source, start, image, position, limit):
+	"""Длина совпадения source[start:] и image[position:], не более limit"""
+	length = 0
+	while length < limit:
+		step = min(32, limit - length)
+		if source[start + length:start + length + step] == image[position + length:position + length + step]:
+			length += step
+			continue
+		while length < limit and source[start + length] == image[position + length]:
+			length += 1
+		break
+	return length
+
+
+def extend(stream, value):
+	while value >= 255:
+		stream.append(255)
+		value -= 255
+	stream.append(value)
+
+
+def emit(stream, literals, length=0, distance=0, source=None):
+	"""Последовательность: признак, литералы, смещение, продолжение длины копии, позиция в установленном образе"""
+	code = length - MATCH_MIN if length else 0
+	stream.append(min(len(literals), 15) << 4 | min(code, 15))
+	if len(literals) >= 15:
+		extend(stream, len(literals) - 15)
+	stream += literals
+	if not length:
+		return
+	stream += struct.pack("<H", 0 if source is not None else distance)
+	if code >= 15:
+		extend(stream, code - 15)
+	if source is not None:
+		stream += struct.pack("<I", source)[:3]
+
+
+def compress(image, base=b""):
+	"""Поток LZ (boot.h): жадный выбор самой длинной копии из нового образа или из еще не перезаписанной части base"""
+	stream = bytearray()
+	chains = {}
+	base_index = {}
+	for index in range(len(base) - MATCH_MIN + 1):
+		base_index.setdefault(base[index:index + MATCH_MIN], []).append(index)
+	literal_start = 0
+	position = 0
+	size = len(image)
+	while position < size:
+		best = (0, 0, None)
+		key = image[position:position + MATCH_MIN]
+		if len(key) == MATCH_MIN:
+			for candidate in reversed(chains.get(key, [])[-CANDIDATES:]):
+				if position - candidate > MAX_DISTANCE:
+					break
+				length = match_length(image, candidate, image, position, size - position)
+				if length > best[0]:
+					best = (length, position - candidate, None)
+			page_start = position - position % PAGE_SIZE
+			candidates = base_index.get(key, [])
+			first = next((i for i, value in enumerate(candidates) if value >= page_start), len(candidates))
+			for candidate in candidates[first:first + CANDIDATES]:
+				limit = min(size - position, len(base) - candidate)
+				if candidate < position:				# Источник позади записи - копия только внутри текущей страницы
+					limit = min(limit, page_start + PAGE_SIZE - position)
+				length = match_length(base, candidate, image, position, limit)
+				if length > best[0]:
+					best = (length, 0, candidate)
+		if best[0] >= MATCH_MIN:
+			emit(stream, image[literal_start:position], *best)
+			for index in range(position, position + best[0]):
+				chains.setdefault(image[index:index + MATCH_MIN], []).append(index)
+			position += best[0]
+			literal_start = position
+		else:
+			chains.setdefault(key, []).append(position)
+			position += 1
+	if literal_start < size:
+		emit(stream, image[literal_start:])
+	return bytes(stream)
+
+
+def decompress(stream, length, base=b""):
+	"""Модель распаковки загрузчика (проверка потока и ограничения на копии из установленного образа)"""
+	output = bytearray()
+	index = 0
+
+	def length_tail():
+		nonlocal index
+		total = 0
+		while True:
+			value = stream[index]
+			index += 1
+			total += value
+			if value != 255:
+				return total
+
+	while len(output) < length:
+		token = stream[index]
+		index += 1
+		count = token >> 4
+		if count == 15:
+			count += length_tail()
+		output += stream[index:index + count]
+		index += count
+		if len(output) >= length:
+			break
+		distance = struct.unpack_from("<H", stream, index)[0]
+		index += 2
+		count = (token & 15) + MATCH_MIN
+		if token & 15 == 15:
+			count += length_tail()
+		if distance:
+			for _ in range(count):
+				output.append(output[len(output) - distance])
+		else:
+			source = int.from_bytes(stream[index:index + 3], "little")
+			index += 3
+			for _ in range(count):
+				if source < len(output) - len(output) % PAGE_SIZE or source >= len(base):
+					raise ValueError("копия из перезаписанной страницы установленного образа")
+				output.append(base[source])
+				source += 1
+	return bytes(output[:length])
+
+
+def changed_pages(image, base):
+	pages = 0
+	for offset in range(0, len(image), PAGE_SIZE):
+		new = image[offset:offset + PAGE_SIZE].ljust(PAGE_SIZE, b"\xFF")
+		old = base[offset:offset + PAGE_SIZE].ljust(PAGE_SIZE, b"\xFF")
+		pages += new != old
+	return pages
+
+
+def estimate(stream_size, pages, baud):
+	"""Модель: пока страница стирается и пишется, ПК успевает передать не более окна; остальное время - передача"""
+	transfer = (20 + stream_size) * 10.0 / baud
+	flash = pages * (ERASE_TIME + PAGE_SIZE // 2 * HALFWORD_TIME)
+	overlap = pages * min(WINDOW * 10.0 / baud, ERASE_TIME + PAGE_SIZE // 2 * HALFWORD_TIME)
+	return transfer, flash, flash + max(0.0, transfer - overlap)
+
+
+def read_until(port, accepted, timeout):
+	"""Первый байт из accepted (остальные пропускаются) или None по таймауту"""
+	end = time.monotonic() + timeout
+	while time.monotonic() < end:
+		byte = port.read(1)
+		if byte and byte in accepted:
+			return byte
+	return None
+
+
+def transfer(port, header, stream):
+	if read_until(port, b"R", 5.0) is None:
+		raise RuntimeError("нет ответа загрузчика")
+	port.write(header)
+	answer = read_until(port, b"AE", 2.0)
+	if answer != b"A":
+		raise RuntimeError("заголовок отклонен: " + (RESULTS[port.read(1)[0]] if answer else "нет ответа"))
+	start = time.perf_counter()
+	sent = acked = 0
+	while sent < len(stream):
+		if sent - acked < WINDOW:
+			chunk = stream[sent:sent + min(BLOCK, WINDOW - (sent - acked))]
+			port.write(chunk)
+			sent += len(chunk)
+		for byte in port.read(port.in_waiting or (1 if sent - acked >= WINDOW else 0)):
+			if byte == ord("."):
+				acked += BLOCK
+			elif byte == ord("E"):
+				raise RuntimeError("ошибка загрузчика: " + RESULTS[port.read(1)[0]])
+	if read_until(port, b"KE", 10.0) != b"K":
+		raise RuntimeError("ошибка загрузчика: " + (RESULTS[port.read(1)[0]] if port.in_waiting else "нет ответа"))
+	milliseconds, programmed, skipped = struct.unpack("<IHH", port.read(8))
+	return time.perf_counter() - start, milliseconds, programmed, skipped
+
+
+def main():
+	parser = argparse.ArgumentParser()
+	parser.add_argument("image")
+	parser.add_argument("--base", help="установленный образ (.bin) - разностный поток")
+	parser.add_argument("--save", help="сохранить заголовок и поток")
+	parser.add_argument("--port")
+	parser.add_argument("--baud", type=int, default=1000000)
+	parser.add_argument("--enter", action="store_true", help="перед обменом команда update консоли приложения")
+	parser.add_argument("--console-baud", type=int, default=115200)
+	args = parser.parse_args()
+
+	with open(args.image, "rb") as f:
+		image = pad(f.read())
+	if len(image) > APP_SIZE:
+		print("образ больше области приложения: %d > %d" % (len(image), APP_SIZE))
+		return 1
+	base = b""
+	if args.base:
+		with open(args.base, "rb") as f:
+			base = pad(f.read())
+	started = time.perf_counter()
+	stream = compress(image, base)
+	elapsed = time.perf_counter() - started
+	if decompress(stream, len(image), base) != image:
+		print("ошибка сжатия: распакованный поток не совпал с образом")
+		return 1
+	header = struct.pack("<IB3xIII", MAGIC, FORMAT_DELTA if base else FORMAT_FULL, len(image), crc32_words(image), crc32_words(base) if base else 0)
+	pages = changed_pages(image, base) if base else (len(image) + PAGE_SIZE - 1) // PAGE_SIZE
+	print("образ %d байт, поток %d байт (%.1f%%, сжатие %.1f с), %s" % (len(image), len(stream), 100.0 * len(stream) / len(image), elapsed,
+																	 "разностный" if base else "полный"))
+	seconds, flash, total = estimate(len(stream), pages, args.baud)
+	print("оценка при %d бод: передача %.2f с, страниц к записи %d (%.2f с), обновление около %.2f с" % (args.baud, seconds, pages, flash, total))
+	if args.save:
+		with open(args.save, "wb") as f:
+			f.write(header + stream)
+	if not args.port:
+		return 0
+
+	import serial
+	if args.enter:
+		with serial.Serial(args.port, args.console_baud, timeout=0.1) as console:
+			console.write(b"update\r\n")
+			console.flush()
+	with serial.Serial(args.port, args.baud, timeout=0.1) as port:
+		wall, milliseconds, programmed, skipped = transfer(port, header, stream)
+	print("обновление: загрузчик %d мс (записано страниц %d, пропущено %d), на стороне ПК %.2f с" % (milliseconds, programmed, skipped, wall))
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,129 @@
+/*
+*	Проверка календаря на компьютере (calendar.c)
+*
+*	Полный 400-летний цикл (146097 дней от 01.01.1970) сравнивается с эталоном - последовательным счетом
+*	дней по годам и месяцам с правилом високосного года по определению:
+*	1) dateNextDay, примененный день за днем, дает ту же дату и день недели, что и эталон;
+*	2) daysToDate(дни) совпадает с эталоном, dateToDays(дата эталона) возвращает те же дни;
+*	3) secondsToDateTime и dateTimeToSeconds для начала, конца и середины каждых суток, представимых 32-битным
+*	   счетчиком секунд (до 07.02.2106), и для последней секунды 0xFFFFFFFF;
+*	4) timeTick проходит сутки и переходит через полночь ровно один раз.
+*	Сборка и запуск (из корня проекта): gcc -I. -o calendar_sim tools/calendar_sim.c calendar.c && ./calendar_sim
+*	Код возврата 1 - расхождение с эталоном (выводятся первые расхождения)
+*/
+#include <stdio.h>
+#include "calendar.h"
+
+#define SIM_DAYS 		146097ul		// Дней в 400-летнем цикле
+#define SIM_ERRORS_MAX 	10				// Выводимых расхождений
+
+static unsigned errors;
+
+/* Високосный год по определению (эталон, с делениями) */
+static int simLeap(unsigned year)
+{
+	return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+/* Длина месяца эталона */
+static unsigned simMonthDays(unsigned year, unsigned month)
+{
+	static const unsigned char lengths[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+	return month == 2 && simLeap(year) ? 29u : lengths[month - 1];
+}
+
+/* Сравнение даты с эталоном */
+static void simCompare(const char *p_what, unsigned long days, const date *p_date, const date *p_reference)
+{
+	if(p_date->year == p_reference->year && p_date->month == p_reference->month && p_date->day == p_reference->day &&
+	   p_date->weekday == p_reference->weekday)
+	{
+		return;
+	}
+	if(++errors <= SIM_ERRORS_MAX)
+	{
+		printf("ОШИБКА %s, день %lu: %04u-%02u-%02u (%u), эталон %04u-%02u-%02u (%u)\n", p_what, days,
+			   p_date->year, p_date->month, p_date->day, p_date->weekday,
+			   p_reference->year, p_reference->month, p_reference->day, p_reference->weekday);
+	}
+}
+
+/* Проверка секунд от начала отсчета */
+static void simSeconds(uint32_t seconds, const date *p_reference)
+{
+	date result;
+	time clock;
+	uint32_t secondOfDay = seconds % SECONDS_PER_DAY;
+
+	secondsToDateTime(seconds, &result, &clock);
+	simCompare("secondsToDateTime", seconds / SECONDS_PER_DAY, &result, p_reference);
+	if(clock.hours != secondOfDay / 3600 || clock.minutes != secondOfDay / 60 % 60 || clock.seconds != secondOfDay % 60 ||
+	   dateTimeToSeconds(&result, &clock) != seconds)
+	{
+		if(++errors <= SIM_ERRORS_MAX)
+		{
+			printf("ОШИБКА время, секунда %lu: %02u:%02u:%02u\n", (unsigned long)seconds, clock.hours, clock.minutes, clock.seconds);
+		}
+	}
+}
+
+int main(void)
+{
+	date reference = {CALENDAR_EPOCH_YEAR, 1, 1, CALENDAR_EPOCH_WEEKDAY};
+	date incremental = reference, converted;
+	time clock = {0, 0, 0};
+	unsigned long days, seconds, midnights = 0;
+	unsigned long secondDays = 0xFFFFFFFFul / SECONDS_PER_DAY;			// Последние полные сутки 32-битного счетчика
+
+	for(days = 0; days < SIM_DAYS; days++)
+	{
+		simCompare("dateNextDay", days, &incremental, &reference);
+		daysToDate((uint32_t)days, &converted);
+		simCompare("daysToDate", days, &converted, &reference);
+		if(dateToDays(&reference) != days && ++errors <= SIM_ERRORS_MAX)
+		{
+			printf("ОШИБКА dateToDays, день %lu: %lu\n", days, (unsigned long)dateToDays(&reference));
+		}
+		if(days <= secondDays)
+		{
+			simSeconds((uint32_t)(days * SECONDS_PER_DAY), &reference);
+			if(days < secondDays)												// Последние сутки счетчика неполные
+			{
+				simSeconds((uint32_t)(days * SECONDS_PER_DAY + 45296u), &reference);		// 12:34:56
+				simSeconds((uint32_t)(days * SECONDS_PER_DAY + SECONDS_PER_DAY - 1u), &reference);
+			}
+		}
+		if(days == secondDays)
+		{
+			simSeconds(0xFFFFFFFFul, &reference);										// 07.02.2106 06:28:15
+		}
+
+		dateNextDay(&incremental);
+		reference.weekday = (uint8_t)((reference.weekday + 1) % 7);
+		if(++reference.day > simMonthDays(reference.year, reference.month))
+		{
+			reference.day = 1;
+			if(++reference.month > 12)
+			{
+				reference.month = 1;
+				reference.year++;
+			}
+		}
+	}
+
+	for(seconds = 0; seconds < SECONDS_PER_DAY; seconds++)
+	{
+		midnights += timeTick(&clock);
+	}
+	if(midnights != 1 || clock.hours || clock.minutes || clock.seconds)
+	{
+		printf("ОШИБКА timeTick: переходов через полночь %lu, время %02u:%02u:%02u\n", midnights, clock.hours, clock.minutes, clock.seconds);
+		errors++;
+	}
+
+	printf("Проверено дней: %lu (с %04u-%02u-%02u до %04u-%02u-%02u), секунды до 0xFFFFFFFF - по три на сутки\n", SIM_DAYS,
+		   CALENDAR_EPOCH_YEAR, 1, 1, incremental.year, incremental.month, incremental.day);
+	printf("Расхождений: %u\n", errors);
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+# -*- coding: cp1251 -*-
+"""
+Моделирование синхронизации времени по CAN (cansync.c, timebase.c) на множестве узлов
+
+Каждый узел - часы на TIM3 с 1-мс тиком и собственной ошибкой кварца; период секунды задается
+так же, как timebaseNextPeriod(), подстройка по SYNC/FOLLOW_UP - так же, как canSyncDiscipline().
+Отметки времени берутся по счетчику мс со случайной задержкой входа в прерывание.
+Выводит установившееся рассогласование узлов с ведущим (по истинному времени) и поправки частоты.
+Запуск: python tools/cansync_sim.py [--nodes 32] [--ppm 100] [--hours 2] [--seed 1]
+Константы должны совпадать с cansync.h и timebase.h.
+"""
+import argparse
+import random
+
+PERIOD = 4              # CANSYNC_PERIOD
+STEP_LIMIT = 100        # CANSYNC_STEP_LIMIT
+RATE_SHIFT = 4          # CANSYNC_RATE_SHIFT
+MAX_RATE = 500000       # TIMEBASE_MAX_RATE
+NS_PER_TICK = 1000000
+LATENCY = (2e-6, 20e-6) # Задержка от конца кадра до входа в прерывание (с)
+FRAME_TIME = 100e-6     # Длительность кадра SYNC на 500 кбит/с (с)
+
+
+def c_div(a, b):
+	"""Деление с отбрасыванием дробной части к нулю (как в C)"""
+	q = abs(a) // abs(b)
+	return q if (a >= 0) == (b >= 0) else -q
+
+
+class Node:
+	def __init__(self, ppm, start_seconds):
+		self.tick = 1e-3 / (1.0 + ppm * 1e-6)   # Истинная длительность тика TIM3
+		self.seconds = start_seconds
+		self.start = 0.0                        # Истинный момент начала текущей секунды
+		self.period = 1000                      # ARR + 1
+		self.rate = 0
+		self.accumulator = 0
+		self.offset = 0
+		self.discipline = 0
+		self.locked = False
+		self.steps = 0
+
+	def next_period(self):
+		ticks = 0
+		self.accumulator += self.rate
+		if self.accumulator >= NS_PER_TICK:
+			self.accumulator -= NS_PER_TICK
+			ticks += 1
+		elif self.accumulator <= -NS_PER_TICK:
+			self.accumulator += NS_PER_TICK
+			ticks -= 1
+		if self.offset > 0:
+			self.offset -= 1
+			ticks += 1
+		elif self.offset < 0:
+			self.offset += 1
+			ticks -= 1
+		return 1000 - ticks
+
+	def advance(self, t):
+		while self.start + self.period * self.tick <= t:
+			self.start += self.period * self.tick
+			self.seconds += 1
+			self.period = self.next_period()
+
+	def now(self, t):
+		"""ClockNow(): секунды и миллисекунды по счетчику"""
+		self.advance(t)
+		return self.seconds, int((t - self.start) / self.tick)
+
+	def exact(self, t):
+		"""Показание часов с дробной частью мс (для оценки рассогласования)"""
+		self.advance(t)
+		return self.seconds * 1000.0 + (t - self.start) / self.tick
+
+	def set_utc(self, t, seconds, milliseconds):
+		"""ClockSetUtc()"""
+		self.seconds = seconds
+		self.start = t - milliseconds * self.tick
+		self.period = 1000
+
+	def discipline_step(self, t_rx, sync, master):
+		difference = master[0] - sync[0]
+		offset = difference * 1000 + master[1] - sync[1] if -1000 < difference < 1000 else (1000000 if difference > 0 else -1000000)
+		if not self.locked or abs(offset) > STEP_LIMIT:
+			now = self.now(t_rx)
+			elapsed = (now[0] - sync[0]) * 1000 + now[1] - sync[1] + master[1]
+			self.set_utc(t_rx, master[0] + elapsed // 1000, elapsed % 1000)
+			self.offset = 0
+			self.locked = True
+			self.steps += 1
+			return offset
+		self.discipline += c_div(offset * c_div(1000000, PERIOD), 1 << RATE_SHIFT)
+		self.discipline = max(-MAX_RATE, min(MAX_RATE, self.discipline))
+		self.rate = self.discipline
+		self.offset = offset
+		return offset
+
+
+def main():
+	parser = argparse.ArgumentParser()
+	parser.add_argument("--nodes", type=int, default=32)
+	parser.add_argument("--ppm", type=float, default=100.0, help="разброс ошибки кварцев ведомых (+-ppm)")
+	parser.add_argument("--hours", type=float, default=2.0)
+	parser.add_argument("--seed", type=int, default=1)
+	args = parser.parse_args()
+
+	random.seed(args.seed)
+	master = Node(random.uniform(-20, 20), 1700000000)
+	nodes = [Node(random.uniform(-args.ppm, args.ppm), random.randrange(0, 1 << 31)) for _ in range(args.nodes)]
+	duration = args.hours * 3600.0
+	settle = duration / 2
+	worst = 0.0
+	samples = []
+	t = 0.0
+
+	while t < duration:
+		# Начало секунды ведущего кратной периоду: передача SYNC
+		master.advance(t)
+		t = master.start + master.period * master.tick
+		master.advance(t)
+		if master.seconds % PERIOD:
+			continue
+		t_end = t + FRAME_TIME
+		master_stamp = master.now(t_end + random.uniform(*LATENCY))
+		stamps = [node.now(t_end + random.uniform(*LATENCY)) for node in nodes]
+		t_follow = t_end + 4 * FRAME_TIME
+		for node, stamp in zip(nodes, stamps):
+			node.discipline_step(t_follow + random.uniform(*LATENCY), stamp, master_stamp)
+		if t > settle:
+			probe = t + 0.5
+			reference = master.exact(probe)
+			errors = [node.exact(probe) - reference for node in nodes]
+			worst = max(worst, max(abs(e) for e in errors))
+			samples.extend(errors)
+
+	ppm = [(1e-3 / node.tick - 1.0) * 1e6 for node in nodes]
+	residual = [p + node.discipline / 1000.0 - ((1e-3 / master.tick - 1.0) * 1e6 + master.discipline / 1000.0) for p, node in zip(ppm, nodes)]
+	print("узлов %d, период %d с, %.1f ч, кварцы +-%.0f ppm" % (args.nodes, PERIOD, args.hours, args.ppm))
+	print("установки скачком: %d" % sum(node.steps for node in nodes))
+	if samples:
+		mean = sum(samples) / len(samples)
+		rms = (sum(e * e for e in samples) / len(samples)) ** 0.5
+		print("рассогласование со второй половины: среднее %.3f мс, СКО %.3f мс, максимум %.3f мс" % (mean, rms, worst))
+	print("остаточная ошибка частоты: максимум %.2f ppm" % max(abs(r) for r in residual))
+
+
+if __name__ == "__main__":
+	main()
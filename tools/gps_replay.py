@@ -0,0 +1,228 @@
+#!/usr/bin/env python3
+# -*- coding: cp1251 -*-
+"""
+Воспроизведение записи NMEA/1PPS через модель подстройки часов по GPS (gps.c, timebase.c)
+
+Формат записи (текст, по строке на событие в порядке времени):
+	pps <такты>         - захват импульса 1PPS, такты 32 МГц от HSE (продолженный 32-битный счетчик)
+	rmc <такты> $..RMC  - предложение NMEA, принятое к моменту <такты>
+	# ...               - комментарий
+Часы TIM3 моделируются по тем же тактам HSE (1 мс = 32000 тактов) с поправками timebaseNextPeriod().
+Выводит ошибку часов относительно GPS на каждом импульсе и итоговую ошибку частоты.
+Запуск: python tools/gps_replay.py запись.txt [--verbose]
+        python tools/gps_replay.py --generate запись.txt [--ppm 37.5] [--seconds 3600] [--jitter 50]
+Константы должны совпадать с gps.h и timebase.h.
+"""
+import argparse
+import calendar
+import random
+import time
+
+TIMER_CLOCK = 32000000
+TICKS_PER_MS = TIMER_CLOCK // 1000
+STEP_LIMIT = 100        # GPS_STEP_LIMIT
+FREQ_SHIFT = 3          # GPS_FREQ_SHIFT
+MAX_GAP = 60            # GPS_MAX_GAP
+NS_PER_TICK = 1000000
+
+
+def c_div(a, b):
+	"""Деление с отбрасыванием дробной части к нулю (как в C)"""
+	q = abs(a) // abs(b)
+	return q if (a >= 0) == (b >= 0) else -q
+
+
+class Clock:
+	"""TIM3 + timebase.c: секунда из period мс, мс из 32000 тактов HSE"""
+	def __init__(self):
+		self.seconds = 0
+		self.start = 0              # Такт начала текущей секунды
+		self.period = 1000
+		self.rate = 0
+		self.accumulator = 0
+		self.offset = 0
+
+	def next_period(self):
+		ticks = 0
+		self.accumulator += self.rate
+		if self.accumulator >= NS_PER_TICK:
+			self.accumulator -= NS_PER_TICK
+			ticks += 1
+		elif self.accumulator <= -NS_PER_TICK:
+			self.accumulator += NS_PER_TICK
+			ticks -= 1
+		if self.offset > 0:
+			self.offset -= 1
+			ticks += 1
+		elif self.offset < 0:
+			self.offset += 1
+			ticks -= 1
+		return 1000 - ticks
+
+	def advance(self, tick):
+		while self.start + self.period * TICKS_PER_MS <= tick:
+			self.start += self.period * TICKS_PER_MS
+			self.seconds += 1
+			self.period = self.next_period()
+
+	def now(self, tick):
+		self.advance(tick)
+		return self.seconds, (tick - self.start) // TICKS_PER_MS
+
+	def set_utc(self, tick, seconds, milliseconds):
+		self.seconds = seconds
+		self.start = tick - milliseconds * TICKS_PER_MS
+		self.period = 1000
+
+
+class Gps:
+	"""gps.c: разбор RMC и обработка импульсов"""
+	def __init__(self, clock):
+		self.clock = clock
+		self.locked = False
+		self.pps_valid = False
+		self.pps_capture = 0
+		self.pps_seconds = 0
+		self.pps_ms = 0
+		self.utc_valid = False
+		self.utc_of_pps = 0
+		self.frequency = 0
+		self.offset = 0
+		self.steps = 0
+		self.sentences = 0
+		self.checksum_errors = 0
+
+	def sentence(self, line):
+		if not line.startswith("$") or "*" not in line:
+			return
+		body, _, received = line[1:].partition("*")
+		checksum = 0
+		for symbol in body.encode("ascii"):
+			checksum ^= symbol
+		try:
+			if int(received[:2], 16) != checksum:
+				self.checksum_errors += 1
+				return
+		except ValueError:
+			return
+		fields = body.split(",")
+		if len(fields[0]) != 5 or fields[0][2:] != "RMC":
+			return
+		self.sentences += 1
+		if len(fields) < 10 or fields[2] != "A" or len(fields[1]) < 6 or len(fields[9]) != 6:
+			return
+		hms, dmy = fields[1][:6], fields[9]
+		self.utc_of_pps = calendar.timegm((2000 + int(dmy[4:6]), int(dmy[2:4]), int(dmy[0:2]), int(hms[0:2]), int(hms[2:4]), int(hms[4:6]), 0, 0, 0))
+		self.utc_valid = True
+
+	def pps(self, tick):
+		capture = tick & 0xFFFF
+		now, ms = self.clock.now(tick)
+		interval = (now - self.pps_seconds) * 1000 + ms - self.pps_ms
+		seconds = (interval + 500) // 1000
+		if self.pps_valid and 1 <= seconds <= MAX_GAP:
+			deviation = (capture - self.pps_capture - seconds * TIMER_CLOCK) & 0xFFFF
+			deviation = deviation - 0x10000 if deviation & 0x8000 else deviation
+			ppb = c_div(deviation * 125, 4 * seconds)
+			self.frequency += c_div(ppb - self.frequency, 1 << FREQ_SHIFT)
+		self.pps_valid = True
+		self.pps_capture, self.pps_seconds, self.pps_ms = capture, now, ms
+
+		if self.utc_valid:
+			expected = self.utc_of_pps + 1
+			difference = expected - now
+			self.offset = difference * 1000 - ms if -1000 < difference < 1000 else (-1000000 if difference < 0 else 1000000)
+		elif self.locked:
+			expected = now if ms < 500 else now + 1
+			self.offset = -ms if ms < 500 else 1000 - ms
+		else:
+			return
+		self.utc_valid = False
+
+		if not self.locked or abs(self.offset) > STEP_LIMIT:
+			self.clock.set_utc(tick, expected, 0)
+			self.clock.offset = 0
+			self.locked = True
+			self.pps_valid = False
+			self.steps += 1
+		else:
+			self.clock.offset = self.offset
+		self.clock.rate = -self.frequency
+
+
+def nmea(body):
+	checksum = 0
+	for symbol in body.encode("ascii"):
+		checksum ^= symbol
+	return "$%s*%02X" % (body, checksum)
+
+
+def generate(path, ppm, seconds, jitter_ns, seed):
+	random.seed(seed)
+	utc = int(time.time())
+	tick_per_second = TIMER_CLOCK * (1.0 + ppm * 1e-6)
+	with open(path, "w") as trace:
+		trace.write("# HSE %+.3f ppm, jitter %d ns\n" % (ppm, jitter_ns))
+		for i in range(seconds):
+			edge = int(i * tick_per_second + random.gauss(0, jitter_ns * 1e-9 * TIMER_CLOCK)) + 12345
+			trace.write("pps %d\n" % edge)
+			if random.random() < 0.02:
+				continue                                # Пропуск предложения
+			stamp = time.gmtime(utc + i)
+			body = "GPRMC,%02d%02d%02d.00,A,5545.000,N,03737.000,E,0.0,0.0,%02d%02d%02d,,,A" % (
+				stamp.tm_hour, stamp.tm_min, stamp.tm_sec, stamp.tm_mday, stamp.tm_mon, stamp.tm_year % 100)
+			line = nmea(body)
+			if random.random() < 0.01:
+				line = line[:20] + "9" + line[21:]      # Искаженное предложение
+			trace.write("rmc %d %s\n" % (edge + int(0.3 * tick_per_second), line))
+
+
+def replay(path, verbose):
+	clock = Clock()
+	gps = Gps(clock)
+	errors = []
+	with open(path) as trace:
+		for raw in trace:
+			parts = raw.split()
+			if not parts or parts[0].startswith("#"):
+				continue
+			tick = int(parts[1])
+			if parts[0] == "rmc":
+				gps.sentence(parts[2])
+				continue
+			was_locked = gps.locked
+			gps.pps(tick)
+			if was_locked:
+				# Ошибка часов в момент импульса: показание (с долей мс) против ближайшей целой секунды GPS
+				clock.advance(tick)
+				reading = clock.seconds * 1000.0 + (tick - clock.start) / TICKS_PER_MS
+				error_ms = reading - round(reading / 1000.0) * 1000.0
+				errors.append(error_ms)
+				if verbose:
+					print("%d offset %d мс, частота %d ppb, ошибка %.3f мс" % (tick, gps.offset, gps.frequency, error_ms))
+	print("RMC: %d, ошибок CRC: %d, установок скачком: %d" % (gps.sentences, gps.checksum_errors, gps.steps))
+	print("ошибка частоты HSE: %.3f ppm" % (gps.frequency / 1000.0))
+	if errors:
+		tail = errors[len(errors) // 2:]
+		print("ошибка часов (вторая половина): среднее %.3f мс, максимум %.3f мс" % (sum(tail) / len(tail), max(abs(e) for e in tail)))
+
+
+def main():
+	parser = argparse.ArgumentParser()
+	parser.add_argument("trace")
+	parser.add_argument("--generate", action="store_true", help="создать синтетическую запись вместо воспроизведения")
+	parser.add_argument("--ppm", type=float, default=37.5)
+	parser.add_argument("--seconds", type=int, default=3600)
+	parser.add_argument("--jitter", type=int, default=50, help="дрожание 1PPS (нс)")
+	parser.add_argument("--seed", type=int, default=1)
+	parser.add_argument("--verbose", action="store_true")
+	args = parser.parse_args()
+
+	if args.generate:
+		generate(args.trace, args.ppm, args.seconds, args.jitter, args.seed)
+	else:
+		replay(args.trace, args.verbose)
+
+
+if __name__ == "__main__":
+	main()
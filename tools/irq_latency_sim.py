@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+# -*- coding: cp1251 -*-
+"""
+Модель задержки секунды TIM3 при дребезге кнопок (контроллер прерываний Cortex-M3 на хосте)
+
+Схема приоритетов проверяется без платы: запросы прерываний генерируются по сценарию, контроллер моделируется
+по правилам NVIC - вытесняет только более высокий уровень, среди ожидающих выбирается наименьший уровень, затем
+подприоритет, затем номер прерывания; вход в обработчик 12 тактов, цепочка обработчиков 6 тактов; повторный запрос
+ожидающего прерывания теряется (как флаг EXTI->PR). Основной цикл чередует работу и критические секции.
+Длительности обработчиков и секций (HANDLERS, THREAD) - оценки по объему кода, а не измерения на плате.
+Сравниваются приоритеты board.h с секциями BASEPRI и прежняя схема: все прерывания на уровне 0, секции PRIMASK.
+Результат - задержка от события обновления TIM3 до входа в обработчик (худшая и 99-й процентиль).
+Запуск: python tools/irq_latency_sim.py [окон] [seed]
+"""
+import os
+import random
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+BOARD_FILE = os.path.join(ROOT, "board.h")
+
+HCLK = 32000000									# Тактов в секунду
+US = HCLK // 1000000
+WINDOW = 20000 * US								# Окно моделирования вокруг одной секунды
+ENTRY = 12										# Вход в обработчик из потока или с вытеснением
+TAIL_CHAIN = 6									# Переход к следующему обработчику без возврата в поток
+
+IRQN = {"EXTI4": 10, "DMA1_Channel4": 14, "DMA1_Channel5": 15, "DMA1_Channel6": 16, "DMA1_Channel7": 17, "USB_HP_CAN1_TX": 19,
+		"USB_LP_CAN1_RX0": 20, "EXTI9_5": 23, "TIM2": 28, "TIM3": 29, "I2C1_EV": 31, "I2C1_ER": 32,
+		"USART1": 37, "USART2": 38, "USART3": 39}
+
+# Источники: (прерывание, длительность обработчика в тактах, генератор интервалов между запросами в тактах)
+HANDLERS = (
+	("EXTI9_5", 90, lambda r: r.randint(1 * US, 20 * US)),		# Дребезг: фронты через 1...20 мкс все окно
+	("EXTI4", 70, lambda r: r.randint(1 * US, 20 * US)),
+	("USART2", 150, lambda r: r.randint(2000, 20000) * US),	# Консоль: конец посылки (IDLE), байты принимает DMA
+	("DMA1_Channel6", 100, lambda r: 64 * 87 * US),			# Половина буфера приема консоли при непрерывном потоке 115200
+	("USART1", 250, lambda r: 1042 * US),						# NMEA 9600
+	("DMA1_Channel7", 120, lambda r: r.randint(2000, 8000) * US),
+	("TIM2", 6000, lambda r: r.randint(5000, 15000) * US),		# Таймаут Modbus: CRC, разбор и ответ в обработчике
+	("USB_LP_CAN1_RX0", 1500, lambda r: r.randint(5000, 15000) * US),
+	("I2C1_EV", 60, lambda r: 23 * US),						# OLED: байт I2C 400 кГц (с запасом - передача без перерывов)
+	("DMA1_Channel5", 40, lambda r: r.randint(5000, 15000) * US),
+)
+TIM3_CYCLES = 2500
+
+# Основной цикл: (тактов работы, тактов секции, уровень секции board.h)
+THREAD = (
+	(3000, 60, "BOARD_LEVEL_TIME"),							# ClockNow, копии времени
+	(2000, 600, "BOARD_LEVEL_COMMS"),						# consolePrint длинной строки
+	(5000, 150, "BOARD_LEVEL_TIME"),						# TelemetrySend, storeEvent
+)
+
+
+def board_priorities(path):
+	"""{прерывание: (уровень, подприоритет)} и {имя уровня: значение} из board.h"""
+	with open(path, encoding="cp1251") as f:
+		text = f.read()
+	levels = {name: int(value) for name, value in re.findall(r"#define (BOARD_LEVEL_\w+)\s+(\d+)u", text)}
+	irqs = {name: (levels[level], int(sub)) for name, level, sub in re.findall(r"X\((\w+)_IRQn,\s*(\w+),\s*(\d+)\)", text)}
+	return irqs, levels
+
+
+def simulate(rng, priorities, levels, basepri):
+	"""Одно окно: задержка входа в TIM3 (тактов)"""
+	requests = []
+	for name, cycles, interval in HANDLERS:
+		t = rng.randint(0, interval(rng))
+		while t < WINDOW:
+			requests.append((t, name))
+			t += interval(rng)
+	tim3_at = rng.randint(WINDOW // 4, WINDOW * 3 // 4)
+	requests.append((tim3_at, "TIM3"))
+	requests.sort(key=lambda item: item[0])
+	cost = dict((name, cycles) for name, cycles, _ in HANDLERS)
+	cost["TIM3"] = TIM3_CYCLES
+
+	def key(name):
+		level, sub = priorities.get(name, (0, 0))
+		return (level, sub, IRQN[name])
+
+	t = 0
+	index = 0
+	pending = set()
+	stack = []											# [уровень, имя, оставшиеся такты]
+	segment = rng.randrange(len(THREAD)) * 2				# Четные - работа, нечетные - секция
+	left = rng.randint(1, THREAD[segment // 2][0])
+	chained = False
+	while True:
+		while index < len(requests) and requests[index][0] <= t:
+			pending.add(requests[index][1])
+			index += 1
+		if stack:
+			current = stack[-1][0]
+		elif segment % 2:
+			current = levels[THREAD[segment // 2][2]] if basepri else -1	# PRIMASK маскирует все уровни
+		else:
+			current = 1 << 8
+		if stack and segment % 2:
+			current = min(current, levels[THREAD[segment // 2][2]] if basepri else -1)
+		ready = [name for name in pending if key(name)[0] < current]
+		if ready:
+			name = min(ready, key=key)
+			pending.discard(name)
+			entry = TAIL_CHAIN if chained and not stack else ENTRY
+			if name == "TIM3":
+				return t + entry - tim3_at
+			stack.append([key(name)[0], name, cost[name] + entry])
+			chained = False
+			continue
+		step = requests[index][0] - t if index < len(requests) else WINDOW
+		if stack:
+			step = min(step, stack[-1][2])
+			stack[-1][2] -= step
+			t += step
+			if stack[-1][2] == 0:
+				stack.pop()
+				chained = True
+		else:
+			step = min(step, left)
+			left -= step
+			t += step
+			chained = False
+			if left == 0:
+				segment = (segment + 1) % (len(THREAD) * 2)
+				work, section, _ = THREAD[segment // 2]
+				left = section if segment % 2 else work
+
+
+def report(title, latencies):
+	latencies.sort()
+	print("%-34s worst %7.1f us  p99 %7.1f us  median %5.1f us" % (title, latencies[-1] / US,
+		latencies[len(latencies) * 99 // 100] / US, latencies[len(latencies) // 2] / US))
+
+
+def main():
+	windows = int(sys.argv[1]) if len(sys.argv) > 1 else 500
+	seed = int(sys.argv[2]) if len(sys.argv) > 2 else 1
+	priorities, levels = board_priorities(BOARD_FILE)
+	flat = dict((name, (0, 0)) for name in IRQN)
+	rng = random.Random(seed)
+	report("equal priority, PRIMASK sections", [simulate(rng, flat, levels, False) for _ in range(windows)])
+	rng = random.Random(seed)
+	report("board.h levels, BASEPRI sections", [simulate(rng, priorities, levels, True) for _ in range(windows)])
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+# -*- coding: cp1251 -*-
+"""
+Отчет о памяти после сборки (запускается µVision после компоновки, Options - User - After Build)
+
+1. Размеры по объектным файлам (Code, RO, RW, ZI) и крупнейшие секции ОЗУ - из файла карты компоновщика.
+2. Статическая оценка стека по графу вызовов компоновщика (Max Depth функций): основной поток,
+   плюс по самому глубокому обработчику каждого уровня вытеснения (уровни - список BOARD_IRQS в board.h,
+   обработчики одного уровня не вытесняют друг друга), плюс NMI; каждый вход в исключение добавляет кадр EXCEPTION_FRAME. Результат сравнивается со Stack_Size.
+   Вызовы через указатели и рекурсия компоновщиком не учитываются - такие функции перечисляются отдельно.
+Запуск: python tools/mem_report.py [карта.map] [граф.htm] [startup.s]
+"""
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+MAP_FILE = os.path.join(ROOT, "Listings", "Practice.map")
+CALLGRAPH_FILE = os.path.join(ROOT, "Objects", "Practice.htm")
+STARTUP_FILE = os.path.join(ROOT, "RTE", "Device", "STM32F103RB", "startup_stm32f10x_md.s")
+BOARD_FILE = os.path.join(ROOT, "board.h")
+
+RAM_SIZE = 20 * 1024
+ROM_SIZE = 0x1D000							# Без загрузчика и страниц хранилища (boot.h, store.h)
+EXCEPTION_FRAME = 36						# 8 слов кадра исключения и выравнивание стека до 8 байт
+THREAD_ROOTS = ("__rt_entry", "__main", "main")
+STACK_MARGIN = 128							# Запас ниже которого выводится предупреждение
+
+OBJECT_LINE = re.compile(r"^\s+(\d+)\s+(\d+)\s+(\d+)\s+(\d+)\s+(\d+)\s+(\d+)\s+(\S+\.o)\s*$")
+SECTION_LINE = re.compile(r"^\s+0x([0-9a-f]{8})\s+(?:0x[0-9a-f]{8}\s+|-\s+)?0x([0-9a-f]{8})\s+(Zero|Data|Code|PAD)\s+(RW|RO)?\s*\d*\s+(\S+)\s+(\S+)\s*$")
+FUNCTION = re.compile(r"<STRONG><a name=\"\[[0-9a-f]+\]\"></a>([\w$.]+)</STRONG> \((?:Thumb|ARM), \d+ bytes, Stack size (\d+) bytes")
+MAX_DEPTH = re.compile(r"Max Depth = (\d+)( \+ Unknown)?")
+BOARD_IRQ = re.compile(r"^\s*X\((\w+)_IRQn,\s*(\w+),\s*\d+\)", re.M)
+
+
+def object_sizes(lines):
+	"""Размеры по объектным файлам проекта: {объект: (code, ro, rw, zi)}"""
+	sizes = {}
+	for line in lines:
+		match = OBJECT_LINE.match(line)
+		if match:
+			code, _, ro, rw, zi, _, name = match.groups()
+			sizes[name] = (int(code), int(ro), int(rw), int(zi))
+		elif "Object Totals" in line and sizes:
+			break
+	return sizes
+
+
+def ram_sections(lines):
+	"""Секции ОЗУ из карты памяти: [(размер, тип, секция, объект)]"""
+	sections = []
+	for line in lines:
+		match = SECTION_LINE.match(line)
+		if match and match.group(1).startswith("2000") and match.group(3) in ("Zero", "Data"):
+			sections.append((int(match.group(2), 16), match.group(3), match.group(5), match.group(6)))
+	return sections
+
+
+def callgraph(text):
+	"""Функции графа вызовов: {имя: (стек функции, наибольшая глубина, есть неизвестная глубина)}"""
+	functions = {}
+	blocks = text.split("<P><STRONG>")
+	for block in blocks[1:]:
+		match = FUNCTION.search("<STRONG>" + block)
+		if not match:
+			continue
+		depth = MAX_DEPTH.search(block)
+		own = int(match.group(2))
+		functions[match.group(1)] = (own, int(depth.group(1)) if depth else own, bool(depth and depth.group(2)))
+	return functions
+
+
+def stack_size(path):
+	with open(path, encoding="latin-1") as f:
+		match = re.search(r"^Stack_Size\s+EQU\s+(0x[0-9A-Fa-f]+|\d+)", f.read(), re.M)
+	return int(match.group(1), 0) if match else None
+
+
+def irq_levels(path):
+	"""Уровни вытеснения из board.h: {обработчик: уровень}; без файла все обработчики считаются одним уровнем"""
+	if not os.path.exists(path):
+		return {}
+	with open(path, encoding="cp1251") as f:
+		return {name + "_IRQHandler": level for name, level in BOARD_IRQ.findall(f.read())}
+
+
+def report_sizes(lines):
+	sizes = object_sizes(lines)
+	if not sizes:
+		print("mem_report: в карте нет таблицы Image component sizes (включите Listing - Size Info)")
+		return
+	print("%-20s %7s %7s %7s %7s" % ("object", "code", "ro", "rw", "zi"))
+	for name, (code, ro, rw, zi) in sorted(sizes.items(), key=lambda item: -(item[1][2] + item[1][3])):
+		print("%-20s %7d %7d %7d %7d" % (name, code, ro, rw, zi))
+	text = "\n".join(lines)
+	rom = re.search(r"Total ROM Size \(Code \+ RO Data \+ RW Data\)\s+(\d+)", text)
+	ram = re.search(r"Total RW\s+Size \(RW Data \+ ZI Data\)\s+(\d+)", text)
+	if rom and ram:
+		print("ROM %d/%d (%.1f%%)  RAM %d/%d (%.1f%%)" % (int(rom.group(1)), ROM_SIZE, 100.0 * int(rom.group(1)) / ROM_SIZE,
+														 int(ram.group(1)), RAM_SIZE, 100.0 * int(ram.group(1)) / RAM_SIZE))
+	print("largest RAM sections:")
+	for size, kind, section, name in sorted(ram_sections(lines), reverse=True)[:10]:
+		print("  %6d %-4s %-24s %s" % (size, kind, section, name))
+
+
+def report_stack(functions, stack, levels):
+	thread = max((functions[name][1] for name in THREAD_ROOTS if name in functions), default=0)
+	deepest = {}
+	for name, (_, depth, _) in functions.items():
+		if name.endswith("_IRQHandler") or name in ("SysTick_Handler", "PendSV_Handler", "SVC_Handler"):
+			level = levels.get(name, "")
+			if depth > deepest.get(level, (-1, ""))[0]:
+				deepest[level] = (depth, name)
+	handlers = sorted(deepest.values(), reverse=True)
+	nmi = functions.get("NMI_Handler", (0, 0, False))[1]
+	worst = thread + sum(depth + EXCEPTION_FRAME for depth, _ in handlers) + (nmi + EXCEPTION_FRAME if nmi else 0)
+	print("stack: thread %d, irq %s, nmi %d -> worst case %d bytes" % (
+		thread, ", ".join("%s %d" % (name, depth) for depth, name in handlers) or "-", nmi, worst))
+	unknown = sorted(name for name, (_, _, flag) in functions.items() if flag and (name in THREAD_ROOTS or name.endswith("Handler")))
+	if unknown:
+		print("  глубина не полная (указатели на функции, рекурсия): " + ", ".join(unknown))
+	if stack is not None:
+		print("Stack_Size %d, margin %d bytes%s" % (stack, stack - worst, "  WARNING: запас меньше %d" % STACK_MARGIN if stack - worst < STACK_MARGIN else ""))
+
+
+def main():
+	map_file = sys.argv[1] if len(sys.argv) > 1 else MAP_FILE
+	callgraph_file = sys.argv[2] if len(sys.argv) > 2 else CALLGRAPH_FILE
+	startup_file = sys.argv[3] if len(sys.argv) > 3 else STARTUP_FILE
+	if os.path.exists(map_file):
+		with open(map_file, encoding="latin-1") as f:
+			report_sizes(f.read().splitlines())
+	else:
+		print("mem_report: нет файла карты " + map_file)
+	if os.path.exists(callgraph_file):
+		with open(callgraph_file, encoding="latin-1") as f:
+			report_stack(callgraph(f.read()), stack_size(startup_file), irq_levels(BOARD_FILE))
+	else:
+		print("mem_report: нет графа вызовов " + callgraph_file)
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+# -*- coding: cp1251 -*-
+"""
+Генератор нагрузки Modbus RTU для часов (ведущее устройство)
+
+Посылает подряд запросы чтения и записи регистров, проверяет ответы (адрес, функция, CRC, данные)
+и выводит количество ошибок и время ответа. Порт - реальный USART3 через преобразователь или
+виртуальный порт симуляции. Требуется pyserial.
+Запуск: python tools/modbus_load.py COM4 [--baud 115200] [--count 1000] [--address 1]
+Время ответа измеряется на стороне ПК и включает задержки драйвера USB-UART.
+"""
+import argparse
+import struct
+import time
+
+import serial
+
+
+def crc16(data):
+	crc = 0xFFFF
+	for byte in data:
+		crc ^= byte
+		for _ in range(8):
+			crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+	return crc
+
+
+def frame(body):
+	return body + struct.pack("<H", crc16(body))
+
+
+def transact(port, request, expected_length, char_time):
+	port.reset_input_buffer()
+	start = time.perf_counter()
+	port.write(request)
+	port.flush()
+	response = port.read(expected_length)
+	elapsed = time.perf_counter() - start - len(request) * char_time
+	if len(response) < 5 or crc16(response[:-2]) != struct.unpack("<H", response[-2:])[0]:
+		return None, elapsed
+	return response, elapsed
+
+
+def main():
+	parser = argparse.ArgumentParser()
+	parser.add_argument("port")
+	parser.add_argument("--baud", type=int, default=115200)
+	parser.add_argument("--count", type=int, default=1000)
+	parser.add_argument("--address", type=int, default=1)
+	args = parser.parse_args()
+
+	char_time = 11.0 / args.baud
+	port = serial.Serial(args.port, args.baud, parity=serial.PARITY_EVEN, timeout=0.1)
+	errors = 0
+	latencies = []
+
+	for i in range(args.count):
+		if i % 2:
+			# Запись минут будильника (эхо запроса в ответе)
+			request = frame(struct.pack(">BBHH", args.address, 0x06, 4, i % 60))
+			response, elapsed = transact(port, request, 8, char_time)
+			ok = response == request
+		else:
+			# Чтение всех 10 регистров хранения
+			request = frame(struct.pack(">BBHH", args.address, 0x03, 0, 10))
+			response, elapsed = transact(port, request, 5 + 20, char_time)
+			ok = response is not None and response[1] == 0x03 and response[2] == 20
+		if ok:
+			latencies.append(elapsed)
+		else:
+			errors += 1
+
+	if latencies:
+		latencies.sort()
+		print("requests: %d, errors: %d" % (args.count, errors))
+		print("turnaround (ms): min %.3f, median %.3f, max %.3f" % (
+			latencies[0] * 1000, latencies[len(latencies) // 2] * 1000, latencies[-1] * 1000))
+		print("one character time: %.3f ms" % (char_time * 1000))
+	else:
+		print("no valid responses, errors: %d" % errors)
+
+
+if __name__ == "__main__":
+	main()
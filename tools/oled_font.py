@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+# -*- coding: cp1251 -*-
+"""
+Генератор шрифтов OLED-индикатора (oled_font.c, oled_font.h)
+
+Мелкий шрифт 5x7 (символы ' '...'Z', столбцы по 8 пикселей - младший бит сверху, как в странице SSD1306)
+и крупные цифры для времени: тот же рисунок, увеличенный в 3 раза, в клетке 16x24 (3 страницы),
+поэтому вывод крупной цифры - копирование 48 байт без сдвигов. Запуск: python tools/oled_font.py (из корня проекта)
+"""
+
+SMALL_FIRST = " "
+SMALL_LAST = "Z"
+SMALL_WIDTH = 5
+
+SCALE = 3
+LARGE_WIDTH = 16            # Ширина клетки крупного символа (15 столбцов рисунка + промежуток)
+LARGE_PAGES = 3             # Высота клетки (страницы по 8 пикселей)
+LARGE_TOP = 1               # Отступ рисунка от верха клетки (пиксели)
+LARGE_CHARS = "0123456789: "
+
+GLYPHS = {
+	" ": (0x00, 0x00, 0x00, 0x00, 0x00),
+	"*": (0x14, 0x08, 0x3E, 0x08, 0x14),
+	"+": (0x08, 0x08, 0x3E, 0x08, 0x08),
+	"-": (0x08, 0x08, 0x08, 0x08, 0x08),
+	".": (0x00, 0x60, 0x60, 0x00, 0x00),
+	"/": (0x20, 0x10, 0x08, 0x04, 0x02),
+	"0": (0x3E, 0x51, 0x49, 0x45, 0x3E),
+	"1": (0x00, 0x42, 0x7F, 0x40, 0x00),
+	"2": (0x42, 0x61, 0x51, 0x49, 0x46),
+	"3": (0x21, 0x41, 0x45, 0x4B, 0x31),
+	"4": (0x18, 0x14, 0x12, 0x7F, 0x10),
+	"5": (0x27, 0x45, 0x45, 0x45, 0x39),
+	"6": (0x3C, 0x4A, 0x49, 0x49, 0x30),
+	"7": (0x01, 0x71, 0x09, 0x05, 0x03),
+	"8": (0x36, 0x49, 0x49, 0x49, 0x36),
+	"9": (0x06, 0x49, 0x49, 0x29, 0x1E),
+	":": (0x00, 0x36, 0x36, 0x00, 0x00),
+	"A": (0x7E, 0x11, 0x11, 0x11, 0x7E),
+	"B": (0x7F, 0x49, 0x49, 0x49, 0x36),
+	"C": (0x3E, 0x41, 0x41, 0x41, 0x22),
+	"D": (0x7F, 0x41, 0x41, 0x22, 0x1C),
+	"E": (0x7F, 0x49, 0x49, 0x49, 0x41),
+	"F": (0x7F, 0x09, 0x09, 0x09, 0x01),
+	"G": (0x3E, 0x41, 0x49, 0x49, 0x7A),
+	"H": (0x7F, 0x08, 0x08, 0x08, 0x7F),
+	"I": (0x00, 0x41, 0x7F, 0x41, 0x00),
+	"J": (0x20, 0x40, 0x41, 0x3F, 0x01),
+	"K": (0x7F, 0x08, 0x14, 0x22, 0x41),
+	"L": (0x7F, 0x40, 0x40, 0x40, 0x40),
+	"M": (0x7F, 0x02, 0x0C, 0x02, 0x7F),
+	"N": (0x7F, 0x04, 0x08, 0x10, 0x7F),
+	"O": (0x3E, 0x41, 0x41, 0x41, 0x3E),
+	"P": (0x7F, 0x09, 0x09, 0x09, 0x06),
+	"Q": (0x3E, 0x41, 0x51, 0x21, 0x5E),
+	"R": (0x7F, 0x09, 0x19, 0x29, 0x46),
+	"S": (0x46, 0x49, 0x49, 0x49, 0x31),
+	"T": (0x01, 0x01, 0x7F, 0x01, 0x01),
+	"U": (0x3F, 0x40, 0x40, 0x40, 0x3F),
+	"V": (0x1F, 0x20, 0x40, 0x20, 0x1F),
+	"W": (0x3F, 0x40, 0x38, 0x40, 0x3F),
+	"X": (0x63, 0x14, 0x08, 0x14, 0x63),
+	"Y": (0x07, 0x08, 0x70, 0x08, 0x07),
+	"Z": (0x61, 0x51, 0x49, 0x45, 0x43),
+}
+
+
+def large(glyph):
+	"""Увеличение рисунка 5x7 в SCALE раз: список страниц по LARGE_WIDTH байт"""
+	columns = []
+	for column in glyph:
+		bits = 0
+		for row in range(7):
+			if column & (1 << row):
+				for k in range(SCALE):
+					bits |= 1 << (LARGE_TOP + row * SCALE + k)
+		columns += [bits] * SCALE
+	columns += [0] * (LARGE_WIDTH - len(columns))
+	return [[(bits >> (8 * page)) & 0xFF for bits in columns] for page in range(LARGE_PAGES)]
+
+
+def row(values):
+	return ", ".join("0x%02X" % value for value in values)
+
+
+def main():
+	small_count = ord(SMALL_LAST) - ord(SMALL_FIRST) + 1
+	header = ["/* Файл сгенерирован tools/oled_font.py, не редактировать вручную */",
+			  "#ifndef OLED_FONT_H",
+			  "#define OLED_FONT_H",
+			  "",
+			  "#include <stdint.h>",
+			  "",
+			  "#define OLED_FONT_FIRST 		'%s'	// Первый символ мелкого шрифта" % SMALL_FIRST,
+			  "#define OLED_FONT_LAST 		'%s'	// Последний символ мелкого шрифта" % SMALL_LAST,
+			  "#define OLED_FONT_WIDTH 		%d		// Ширина символа мелкого шрифта (столбцы, без промежутка)" % SMALL_WIDTH,
+			  "#define OLED_LARGE_WIDTH 		%d		// Ширина клетки крупного символа (столбцы)" % LARGE_WIDTH,
+			  "#define OLED_LARGE_PAGES 		%d		// Высота клетки крупного символа (страницы)" % LARGE_PAGES,
+			  "#define OLED_LARGE_COLON 		10		// Индекс двоеточия в крупном шрифте (0...9 - цифры)",
+			  "#define OLED_LARGE_BLANK 		11		// Индекс пустой клетки",
+			  "",
+			  "extern const uint8_t oledFontSmall[%d][OLED_FONT_WIDTH];" % small_count,
+			  "extern const uint8_t oledFontLarge[%d][OLED_LARGE_PAGES][OLED_LARGE_WIDTH];" % len(LARGE_CHARS),
+			  "",
+			  "#endif /* OLED_FONT_H */"]
+
+	source = ["/* Файл сгенерирован tools/oled_font.py, не редактировать вручную */",
+			  '#include "oled_font.h"',
+			  "",
+			  "/* Мелкий шрифт 5x7: столбцы слева направо, младший бит - верхний пиксель */",
+			  "const uint8_t oledFontSmall[%d][OLED_FONT_WIDTH] = {" % small_count]
+	for code in range(ord(SMALL_FIRST), ord(SMALL_LAST) + 1):
+		symbol = chr(code)
+		source.append("\t{%s},\t// '%s'" % (row(GLYPHS.get(symbol, (0,) * SMALL_WIDTH)), symbol))
+	source.append("};")
+	source.append("")
+	source.append("/* Крупный шрифт: рисунок 5x7, увеличенный в %d раза; страницы сверху вниз */" % SCALE)
+	source.append("const uint8_t oledFontLarge[%d][OLED_LARGE_PAGES][OLED_LARGE_WIDTH] = {" % len(LARGE_CHARS))
+	for symbol in LARGE_CHARS:
+		pages = large(GLYPHS[symbol])
+		source.append("\t{\t// '%s'" % symbol)
+		for page in pages:
+			source.append("\t\t{%s}," % row(page))
+		source.append("\t},")
+	source.append("};")
+
+	with open("oled_font.h", "w", encoding="cp1251", newline="\n") as f:
+		f.write("\n".join(header) + "\n")
+	with open("oled_font.c", "w", encoding="cp1251", newline="\n") as f:
+		f.write("\n".join(source) + "\n")
+
+
+if __name__ == "__main__":
+	main()
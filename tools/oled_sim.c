@@ -0,0 +1,176 @@
+/*
+*	Модель обновления OLED-индикатора на компьютере (oled.c, oled_font.c)
+*
+*	Кадр строится теми же функциями, что и на устройстве; измененные диапазоны передаются модели SSD1306,
+*	которая разбирает команды выбора столбцов и страниц и пишет данные в свою память с горизонтальной адресацией.
+*	После каждого обновления память модели сравнивается с кадром, считаются байты на шине I2C
+*	(адрес и управляющий байт каждой транзакции, команды, данные - как в oled_i2c.c).
+*	Сборка и запуск (из корня проекта): gcc -I. -o oled_sim tools/oled_sim.c oled.c oled_font.c && ./oled_sim [секунд]
+*	Код возврата 1 - память модели разошлась с кадром
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "oled.h"
+
+#define SIM_I2C_BITS 	9		// Бит на байт I2C (8 бит и подтверждение)
+
+static uint8_t device[OLED_PAGES][OLED_WIDTH];	// Память модели SSD1306
+static uint8_t column, columnFirst, columnLast;	// Адресация модели
+static uint8_t page, pageFirst, pageLast;
+
+/* Транзакция команд: разбираются только команды выбора диапазона */
+static void simCommands(const uint8_t *p_data, uint8_t length)
+{
+	uint8_t i;
+
+	for(i = 0; i < length; i++)
+	{
+		if(p_data[i] == 0x21 && i + 2 < length)
+		{
+			columnFirst = column = p_data[i + 1];
+			columnLast = p_data[i + 2];
+			i += 2;
+		}
+		else if(p_data[i] == 0x22 && i + 2 < length)
+		{
+			pageFirst = page = p_data[i + 1];
+			pageLast = p_data[i + 2];
+			i += 2;
+		}
+	}
+}
+
+/* Транзакция данных: запись с горизонтальной адресацией (конец диапазона столбцов - следующая страница) */
+static void simData(const uint8_t *p_data, uint8_t length)
+{
+	uint8_t i;
+
+	for(i = 0; i < length; i++)
+	{
+		device[page][column] = p_data[i];
+		if(column == columnLast)
+		{
+			column = columnFirst;
+			page = page == pageLast ? pageFirst : (uint8_t)(page + 1);
+		}
+		else
+		{
+			column++;
+		}
+	}
+}
+
+/* Передача всех измененных диапазонов (как oledFlush в основном цикле); возвращает число байт на шине */
+static uint32_t simFlush(void)
+{
+	uint8_t segmentPage, first, last, commands[OLED_SEGMENT_COMMANDS];
+	uint32_t bytes = 0;
+
+	while(oledNextSegment(&segmentPage, &first, &last))
+	{
+		commands[0] = 0x21;
+		commands[1] = first;
+		commands[2] = last;
+		commands[3] = 0x22;
+		commands[4] = segmentPage;
+		commands[5] = segmentPage;
+		simCommands(commands, OLED_SEGMENT_COMMANDS);
+		simData(oledSegmentData(segmentPage, first), (uint8_t)(last - first + 1));
+		bytes += 2u + OLED_SEGMENT_COMMANDS + 2u + (uint32_t)(last - first + 1);
+	}
+	return bytes;
+}
+
+/* Сравнение памяти модели с кадром */
+static int simCheck(void)
+{
+	uint8_t i;
+
+	for(i = 0; i < OLED_PAGES; i++)
+	{
+		if(memcmp(device[i], oledSegmentData(i, 0), OLED_WIDTH))
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* Две цифры числа */
+static void simNumber(char *p_text, unsigned value)
+{
+	p_text[0] = (char)('0' + value / 10 % 10);
+	p_text[1] = (char)('0' + value % 10);
+}
+
+/* Экран как в OledUpdate (main.c): дата, время, секунды, будильник, состояние */
+static void simScreen(unsigned seconds)
+{
+	char text[12];
+	unsigned hours = seconds / 3600 % 24, minutes = seconds / 60 % 60;
+
+	oledText(0, 0, "19.10.2026");
+	oledText(110, 0, "HSE");
+	simNumber(&text[0], hours);
+	text[2] = (seconds & 1) ? ' ' : ':';
+	simNumber(&text[3], minutes);
+	text[5] = 0;
+	oledLargeText(4, 2, text);
+	simNumber(&text[0], seconds % 60);
+	text[2] = 0;
+	oledText(92, 4, text);
+	oledText(0, 6, "ALARM");
+	oledText(36, 6, "07:30 ");
+	oledText(0, 7, "GPS FIX");
+	oledText(54, 7, "CAN M");
+}
+
+int main(int argc, char **argv)
+{
+	unsigned total = argc > 1 ? (unsigned)atoi(argv[1]) : 86400u;
+	unsigned second, updates = 0, minuteUpdates = 0;
+	uint32_t bytes, full, maxSecond = 0, maxMinute = 0;
+	uint64_t sumSecond = 0, sumMinute = 0;
+
+	memset(device, 0xA5, sizeof(device));						// Память контроллера после включения не определена
+	oledInvalidate();
+	simScreen(0);
+	full = simFlush();
+	if(!simCheck())
+	{
+		printf("ОШИБКА: кадр после полной передачи не совпадает\n");
+		return 1;
+	}
+
+	for(second = 1; second < total; second++)
+	{
+		simScreen(second);
+		bytes = simFlush();
+		if(!simCheck())
+		{
+			printf("ОШИБКА: кадр не совпадает на секунде %u\n", second);
+			return 1;
+		}
+		if(second % 60 == 0)
+		{
+			sumMinute += bytes;
+			minuteUpdates++;
+			if(bytes > maxMinute) maxMinute = bytes;
+		}
+		else
+		{
+			sumSecond += bytes;
+			updates++;
+			if(bytes > maxSecond) maxSecond = bytes;
+		}
+	}
+
+	printf("Полный кадр: %lu байт (%lu мкс на 400 кГц)\n", (unsigned long)full, (unsigned long)(full * SIM_I2C_BITS * 1000000ul / OLED_I2C_SPEED));
+	printf("Смена секунды: в среднем %.1f байт, максимум %lu байт (%lu мкс)\n", updates ? (double)sumSecond / updates : 0.0,
+		   (unsigned long)maxSecond, (unsigned long)(maxSecond * SIM_I2C_BITS * 1000000ul / OLED_I2C_SPEED));
+	printf("Смена минуты: в среднем %.1f байт, максимум %lu байт (%lu мкс)\n", minuteUpdates ? (double)sumMinute / minuteUpdates : 0.0,
+		   (unsigned long)maxMinute, (unsigned long)(maxMinute * SIM_I2C_BITS * 1000000ul / OLED_I2C_SPEED));
+	printf("Память модели совпадает с кадром после всех %u обновлений\n", total);
+	return 0;
+}
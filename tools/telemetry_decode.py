@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+# -*- coding: cp1251 -*-
+"""
+Декодер двоичной телеметрии часов (кадры COBS + CRC-16/CCITT, разделитель 0x00)
+
+Источник - последовательный порт (требуется pyserial) или файл с записью потока (например, вывод симуляции).
+Запуск: python tools/telemetry_decode.py COM3 [скорость]  |  python tools/telemetry_decode.py --file запись.bin
+Текстовые ответы консоли между кадрами отбрасываются (не проходят проверку CRC).
+"""
+import struct
+import sys
+
+import trace_decode
+
+TYPE_STATUS = 1
+TYPE_TRACE = 2
+TYPE_METRICS = 3
+
+# Формат кадра состояния (после типа и номера), младший байт вперед
+STATUS_FORMAT = "<IhBBBBBIIHHHHHHHHHHH"
+STATUS_FIELDS = ("utc", "offset_min", "alarm_hours", "alarm_minutes", "alarm_flags", "alarm_state", "alarm_stage",
+				 "tim3_updates", "tim3_phases", "exti4", "exti9_5",
+				 "fires", "snoozes", "dismisses", "timeouts",
+				 "console_frames", "console_lines", "rx_overflows", "tx_overflows", "telemetry_dropped")
+
+# Реестр метрик в порядке METRICS_LIST (metrics.h): имя и признак счетчика (у счетчиков выводится прирост между кадрами)
+METRICS = (("ticks", True), ("ticksMissed", True), ("buttonIncrement", True), ("buttonClock", True), ("buttonAlarm", True),
+		   ("bounces", True), ("alarmFires", True), ("queueOverflows", True), ("isrCount", True), ("isrCycles", True),
+		   ("isrMaxCycles", False), ("awake", False))
+previous_metrics = {}
+
+
+def crc16(data):
+	crc = 0xFFFF
+	for byte in data:
+		crc ^= byte << 8
+		for _ in range(8):
+			crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+			crc &= 0xFFFF
+	return crc
+
+
+def cobs_decode(data):
+	out = bytearray()
+	i = 0
+	while i < len(data):
+		code = data[i]
+		if code == 0 or i + code > len(data):
+			return None
+		out += data[i + 1:i + code]
+		i += code
+		if code < 0xFF and i < len(data):
+			out.append(0)
+	return bytes(out)
+
+
+def decode_frame(raw):
+	"""Возвращает (тип, номер, данные) или None при ошибке"""
+	data = cobs_decode(raw)
+	if data is None or len(data) < 4:
+		return None
+	if crc16(data[:-2]) != struct.unpack(">H", data[-2:])[0]:
+		return None
+	return data[0], data[1], data[2:-2]
+
+
+def format_frame(kind, sequence, payload):
+	if kind == TYPE_STATUS and len(payload) >= struct.calcsize(STATUS_FORMAT):
+		values = dict(zip(STATUS_FIELDS, struct.unpack_from(STATUS_FORMAT, payload)))
+		return "#%03d " % sequence + " ".join("%s=%d" % (k, v) for k, v in values.items())
+	if kind == TYPE_METRICS and payload and len(payload) >= 1 + 4 * payload[0]:
+		return "#%03d metrics " % sequence + format_metrics(struct.unpack_from("<%dI" % payload[0], payload, 1))
+	if kind == TYPE_TRACE:
+		return "#%03d trace\n" % sequence + trace_decode.format_payload(payload)
+	return "#%03d type=%d %s" % (sequence, kind, payload.hex())
+
+
+def format_metrics(values):
+	fields = []
+	for index, value in enumerate(values):
+		name, counter = METRICS[index] if index < len(METRICS) else ("metric%d" % index, False)
+		if counter and name in previous_metrics:
+			fields.append("%s=%d(+%d)" % (name, value, (value - previous_metrics[name]) & 0xFFFFFFFF))
+		else:
+			fields.append("%s=%d" % (name, value))
+		previous_metrics[name] = value
+	return " ".join(fields)
+
+
+def frames(chunks):
+	"""Разбиение потока на кадры по разделителю 0x00"""
+	buffer = bytearray()
+	for chunk in chunks:
+		buffer += chunk
+		while True:
+			end = buffer.find(0)
+			if end < 0:
+				break
+			yield bytes(buffer[:end])
+			del buffer[:end + 1]
+
+
+def main():
+	if len(sys.argv) < 2:
+		print(__doc__)
+		return 1
+	if sys.argv[1] == "--file":
+		with open(sys.argv[2], "rb") as f:
+			source = iter(lambda: f.read(4096), b"")
+			return run(source)
+	import serial
+	port = serial.Serial(sys.argv[1], int(sys.argv[2]) if len(sys.argv) > 2 else 115200, timeout=1)
+	return run(iter(lambda: port.read(256), None))
+
+
+def run(source):
+	errors = 0
+	for raw in frames(source):
+		frame = decode_frame(raw)
+		if frame is None:
+			errors += 1
+			continue
+		print(format_frame(*frame))
+	print("errors: %d" % errors, file=sys.stderr)
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
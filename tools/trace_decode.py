@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+# -*- coding: cp1251 -*-
+"""
+Декодер журнала трассировки (trace.h)
+
+Данные части журнала: UTC и время журнала на момент вычитывания (uint32, единицы 10 мс), время записи перед первой,
+далее записи: байт события (код << 4 | параметр) и интервал от предыдущей записи - varint по 7 бит, младшие вперед.
+Источник - строки "trace <hex>" из вывода консоли (команда trace) или кадры телеметрии типа 2
+(tools/telemetry_decode.py использует этот модуль).
+Запуск: python tools/trace_decode.py запись_консоли.txt  |  ... | python tools/trace_decode.py
+"""
+import struct
+import sys
+import time
+
+CODES = ("mark", "button", "mode", "alarm", "clock", "time", "overrun")
+ARGS = {
+	"button": ("increment", "clock_set", "alarm_set"),
+	"mode": ("normal", "clock_setting", "alarm_setting"),
+	"alarm": ("fire", "dismiss", "snooze", "timeout"),
+	"clock": ("hse", "hsi_pll", "hsi"),
+	"time": ("user", "sync"),
+	"overrun": ("buttons", "console", "display", "store", "settings", "telemetry", "clock"),
+}
+
+
+def decode(payload):
+	"""Возвращает (utc, время журнала на момент вычитывания, [(время, код, параметр), ...]); None при ошибке"""
+	if len(payload) < 12:
+		return None
+	utc, now, ticks = struct.unpack_from("<III", payload)
+	events = []
+	i = 12
+	while i < len(payload):
+		code, arg = payload[i] >> 4, payload[i] & 0x0F
+		delta, shift = 0, 0
+		while True:
+			i += 1
+			if i >= len(payload):
+				return None
+			delta |= (payload[i] & 0x7F) << shift
+			shift += 7
+			if not payload[i] & 0x80:
+				break
+		i += 1
+		ticks = (ticks + delta) & 0xFFFFFFFF
+		events.append((ticks, code, arg))
+	return utc, now, events
+
+
+def format_event(utc, now, event):
+	ticks, code, arg = event
+	name = CODES[code] if code < len(CODES) else "code%d" % code
+	names = ARGS.get(name, ())
+	moment = utc - (now - ticks) / 100.0							# Время журнала отсчитывается от запуска, привязка - по UTC вычитывания
+	return "%s.%02d UTC  +%d.%02ds  %s %s" % (time.strftime("%Y-%m-%d %H:%M:%S", time.gmtime(int(moment))), int(moment * 100) % 100,
+											   ticks // 100, ticks % 100, name, names[arg] if arg < len(names) else arg)
+
+
+def format_payload(payload):
+	result = decode(payload)
+	if result is None:
+		return "trace: error " + payload.hex()
+	utc, now, events = result
+	return "\n".join(format_event(utc, now, event) for event in events) if events else "trace: empty"
+
+
+def main():
+	source = open(sys.argv[1], encoding="ascii", errors="replace") if len(sys.argv) > 1 else sys.stdin
+	for line in source:
+		words = line.split()
+		if len(words) == 2 and words[0] == "trace":
+			try:
+				payload = bytes.fromhex(words[1])
+			except ValueError:
+				continue
+			print(format_payload(payload))
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+# -*- coding: cp1251 -*-
+"""
+Генератор таблицы переходов на летнее/зимнее время (tz_table.c, tz_table.h)
+
+Для каждого часового пояса по правилам перехода вычисляются моменты переходов (UTC, секунды от 01.01.1970)
+и смещение после перехода в 15-минутных интервалах. Запуск: python tools/tz_gen.py (из корня проекта)
+"""
+import calendar
+import datetime
+
+FIRST_YEAR = 2020
+LAST_YEAR = 2105		# 32-битный счетчик секунд переполняется 07.02.2106
+
+
+def nth_sunday(year, month, n):
+	"""n-е воскресенье месяца (n = -1 - последнее)"""
+	days = [d for d in range(1, calendar.monthrange(year, month)[1] + 1)
+			if datetime.date(year, month, d).weekday() == 6]
+	return days[n] if n < 0 else days[n - 1]
+
+
+def utc_seconds(year, month, day, hour_utc):
+	return calendar.timegm((year, month, day, 0, 0, 0)) + int(hour_utc * 3600)
+
+
+def eu_rule(std_hours):
+	"""ЕС: последнее воскресенье марта и октября в 01:00 UTC"""
+	def rule(year):
+		return [(utc_seconds(year, 3, nth_sunday(year, 3, -1), 1), std_hours + 1),
+				(utc_seconds(year, 10, nth_sunday(year, 10, -1), 1), std_hours)]
+	return rule
+
+
+def us_rule(std_hours):
+	"""США: второе воскресенье марта 02:00 (зимнее) и первое воскресенье ноября 02:00 (летнее)"""
+	def rule(year):
+		return [(utc_seconds(year, 3, nth_sunday(year, 3, 2), 2 - std_hours), std_hours + 1),
+				(utc_seconds(year, 11, nth_sunday(year, 11, 1), 2 - (std_hours + 1)), std_hours)]
+	return rule
+
+
+# (идентификатор, имя, смещение зимнего времени в часах, правило перехода)
+ZONES = [
+	("TZ_UTC", "UTC", 0, None),
+	("TZ_EUROPE_MOSCOW", "MSK", 3, None),
+	("TZ_EUROPE_BERLIN", "CET", 1, eu_rule(1)),
+	("TZ_AMERICA_NEW_YORK", "EST", -5, us_rule(-5)),
+]
+
+
+def quarters(hours):
+	return int(round(hours * 4))
+
+
+def main():
+	header = []
+	source = []
+
+	header.append("/* Файл сгенерирован tools/tz_gen.py, не редактировать вручную */")
+	header.append("#ifndef TZ_TABLE_H")
+	header.append("#define TZ_TABLE_H")
+	header.append("")
+	header.append("enum tz_id_tag{		// Идентификаторы часовых поясов таблицы tzZones")
+	for ident, _, _, _ in ZONES:
+		header.append("\t%s," % ident)
+	header.append("\tTZ_COUNT")
+	header.append("};")
+	header.append("")
+	header.append("#endif /* TZ_TABLE_H */")
+
+	source.append("/* Файл сгенерирован tools/tz_gen.py, не редактировать вручную (%d...%d) */" % (FIRST_YEAR, LAST_YEAR))
+	source.append('#include "timezone.h"')
+	source.append("")
+	for ident, _, std, rule in ZONES:
+		if rule is None:
+			continue
+		transitions = []
+		for year in range(FIRST_YEAR, LAST_YEAR + 1):
+			transitions += rule(year)
+		transitions = [t for t in transitions if t[0] < 2 ** 32]
+		name = ident.lower()
+		source.append("static const uint32_t %s_utc[%d] = {" % (name, len(transitions)))
+		for i in range(0, len(transitions), 6):
+			source.append("\t" + ", ".join("%du" % t[0] for t in transitions[i:i + 6]) + ",")
+		source.append("};")
+		source.append("static const int8_t %s_offset[%d] = {" % (name, len(transitions)))
+		for i in range(0, len(transitions), 16):
+			source.append("\t" + ", ".join("%d" % quarters(t[1]) for t in transitions[i:i + 16]) + ",")
+		source.append("};")
+		source.append("")
+	source.append("const tz_zone tzZones[TZ_COUNT] = {")
+	for ident, abbr, std, rule in ZONES:
+		if rule is None:
+			source.append('\t{"%s", %d, 0, 0, 0},' % (abbr, quarters(std)))
+		else:
+			name = ident.lower()
+			source.append('\t{"%s", %d, sizeof(%s_offset), %s_utc, %s_offset},' % (abbr, quarters(std), name, name, name))
+	source.append("};")
+
+	with open("tz_table.h", "w", encoding="cp1251", newline="\n") as f:
+		f.write("\n".join(header) + "\n")
+	with open("tz_table.c", "w", encoding="cp1251", newline="\n") as f:
+		f.write("\n".join(source) + "\n")
+
+
+if __name__ == "__main__":
+	main()
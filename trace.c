@@ -0,0 +1,126 @@
+#include "stm32f10x.h"
+#include "trace.h"
+#include "metrics.h"
+
+#define TRACE_TIME_MASK 		((1ul << TRACE_TIME_BITS) - 1ul)
+#define TRACE_POSITION_MASK 	((1ul << (32 - TRACE_TIME_BITS)) - 1ul)	// Позиция считается по модулю больше буфера: полный буфер отличается от пустого
+
+#if TRACE_SIZE > (TRACE_POSITION_MASK + 1ul) / 2 || (TRACE_SIZE & (TRACE_SIZE - 1u))
+#error "TRACE_SIZE must be a power of two not larger than half of the position range"
+#endif
+
+trace_stats traceStats;
+
+static uint8_t buffer[TRACE_SIZE];
+static volatile uint32_t traceState;	// [31:TRACE_TIME_BITS] позиция следующей записи, [TRACE_TIME_BITS-1:0] время последней записи
+static volatile uint16_t tail;			// Позиция первой невычитанной записи (изменяется только основным циклом)
+static uint32_t tailTime;				// Полное время записи перед tail
+
+/* Атомарное увеличение счетчика (счетчики изменяются из прерываний разных приоритетов) */
+static void traceCount(volatile uint32_t *p_counter)
+{
+	do
+	{
+		(void)__LDREXW(p_counter);
+	} while(__STREXW(*p_counter + 1ul, p_counter));
+}
+
+/*
+*	Добавление события: время читается внутри LDREX/STREX, поэтому вытеснившее добавление (вход и выход из прерывания
+*	снимают монитор) приводит к повтору с новым временем и позицией. Время, ушедшее назад (перевод счетчика TIM3
+*	при синхронизации), считается нулевым интервалом. Байты записываются в занятое место после успешной STREX
+*/
+void traceEvent(uint8_t code, uint8_t arg)
+{
+	uint8_t record[TRACE_RECORD_MAX];
+	uint32_t state, now, delta, position;
+	uint8_t length, i;
+
+	do
+	{
+		state = __LDREXW(&traceState);
+		now = traceTicks() & TRACE_TIME_MASK;
+		delta = (now - state) & TRACE_TIME_MASK;
+		if(delta > TRACE_TIME_MASK / 2)
+		{
+			delta = 0;
+			now = state & TRACE_TIME_MASK;
+		}
+		record[0] = (uint8_t)((code << 4) | (arg & 0x0F));
+		for(length = 1; delta >= 0x80; length++)
+		{
+			record[length] = (uint8_t)(delta | 0x80);
+			delta >>= 7;
+		}
+		record[length++] = (uint8_t)delta;
+		position = state >> TRACE_TIME_BITS;
+		if(((position - tail) & TRACE_POSITION_MASK) + length > TRACE_SIZE)
+		{
+			__CLREX();
+			traceCount(&traceStats.lost);
+			METRIC_ADD(queueOverflows, 1);
+			return;
+		}
+	} while(__STREXW((((position + length) & TRACE_POSITION_MASK) << TRACE_TIME_BITS) | now, &traceState));
+
+	for(i = 0; i < length; i++)
+	{
+		buffer[(position + i) & (TRACE_SIZE - 1u)] = record[i];
+	}
+	traceCount(&traceStats.events);
+}
+
+/* Метка времени, если событий не было TRACE_MARK_TICKS: интервал следующей записи не превысит половины диапазона времени */
+void traceSecond(void)
+{
+	uint32_t state = traceState;
+
+	traceStats.used = (uint16_t)(((state >> TRACE_TIME_BITS) - tail) & TRACE_POSITION_MASK);
+	if(((traceTicks() - state) & TRACE_TIME_MASK) >= TRACE_MARK_TICKS)
+	{
+		traceEvent(TRACE_MARK, 0);
+	}
+}
+
+/*
+*	Вычитывание целых записей в p_data (не более size байт); возвращает число байт
+*	Записи, занятые вытесненным добавлением, но еще не заполненные, возможны только внутри прерываний - основной цикл их не видит
+*/
+uint8_t traceDrain(uint8_t *p_data, uint8_t size, uint32_t *p_base)
+{
+	uint32_t position = traceState >> TRACE_TIME_BITS;
+	uint32_t delta;
+	uint16_t from = tail;
+	uint8_t length = 0, record, shift;
+
+	*p_base = tailTime;
+	while(from != position)
+	{
+		delta = 0;
+		shift = 0;
+		for(record = 1; ; record++)
+		{
+			delta |= (uint32_t)(buffer[(from + record) & (TRACE_SIZE - 1u)] & 0x7F) << shift;
+			shift += 7;
+			if(!(buffer[(from + record) & (TRACE_SIZE - 1u)] & 0x80))
+			{
+				break;
+			}
+		}
+		record++;
+		if(length + record > size)
+		{
+			break;
+		}
+		while(record--)
+		{
+			p_data[length++] = buffer[from & (TRACE_SIZE - 1u)];
+			from = (uint16_t)((from + 1u) & TRACE_POSITION_MASK);
+		}
+		tailTime += delta;
+	}
+	tail = from;
+	traceStats.used = (uint16_t)((position - from) & TRACE_POSITION_MASK);
+	traceStats.drained += length;
+	return length;
+}
@@ -0,0 +1,49 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+/*
+*	Журнал трассировки событий в ОЗУ
+*	Запись: байт события (код в старшей тетраде, параметр в младшей) и интервал от предыдущей записи -
+*	varint по 7 бит, младшие разряды вперед (интервал до 1,27 с - 1 байт). Время - монотонный счетчик приложения
+*	в единицах 10 мс; в состоянии журнала хранятся только младшие TRACE_TIME_BITS бит времени последней записи,
+*	поэтому при долгой тишине из прерывания TIM3 добавляется метка (TRACE_MARK), чтобы интервал не переполнялся.
+*	Добавление без блокировок (LDREX/STREX): место и время записи занимаются одной атомарной операцией,
+*	при вытеснении другим добавлением попытка повторяется. Журнал нулевой инициализации готов к работе
+*	(записи возможны до запуска периферии). При заполнении новые события отбрасываются до вычитывания.
+*	Декодер: tools/trace_decode.py
+*/
+
+#define TRACE_SIZE 			2048u		// Размер буфера (степень двойки, не более 2^(32 - TRACE_TIME_BITS - 1))
+#define TRACE_TIME_BITS 	20			// Разрядность времени в состоянии журнала (2^20 * 10 мс - 2,9 ч)
+#define TRACE_MARK_TICKS 	(1ul << 18)	// Интервал метки при отсутствии событий (43 мин)
+#define TRACE_RECORD_MAX 	4			// Наибольшая длина записи (байт события и интервал до 21 бита)
+
+typedef enum trace_code_tag{	// Коды событий (параметр - младшая тетрада)
+	TRACE_MARK,					// Метка времени при долгом отсутствии событий
+	TRACE_BUTTON,				// Нажатие кнопки (0 - инкремент, 1 - настройка часов, 2 - настройка будильника)
+	TRACE_MODE,					// Режим (0 - обычный, 1 - настройка часов, 2 - настройка будильника)
+	TRACE_ALARM,				// Сигнал тревоги (0 - срабатывание, 1 - отключение, 2 - откладывание, 3 - завершение по таймауту)
+	TRACE_CLOCK,				// Смена источника тактирования (clock_source)
+	TRACE_TIME,					// Установка времени (0 - пользователем, 1 - синхронизация GPS/CAN)
+	TRACE_OVERRUN,				// Задача превысила бюджет (номер задачи планировщика)
+} trace_code;
+
+typedef struct trace_stats_tag{	// Статистика журнала
+	uint32_t events;			// Событий записано
+	uint32_t lost;				// Событий отброшено (буфер заполнен)
+	uint32_t drained;			// Байт вычитано
+	uint16_t used;				// Занято в буфере (байт)
+} trace_stats;
+
+extern trace_stats traceStats;
+
+void traceEvent(uint8_t code, uint8_t arg);							// Добавление события (из любого контекста, включая NMI)
+void traceSecond(void);												// Метка при долгом отсутствии событий (из прерывания TIM3)
+uint8_t traceDrain(uint8_t *p_data, uint8_t size, uint32_t *p_base);	// Вычитывание целых записей (только основной цикл); p_base - время записи перед первой
+
+/* Реализуется приложением */
+uint32_t traceTicks(void);											// Монотонное время (единицы 10 мс)
+
+#endif /* TRACE_H */
@@ -0,0 +1,99 @@
+/* Файл сгенерирован tools/tz_gen.py, не редактировать вручную (2020...2105) */
+#include "timezone.h"
+
+static const uint32_t tz_europe_berlin_utc[172] = {
+	1585443600u, 1603587600u, 1616893200u, 1635642000u, 1648342800u, 1667091600u,
+	1679792400u, 1698541200u, 1711846800u, 1729990800u, 1743296400u, 1761440400u,
+	1774746000u, 1792890000u, 1806195600u, 1824944400u, 1837645200u, 1856394000u,
+	1869094800u, 1887843600u, 1901149200u, 1919293200u, 1932598800u, 1950742800u,
+	1964048400u, 1982797200u, 1995498000u, 2014246800u, 2026947600u, 2045696400u,
+	2058397200u, 2077146000u, 2090451600u, 2108595600u, 2121901200u, 2140045200u,
+	2153350800u, 2172099600u, 2184800400u, 2203549200u, 2216250000u, 2234998800u,
+	2248304400u, 2266448400u, 2279754000u, 2297898000u, 2311203600u, 2329347600u,
+	2342653200u, 2361402000u, 2374102800u, 2392851600u, 2405552400u, 2424301200u,
+	2437606800u, 2455750800u, 2469056400u, 2487200400u, 2500506000u, 2519254800u,
+	2531955600u, 2550704400u, 2563405200u, 2582154000u, 2595459600u, 2613603600u,
+	2626909200u, 2645053200u, 2658358800u, 2676502800u, 2689808400u, 2708557200u,
+	2721258000u, 2740006800u, 2752707600u, 2771456400u, 2784762000u, 2802906000u,
+	2816211600u, 2834355600u, 2847661200u, 2866410000u, 2879110800u, 2897859600u,
+	2910560400u, 2929309200u, 2942010000u, 2960758800u, 2974064400u, 2992208400u,
+	3005514000u, 3023658000u, 3036963600u, 3055712400u, 3068413200u, 3087162000u,
+	3099862800u, 3118611600u, 3131917200u, 3150061200u, 3163366800u, 3181510800u,
+	3194816400u, 3212960400u, 3226266000u, 3245014800u, 3257715600u, 3276464400u,
+	3289165200u, 3307914000u, 3321219600u, 3339363600u, 3352669200u, 3370813200u,
+	3384118800u, 3402867600u, 3415568400u, 3434317200u, 3447018000u, 3465766800u,
+	3479072400u, 3497216400u, 3510522000u, 3528666000u, 3541971600u, 3560115600u,
+	3573421200u, 3592170000u, 3604870800u, 3623619600u, 3636320400u, 3655069200u,
+	3668374800u, 3686518800u, 3699824400u, 3717968400u, 3731274000u, 3750022800u,
+	3762723600u, 3781472400u, 3794173200u, 3812922000u, 3825622800u, 3844371600u,
+	3857677200u, 3875821200u, 3889126800u, 3907270800u, 3920576400u, 3939325200u,
+	3952026000u, 3970774800u, 3983475600u, 4002224400u, 4015530000u, 4033674000u,
+	4046979600u, 4065123600u, 4078429200u, 4096573200u, 4109878800u, 4128627600u,
+	4141328400u, 4160077200u, 4172778000u, 4191526800u, 4204227600u, 4222976400u,
+	4236282000u, 4254426000u, 4267731600u, 4285875600u,
+};
+static const int8_t tz_europe_berlin_offset[172] = {
+	8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4,
+	8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4,
+	8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4,
+	8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4,
+	8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4,
+	8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4,
+	8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4,
+	8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4,
+	8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4,
+	8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4,
+	8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4,
+};
+
+static const uint32_t tz_america_new_york_utc[172] = {
+	1583650800u, 1604210400u, 1615705200u, 1636264800u, 1647154800u, 1667714400u,
+	1678604400u, 1699164000u, 1710054000u, 1730613600u, 1741503600u, 1762063200u,
+	1772953200u, 1793512800u, 1805007600u, 1825567200u, 1836457200u, 1857016800u,
+	1867906800u, 1888466400u, 1899356400u, 1919916000u, 1930806000u, 1951365600u,
+	1962860400u, 1983420000u, 1994310000u, 2014869600u, 2025759600u, 2046319200u,
+	2057209200u, 2077768800u, 2088658800u, 2109218400u, 2120108400u, 2140668000u,
+	2152162800u, 2172722400u, 2183612400u, 2204172000u, 2215062000u, 2235621600u,
+	2246511600u, 2267071200u, 2277961200u, 2298520800u, 2309410800u, 2329970400u,
+	2341465200u, 2362024800u, 2372914800u, 2393474400u, 2404364400u, 2424924000u,
+	2435814000u, 2456373600u, 2467263600u, 2487823200u, 2499318000u, 2519877600u,
+	2530767600u, 2551327200u, 2562217200u, 2582776800u, 2593666800u, 2614226400u,
+	2625116400u, 2645676000u, 2656566000u, 2677125600u, 2688620400u, 2709180000u,
+	2720070000u, 2740629600u, 2751519600u, 2772079200u, 2782969200u, 2803528800u,
+	2814418800u, 2834978400u, 2846473200u, 2867032800u, 2877922800u, 2898482400u,
+	2909372400u, 2929932000u, 2940822000u, 2961381600u, 2972271600u, 2992831200u,
+	3003721200u, 3024280800u, 3035775600u, 3056335200u, 3067225200u, 3087784800u,
+	3098674800u, 3119234400u, 3130124400u, 3150684000u, 3161574000u, 3182133600u,
+	3193023600u, 3213583200u, 3225078000u, 3245637600u, 3256527600u, 3277087200u,
+	3287977200u, 3308536800u, 3319426800u, 3339986400u, 3350876400u, 3371436000u,
+	3382930800u, 3403490400u, 3414380400u, 3434940000u, 3445830000u, 3466389600u,
+	3477279600u, 3497839200u, 3508729200u, 3529288800u, 3540178800u, 3560738400u,
+	3572233200u, 3592792800u, 3603682800u, 3624242400u, 3635132400u, 3655692000u,
+	3666582000u, 3687141600u, 3698031600u, 3718591200u, 3730086000u, 3750645600u,
+	3761535600u, 3782095200u, 3792985200u, 3813544800u, 3824434800u, 3844994400u,
+	3855884400u, 3876444000u, 3887334000u, 3907893600u, 3919388400u, 3939948000u,
+	3950838000u, 3971397600u, 3982287600u, 4002847200u, 4013737200u, 4034296800u,
+	4045186800u, 4065746400u, 4076636400u, 4097196000u, 4108690800u, 4129250400u,
+	4140140400u, 4160700000u, 4171590000u, 4192149600u, 4203039600u, 4223599200u,
+	4234489200u, 4255048800u, 4265938800u, 4286498400u,
+};
+static const int8_t tz_america_new_york_offset[172] = {
+	-16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20,
+	-16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20,
+	-16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20,
+	-16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20,
+	-16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20,
+	-16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20,
+	-16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20,
+	-16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20,
+	-16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20,
+	-16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20,
+	-16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20,
+};
+
+const tz_zone tzZones[TZ_COUNT] = {
+	{"UTC", 0, 0, 0, 0},
+	{"MSK", 12, 0, 0, 0},
+	{"CET", 4, sizeof(tz_europe_berlin_offset), tz_europe_berlin_utc, tz_europe_berlin_offset},
+	{"EST", -20, sizeof(tz_america_new_york_offset), tz_america_new_york_utc, tz_america_new_york_offset},
+};
@@ -0,0 +1,13 @@
+/* Файл сгенерирован tools/tz_gen.py, не редактировать вручную */
+#ifndef TZ_TABLE_H
+#define TZ_TABLE_H
+
+enum tz_id_tag{		// Идентификаторы часовых поясов таблицы tzZones
+	TZ_UTC,
+	TZ_EUROPE_MOSCOW,
+	TZ_EUROPE_BERLIN,
+	TZ_AMERICA_NEW_YORK,
+	TZ_COUNT
+};
+
+#endif /* TZ_TABLE_H */